@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+// anim.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "anim.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// anim_a.s
+////////////////////////////////////////////////////////////////////////////////
+extern "C" void Anim_Apply(const u8* delta, u8* planes, u32 planeSize, u32 rowBytes);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u8* Anim_Delta(const AnimPlayer& player, u32 offset)
+{
+	return (const u8*) player.header + offset;
+}
+
+static u32 Anim_DeltaSize(const u8* delta)
+{
+	return *(const u32*) delta;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Anim_Begin(AnimPlayer& player, const void* anim)
+{
+	static_assert(sizeof(AnimHeader) == kAnimHeaderSize);
+
+	player.header = (const AnimHeader*) anim;
+	player.next = Anim_Delta(player, kAnimHeaderSize);
+	player.next += Anim_DeltaSize(player.next);
+	player.delta = 1;
+	player.frame = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Anim_Key(const AnimPlayer& player, u8* planes, u32 planeSize)
+{
+	Anim_Apply(Anim_Delta(player, kAnimHeaderSize), planes, planeSize, player.header->width / 8);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int Anim_Next(AnimPlayer& player, u8* planes, u32 planeSize)
+{
+	const AnimHeader& header = *player.header;
+	int frame = (player.frame < header.frames) ? player.frame : 0;
+
+	Anim_Apply(player.next, planes, planeSize, header.width / 8);
+
+	if (++player.delta < header.deltas)
+	{
+		player.next += Anim_DeltaSize(player.next);
+	}
+	else
+	{
+		player.delta = header.interleave;
+		player.next = Anim_Delta(player, header.loop);
+	}
+
+	player.frame = frame + 1;
+	return frame;
+}
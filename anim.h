@@ -0,0 +1,40 @@
+////////////////////////////////////////////////////////////////////////////////
+// anim.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "animref.h"
+#include "core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Player for delta animations written by hamconv -anim (see animref.h). Each
+// delta goes straight into the back buffer before it is queued, so the screen
+// has to draw into its interleave buffers strictly in turn, every one of them
+// starting out with the key frame: Anim_Key puts it into one buffer, which
+// must be cleared beforehand. Anim_Next then draws the next frame into the
+// back buffer and returns its number, looping at the end.
+////////////////////////////////////////////////////////////////////////////////
+struct AnimHeader
+{
+	u16 width;
+	u16 height;
+	u16 planes;
+	u16 frames;
+	u16 interleave;
+	u16 deltas;
+	u32 loop;
+	u16 palette[kAnimPaletteSize];
+};
+
+struct AnimPlayer
+{
+	const AnimHeader* header;
+	const u8* next;
+	int delta;
+	int frame;
+};
+
+void Anim_Begin(AnimPlayer& player, const void* anim);
+void Anim_Key(const AnimPlayer& player, u8* planes, u32 planeSize);
+int Anim_Next(AnimPlayer& player, u8* planes, u32 planeSize);
@@ -0,0 +1,77 @@
+/*
+ * anim_a.s
+ *
+ * Applies one delta of the format in animref.h. Stored words cost a move and
+ * an add each, 30 cycles a word going down a column; a skip costs the same
+ * whatever its length, being one mulu.
+ */
+
+/*
+ * void Anim_Apply(const u8* delta, u8* planes, u32 planeSize, u32 rowBytes)
+ *
+ * rowBytes must be below 0x8000.
+ */
+	.globl	Anim_Apply
+Anim_Apply:
+	moveml	d2-d7/a2-a4, sp@-
+	movel	sp@(40), a0		/* delta */
+	movel	sp@(44), a2		/* plane */
+	movel	sp@(48), d5		/* planeSize */
+	movel	sp@(52), d6		/* rowBytes */
+	addql	#4, a0
+	moveq	#0, d0
+	movew	a0@+, d0		/* op bytes */
+	movew	a0@+, d7		/* plane mask */
+	lea	a0@(0,d0:l), a1		/* words */
+	movew	d6, d2
+	lsrw	#1, d2
+	subqw	#1, d2			/* columns - 1 */
+	jra	.Lplanes
+
+.Lplane:
+	movel	a2, a3			/* column */
+	movew	d2, d4
+.Lcolumn:
+	movel	a3, a4			/* row */
+	moveq	#0, d3
+	moveb	a0@+, d3		/* op count */
+	jra	.Lnext
+
+.Lop:
+	moveq	#0, d0
+	moveb	a0@+, d0
+	jgt	.Lskip
+	jeq	.Lsame
+	subw	#0x81, d0		/* uniq */
+.Luniq:
+	movew	a1@+, a4@
+	addaw	d6, a4
+	dbra	d0, .Luniq
+.Lnext:
+	dbra	d3, .Lop
+	addql	#2, a3
+	dbra	d4, .Lcolumn
+.Lskipplane:
+	addal	d5, a2
+.Lplanes:
+	lsrw	#1, d7
+	jcs	.Lplane
+	jne	.Lskipplane
+
+	moveml	sp@+, d2-d7/a2-a4
+	rts
+
+.Lskip:
+	muluw	d6, d0
+	addal	d0, a4
+	jra	.Lnext
+
+.Lsame:
+	moveb	a0@+, d0
+	subqw	#1, d0
+	movew	a1@+, d1
+.Lsame1:
+	movew	d1, a4@
+	addaw	d6, a4
+	dbra	d0, .Lsame1
+	jra	.Lnext
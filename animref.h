@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+// animref.h
+//
+// The delta animation format, shared by the 68000 player in anim_a.s and
+// hamconv -anim, with a portable reference for applying a delta. It follows
+// IFF ANIM method 7: planar frames, where a delta is a list of vertical ops
+// per word column of every plane that changed, with the opcodes and the words
+// they store in two separate lists so the words stay aligned. An animation
+// is a header of kAnimHeaderSize bytes, all of it big endian words,
+//
+//   width, height, planes, frames, interleave, deltas
+//   loop          long, byte offset of the delta that follows the last one
+//   palette       kAnimPaletteSize 0x0rgb words
+//
+// then the deltas, each
+//
+//   size          long, bytes in the delta including these 8
+//   op bytes      word, even
+//   plane mask    word, bit p set when plane p has ops
+//   ops           for every column of every plane in the mask, an op count
+//                 byte and that many ops, padded to op bytes
+//   words         the data of the ops, in the same order
+//
+// with the ops, rows being the words of a column:
+//
+//   0x01-0x7f     skip n rows
+//   0x80 | n      store the next n words, one per row
+//   0x00, n       store the next word in n rows
+//
+// Delta 0 is the key frame, against cleared planes. After it, delta k holds
+// frame k % frames and goes on top of the frame shown interleave deltas
+// earlier, or on top of the key frame for k < interleave: a player draws into
+// interleave buffers in turn, each starting with the key frame. Delta
+// frames + interleave - 1 is the last one; playing on from delta interleave
+// loops, as that one goes on top of frame 0.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kAnimPaletteSize	= 16;
+static const int kAnimHeaderSize	= 16 + kAnimPaletteSize * 2;
+static const int kAnimDeltaHeader	= 8;
+static const int kAnimMaxSkip		= 0x7f;
+static const int kAnimMaxUniq		= 0x7f;
+static const int kAnimMaxSame		= 0xff;
+static const int kAnimMaxOps		= 0xff;
+
+////////////////////////////////////////////////////////////////////////////////
+// Header fields as word offsets.
+////////////////////////////////////////////////////////////////////////////////
+enum AnimField
+{
+	kAnimWidth,
+	kAnimHeight,
+	kAnimPlanes,
+	kAnimFrames,
+	kAnimInterleave,
+	kAnimDeltas,
+	kAnimLoop,
+	kAnimPalette = kAnimLoop + 2,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline unsigned int Anim_ReferenceWord(const unsigned char* p)
+{
+	return ((unsigned int) p[0] << 8) | p[1];
+}
+
+inline unsigned int Anim_ReferenceLong(const unsigned char* p)
+{
+	return (Anim_ReferenceWord(p) << 16) | Anim_ReferenceWord(p + 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Applies one delta to planes, planeSize bytes apart with rows of rowBytes.
+////////////////////////////////////////////////////////////////////////////////
+inline void Anim_ReferenceApply(const unsigned char* delta, unsigned char* planes, unsigned int planeSize, unsigned int rowBytes)
+{
+	const unsigned char* op = delta + kAnimDeltaHeader;
+	const unsigned char* data = op + Anim_ReferenceWord(delta + 4);
+	unsigned int mask = Anim_ReferenceWord(delta + 6);
+
+	for (unsigned int p = 0; mask != 0; p++, mask >>= 1)
+	{
+		if ((mask & 1) == 0)
+		{
+			continue;
+		}
+
+		for (unsigned int column = 0; column < rowBytes / 2; column++)
+		{
+			unsigned char* row = planes + p * planeSize + column * 2;
+
+			for (int count = *op++; count > 0; count--)
+			{
+				int code = *op++;
+
+				if (code > 0 && code < 0x80)
+				{
+					row += code * rowBytes;
+				}
+				else
+				{
+					int n = (code == 0) ? *op++ : code & 0x7f;
+					bool same = (code == 0);
+
+					for (int i = 0; i < n; i++)
+					{
+						row[0] = data[0];
+						row[1] = data[1];
+						row += rowBytes;
+
+						if (!same)
+						{
+							data += 2;
+						}
+					}
+
+					if (same)
+					{
+						data += 2;
+					}
+				}
+			}
+		}
+	}
+}
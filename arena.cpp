@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+// arena.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "arena.h"
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct Arena
+{
+	u8* base;
+	u32 size;
+	u32 used;
+	u32 highWater;
+};
+
+static Arena sArenas[kArenaTypes];
+static bool sFastInChip;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Arena_Init()
+{
+	static const u32 kSizes[kArenaTypes] = {kArenaChipSize, kArenaFastSize};
+
+	void* chip = AllocMem(kArenaChipSize, MEMF_CHIP);
+	if (chip == nullptr)
+	{
+		return false;
+	}
+
+	void* fast = AllocMem(kArenaFastSize, MEMF_FAST);
+	sFastInChip = (fast == nullptr);
+
+	if (fast == nullptr)
+	{
+		fast = AllocMem(kArenaFastSize, MEMF_ANY);
+	}
+
+	if (fast == nullptr)
+	{
+		FreeMem(chip, kArenaChipSize);
+
+		return false;
+	}
+
+	sArenas[kArenaChip].base = (u8*) chip;
+	sArenas[kArenaFast].base = (u8*) fast;
+
+	for (int i = 0; i < kArenaTypes; i++)
+	{
+		sArenas[i].size = kSizes[i];
+		sArenas[i].used = 0;
+		sArenas[i].highWater = 0;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Arena_Deinit()
+{
+	static const char* const kNames[kArenaTypes] = {"chip", "fast"};
+
+	for (int i = 0; i < kArenaTypes; i++)
+	{
+		const Arena& arena = sArenas[i];
+
+		KPrintF("arena: %s %ld of %ld bytes used at most%s\n", kNames[i], arena.highWater, arena.size,
+			(i == kArenaFast && sFastInChip) ? ", in chip RAM" : "");
+
+		FreeMem(arena.base, arena.size);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void* Arena_Alloc(ArenaType type, u32 size, u32 align)
+{
+	assert(align != 0 && (align & (align - 1)) == 0);
+
+	Arena& arena = sArenas[type];
+	u32 start = alignup((u32) arena.base + arena.used, align) - (u32) arena.base;
+
+	if (start > arena.size || size > arena.size - start)
+	{
+		assert(false);
+		return nullptr;
+	}
+
+	arena.used = start + size;
+	arena.highWater = max(arena.highWater, arena.used);
+
+	return arena.base + start;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+ArenaMark Arena_Mark()
+{
+	ArenaMark mark;
+
+	for (int i = 0; i < kArenaTypes; i++)
+	{
+		mark.used[i] = sArenas[i].used;
+	}
+
+	return mark;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Arena_Reset(const ArenaMark& mark)
+{
+	for (int i = 0; i < kArenaTypes; i++)
+	{
+		assert(mark.used[i] <= sArenas[i].used);
+
+		sArenas[i].used = mark.used[i];
+	}
+}
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+// arena.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Bump allocators over one block of chip and one of fast RAM, taken by
+// System_Init and given back by System_Deinit, which also reports the most
+// each one ever had in use. Chip is for whatever DMA reads: bitplanes, copper
+// lists, anything the blitter works on. Fast is for what only the CPU
+// touches; without fast RAM that block comes from chip RAM as well, so such
+// buffers are merely slower.
+//
+// Nothing is freed on its own. Arena_Mark notes how far both arenas are and
+// Arena_Reset goes back there, freeing everything allocated since: an effect
+// marks when it starts and resets when it stops, and ArenaScope does the same
+// for a C++ scope. Memory is not cleared. Running out is a programming error
+// (sizes are fixed, so check them with static_assert against the sizes below),
+// caught by an assert in debug builds; otherwise Arena_Alloc returns nullptr.
+////////////////////////////////////////////////////////////////////////////////
+enum ArenaType
+{
+	kArenaChip,
+	kArenaFast,
+	kArenaTypes,
+};
+
+static const u32 kArenaChipSize	= 272 * 1024;
+static const u32 kArenaFastSize	= 64 * 1024;
+static const u32 kArenaAlign	= 4;
+
+struct ArenaMark
+{
+	u32 used[kArenaTypes];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Arena_Init();
+void Arena_Deinit();
+
+////////////////////////////////////////////////////////////////////////////////
+// align is a power of two. Arena_New is Arena_Alloc for count Ts.
+////////////////////////////////////////////////////////////////////////////////
+void* Arena_Alloc(ArenaType type, u32 size, u32 align = kArenaAlign);
+
+template<typename T> T* Arena_New(ArenaType type, u32 count = 1, u32 align = max((u32) alignof(T), kArenaAlign))
+{
+	return (T*) Arena_Alloc(type, count * sizeof(T), align);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+ArenaMark Arena_Mark();
+void Arena_Reset(const ArenaMark& mark);
+
+struct ArenaScope
+{
+	ArenaMark mark;
+
+	ArenaScope() : mark(Arena_Mark()) {}
+	~ArenaScope() { Arena_Reset(mark); }
+};
@@ -0,0 +1,321 @@
+////////////////////////////////////////////////////////////////////////////////
+// blitter.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "blitter.h"
+#include <hardware/blit.h>
+#include <hardware/custom.h>
+#include <hardware/dmabits.h>
+#include <hardware/intbits.h>
+#include "system.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kBlitterJobs	= 32; // Power of two.
+static const u32 kFrameClocks	= 313 * 227;
+
+////////////////////////////////////////////////////////////////////////////////
+// sQueued, sStarted and sDone count jobs since Blitter_Init and only ever go
+// up; a fence is the value sDone has once its job is finished. The queue
+// holds the jobs from sStarted to sQueued, the blitter is idle when sStarted
+// equals sDone.
+////////////////////////////////////////////////////////////////////////////////
+static BlitterJob sJobs[kBlitterJobs];
+static volatile u32 sQueued;
+static volatile u32 sStarted;
+static volatile u32 sDone;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 sStartClock;
+static volatile u32 sStatsJobs;
+static volatile u32 sStatsBusy;
+static u32 sStatsWait;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Blitter_Clock()
+{
+	volatile u32* vpos = (u32*) &custom.vposr;
+
+	u32 vhpos = *vpos;
+	return (((vhpos >> 8) & 0x1ff) * 227 + (vhpos & 0xff));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Blitter_Since(u32 start)
+{
+	u32 now = Blitter_Clock();
+	return (now >= start) ? now - start : now + kFrameClocks - start;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u16 Blitter_Size(int words, int height)
+{
+	assert(words > 0 && words <= 64 && height > 0 && height <= 1024);
+
+	return (u16) (((height & 0x3ff) << 6) | (words & 0x3f));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Called with the blitter idle and the blitter interrupt masked or running.
+////////////////////////////////////////////////////////////////////////////////
+static void Blitter_Start()
+{
+	const BlitterJob& job = sJobs[sStarted & (kBlitterJobs - 1)];
+
+	custom.bltcon0 = job.bltcon0;
+	custom.bltcon1 = job.bltcon1;
+	custom.bltafwm = job.bltafwm;
+	custom.bltalwm = job.bltalwm;
+	custom.bltapt  = (void*) job.bltapt;
+	custom.bltbpt  = (void*) job.bltbpt;
+	custom.bltcpt  = (void*) job.bltcpt;
+	custom.bltdpt  = (void*) job.bltdpt;
+	custom.bltamod = job.bltamod;
+	custom.bltbmod = job.bltbmod;
+	custom.bltcmod = job.bltcmod;
+	custom.bltdmod = job.bltdmod;
+	custom.bltadat = job.bltadat;
+	custom.bltbdat = job.bltbdat;
+	custom.bltcdat = job.bltcdat;
+
+	sStartClock = Blitter_Clock();
+	sStarted = sStarted + 1;
+
+	custom.bltsize = job.bltsize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Blitter_Finished()
+{
+	// Not one of ours.
+	if (sDone == sStarted)
+	{
+		return;
+	}
+
+	sStatsBusy = sStatsBusy + Blitter_Since(sStartClock);
+	sStatsJobs = sStatsJobs + 1;
+	sDone = sDone + 1;
+
+	if (sStarted != sQueued)
+	{
+		Blitter_Start();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Blitter_Init()
+{
+	sQueued = 0;
+	sStarted = 0;
+	sDone = 0;
+
+	sStatsJobs = 0;
+	sStatsBusy = 0;
+	sStatsWait = 0;
+
+	System_WaitBlt();
+
+	custom.dmacon = DMAF_SETCLR | DMAF_BLITTER | DMAF_MASTER;
+	custom.intreq = INTF_BLIT;
+
+	System_SetIntHandler(INTB_BLIT, Blitter_Finished);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Blitter_Deinit()
+{
+	Blitter_Wait(Blitter_Fence());
+
+	System_SetIntHandler(INTB_BLIT, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Submit(const BlitterJob& job)
+{
+	if (sQueued - sDone >= kBlitterJobs)
+	{
+		Blitter_Wait(sQueued - kBlitterJobs + 1);
+	}
+
+	sJobs[sQueued & (kBlitterJobs - 1)] = job;
+
+	custom.intena = INTF_BLIT;
+
+	sQueued = sQueued + 1;
+
+	if (sStarted == sDone)
+	{
+		Blitter_Start();
+	}
+
+	custom.intena = INTF_SETCLR | INTF_BLIT;
+
+	return sQueued;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Clear(void* dst, int dstMod, int words, int height)
+{
+	BlitterJob job = {};
+	job.bltcon0 = BC0F_DEST;
+	job.bltdpt	= (u32) dst;
+	job.bltdmod = (u16) dstMod;
+	job.bltsize = Blitter_Size(words, height);
+
+	return Blitter_Submit(job);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Copy(void* dst, int dstMod, const void* src, int srcMod, int words, int height)
+{
+	BlitterJob job = {};
+	job.bltcon0 = BC0F_SRCA | BC0F_DEST | A_TO_D;
+	job.bltafwm = 0xffff;
+	job.bltalwm = 0xffff;
+	job.bltapt	= (u32) src;
+	job.bltdpt	= (u32) dst;
+	job.bltamod = (u16) srcMod;
+	job.bltdmod = (u16) dstMod;
+	job.bltsize = Blitter_Size(words, height);
+
+	return Blitter_Submit(job);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Fills run right to left, so the blit is descending from the last word.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Fill(void* dst, int dstMod, int words, int height, bool exclusive)
+{
+	u32 last = (u32) dst + (height - 1) * (words * 2 + dstMod) + words * 2 - 2;
+
+	BlitterJob job = {};
+	job.bltcon0 = BC0F_SRCA | BC0F_DEST | A_TO_D;
+	job.bltcon1 = BC1F_DESC | (exclusive ? FILL_XOR : FILL_OR);
+	job.bltafwm = 0xffff;
+	job.bltalwm = 0xffff;
+	job.bltapt	= last;
+	job.bltdpt	= last;
+	job.bltamod = (u16) dstMod;
+	job.bltdmod = (u16) dstMod;
+	job.bltsize = Blitter_Size(words, height);
+
+	return Blitter_Submit(job);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Line mode steps along the longer axis every pixel and along the shorter one
+// when the error term in bltapt goes positive. SUD picks x as the always step,
+// SUL and AUL make the sometimes and always steps go up or left.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Line(void* plane, int bytesPerRow, int x0, int y0, int x1, int y1, bool outline)
+{
+	int dx = x1 - x0;
+	int dy = y1 - y0;
+	int adx = (dx < 0) ? -dx : dx;
+	int ady = (dy < 0) ? -dy : dy;
+
+	u16 octant;
+	int dmax;
+	int dmin;
+
+	if (adx >= ady)
+	{
+		octant = SUD | ((dy < 0) ? SUL : 0) | ((dx < 0) ? AUL : 0);
+		dmax = adx;
+		dmin = ady;
+	}
+	else
+	{
+		octant = ((dx < 0) ? SUL : 0) | ((dy < 0) ? AUL : 0);
+		dmax = ady;
+		dmin = adx;
+	}
+
+	int error = 4 * dmin - 2 * dmax;
+	u32 start = (u32) plane + y0 * bytesPerRow + ((x0 >> 3) & ~1);
+
+	BlitterJob job = {};
+	job.bltcon0 = (u16) (((x0 & 15) << ASHIFTSHIFT) | BC0F_SRCA | BC0F_SRCC | BC0F_DEST | (outline ? (ABNC | NABC | NANBC) : (ABC | ABNC | NABC | NANBC)));
+	job.bltcon1 = (u16) (octant | LINEMODE | ((error < 0) ? SIGNFLAG : 0) | (outline ? ONEDOT : 0));
+	job.bltafwm = 0xffff;
+	job.bltalwm = 0xffff;
+	job.bltapt	= (u32) error;
+	job.bltcpt	= start;
+	job.bltdpt	= start;
+	job.bltamod = (u16) (4 * (dmin - dmax));
+	job.bltbmod = (u16) (4 * dmin);
+	job.bltcmod = (u16) bytesPerRow;
+	job.bltdmod = (u16) bytesPerRow;
+	job.bltadat = 0x8000;
+	job.bltbdat = 0xffff;
+	job.bltsize = Blitter_Size(2, dmax + 1);
+
+	return Blitter_Submit(job);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Fence()
+{
+	return sQueued;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Blitter_IsDone(BlitterFence fence)
+{
+	return ((s32) (sDone - fence) >= 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Blitter_Wait(BlitterFence fence)
+{
+	if (Blitter_IsDone(fence))
+	{
+		return;
+	}
+
+	u32 start = Blitter_Clock();
+
+	while (!Blitter_IsDone(fence)) {}
+
+	sStatsWait += Blitter_Since(start);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Blitter_GetStats(BlitterStats& stats)
+{
+	custom.intena = INTF_BLIT;
+
+	stats.jobs = sStatsJobs;
+	stats.busy = sStatsBusy;
+	stats.wait = sStatsWait;
+
+	custom.intena = INTF_SETCLR | INTF_BLIT;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Blitter_ResetStats()
+{
+	custom.intena = INTF_BLIT;
+
+	sStatsJobs = 0;
+	sStatsBusy = 0;
+	sStatsWait = 0;
+
+	custom.intena = INTF_SETCLR | INTF_BLIT;
+}
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+// blitter.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Blitter job queue. Jobs are started one after the other from the blitter
+// interrupt, so the calls below only queue and return. Every call returns a
+// fence that is done once that job and all before it have finished. Waiting
+// is only needed before the CPU touches memory a queued job reads or writes.
+////////////////////////////////////////////////////////////////////////////////
+typedef u32 BlitterFence;
+
+////////////////////////////////////////////////////////////////////////////////
+// Register values of one blit, written from bltcon0 down to bltsize.
+////////////////////////////////////////////////////////////////////////////////
+struct BlitterJob
+{
+	u16 bltcon0;
+	u16 bltcon1;
+	u16 bltafwm;
+	u16 bltalwm;
+	u32 bltapt;
+	u32 bltbpt;
+	u32 bltcpt;
+	u32 bltdpt;
+	u16 bltamod;
+	u16 bltbmod;
+	u16 bltcmod;
+	u16 bltdmod;
+	u16 bltadat;
+	u16 bltbdat;
+	u16 bltcdat;
+	u16 bltsize;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Time in colour clocks, measured off the beam, so jobs and waits are assumed
+// to be shorter than a frame. busy - wait is how long the blitter ran while
+// the CPU got on with something else.
+////////////////////////////////////////////////////////////////////////////////
+struct BlitterStats
+{
+	u32 jobs;
+	u32 busy;
+	u32 wait;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Blitter_Init();
+void Blitter_Deinit();
+
+////////////////////////////////////////////////////////////////////////////////
+// Waits when the queue is full. words and height are at most 64 and 1024.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Submit(const BlitterJob& job);
+BlitterFence Blitter_Clear(void* dst, int dstMod, int words, int height);
+BlitterFence Blitter_Copy(void* dst, int dstMod, const void* src, int srcMod, int words, int height);
+
+////////////////////////////////////////////////////////////////////////////////
+// Area fill of a words x height block whose outlines were drawn with outline
+// set, inclusive or exclusive.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Fill(void* dst, int dstMod, int words, int height, bool exclusive);
+
+////////////////////////////////////////////////////////////////////////////////
+// Line into a plane of bytesPerRow. outline xors in one pixel per line, the
+// edges Blitter_Fill expects.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Line(void* plane, int bytesPerRow, int x0, int y0, int x1, int y1, bool outline);
+
+////////////////////////////////////////////////////////////////////////////////
+// Blitter_Fence covers everything queued so far.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Blitter_Fence();
+bool Blitter_IsDone(BlitterFence fence);
+void Blitter_Wait(BlitterFence fence);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Blitter_GetStats(BlitterStats& stats);
+void Blitter_ResetStats();
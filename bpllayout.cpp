@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+// bpllayout.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bpllayout.h"
+#include "system.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kBplBlitWords = 64;
+static const int kBplBlitLines = 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+// Either way the rows of a blit are rowBytes apart: the planes of one line
+// interleaved, the lines of one plane planar. A null src clears.
+////////////////////////////////////////////////////////////////////////////////
+static BlitterFence Bpl_Blit(const BplLayout& layout, u8* dst, const u8* src, int x, int y, int width, int height)
+{
+	const int words = width / 16;
+
+	assert(x >= 0 && x % 16 == 0 && width % 16 == 0 && words > 0 && words <= kBplBlitWords && x + width <= layout.rowBytes * 8);
+	assert(y >= 0 && height > 0 && y + height <= layout.lines && (layout.interleaved || height <= kBplBlitLines));
+
+	const int mod = layout.rowBytes - words * 2;
+	const int offset = Bpl_Offset(layout, 0, x, y);
+
+	BlitterFence fence = Blitter_Fence();
+
+	if (layout.interleaved)
+	{
+		const int step = kBplBlitLines / layout.planes;
+
+		for (int j = 0; j < height; j += step)
+		{
+			int o = offset + j * Bpl_RowStride(layout);
+			int rows = min(step, height - j) * layout.planes;
+
+			fence = (src != nullptr) ? Blitter_Copy(dst + o, mod, src + o, mod, words, rows) : Blitter_Clear(dst + o, mod, words, rows);
+		}
+	}
+	else
+	{
+		for (int p = 0; p < layout.planes; p++)
+		{
+			int o = offset + p * Bpl_PlaneStep(layout);
+
+			fence = (src != nullptr) ? Blitter_Copy(dst + o, mod, src + o, mod, words, height) : Blitter_Clear(dst + o, mod, words, height);
+		}
+	}
+
+	return fence;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Bpl_Clear(const BplLayout& layout, void* planes, int x, int y, int width, int height)
+{
+	return Bpl_Blit(layout, (u8*) planes, nullptr, x, y, width, height);
+}
+
+BlitterFence Bpl_Copy(const BplLayout& layout, void* dst, const void* src, int x, int y, int width, int height)
+{
+	return Bpl_Blit(layout, (u8*) dst, (const u8*) src, x, y, width, height);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+
+////////////////////////////////////////////////////////////////////////////////
+// Two screens of kBplBenchLines, the destination first. The timed rectangles
+// are the size of a large bob, kBplBenchRects of them cleared and restored
+// from the source.
+////////////////////////////////////////////////////////////////////////////////
+static const int kBplBenchPlanes		= 6;
+static const int kBplBenchWidth			= 320;
+static const int kBplBenchLines			= 64;
+static const int kBplBenchSize			= kBplBenchPlanes * kBplBenchWidth / 8 * kBplBenchLines;
+static const int kBplBenchRects			= 32;
+static const int kBplBenchRectWidth		= 32;
+static const int kBplBenchRectLines		= 32;
+
+static u8 Bpl_Pattern(int offset, bool src)
+{
+	return (u8) (src ? offset * 7 + 1 : offset * 13 + 5);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Every byte of the destination, against the source inside the rectangle (or
+// 0 for a clear) and its own pattern outside. Puts the patterns back.
+////////////////////////////////////////////////////////////////////////////////
+static bool Bpl_Check(const BplLayout& layout, u8* buffer, int x, int y, int width, int height, bool clear)
+{
+	bool ok = true;
+
+	for (int p = 0; p < layout.planes; p++)
+	{
+		for (int j = 0; j < layout.lines; j++)
+		{
+			for (int i = 0; i < layout.rowBytes; i++)
+			{
+				int o = Bpl_Offset(layout, p, i * 8, j);
+				bool inside = (i * 8 >= x && i * 8 < x + width && j >= y && j < y + height);
+				u8 expected = !inside ? Bpl_Pattern(o, false) : clear ? 0 : Bpl_Pattern(o, true);
+
+				ok = ok && (buffer[o] == expected);
+				buffer[o] = Bpl_Pattern(o, false);
+			}
+		}
+	}
+
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Bpl_Benchmark(u8* buffer)
+{
+	static_assert(2 * kBplBenchSize <= (int) kBplBenchmarkSize);
+
+	u8* src = buffer + kBplBenchSize;
+
+	for (int i = 0; i < kBplBenchSize; i++)
+	{
+		buffer[i] = Bpl_Pattern(i, false);
+		src[i] = Bpl_Pattern(i, true);
+	}
+
+	for (int interleaved = 0; interleaved < 2; interleaved++)
+	{
+		const BplLayout layout = Bpl_Layout(kBplBenchPlanes, kBplBenchWidth, kBplBenchLines, interleaved != 0);
+		bool ok = true;
+
+		Blitter_Wait(Bpl_Clear(layout, buffer, 16, 3, 48, 21));
+		ok = Bpl_Check(layout, buffer, 16, 3, 48, 21, true) && ok;
+
+		Blitter_Wait(Bpl_Copy(layout, buffer, src, 272, 40, 48, 24));
+		ok = Bpl_Check(layout, buffer, 272, 40, 48, 24, false) && ok;
+
+		Blitter_Wait(Bpl_Copy(layout, buffer, src, 0, 0, kBplBenchWidth, kBplBenchLines));
+		ok = Bpl_Check(layout, buffer, 0, 0, kBplBenchWidth, kBplBenchLines, false) && ok;
+
+		System_WaitVbl();
+		Blitter_ResetStats();
+
+		for (int i = 0; i < kBplBenchRects; i++)
+		{
+			int x = (i * 48) % (kBplBenchWidth - kBplBenchRectWidth) & ~15;
+			int y = (i * 5) % (kBplBenchLines - kBplBenchRectLines);
+
+			Bpl_Clear(layout, buffer, x, y, kBplBenchRectWidth, kBplBenchRectLines);
+			Bpl_Copy(layout, buffer, src, x, y, kBplBenchRectWidth, kBplBenchRectLines);
+		}
+
+		Blitter_Wait(Blitter_Fence());
+
+		BlitterStats stats;
+		Blitter_GetStats(stats);
+
+		KPrintF("bpl: %s, %ld %ldx%ld rectangles cleared and copied: %ld blits, busy %ld colour clocks\n",
+			interleaved ? "interleaved" : "planar", kBplBenchRects, kBplBenchRectWidth, kBplBenchRectLines, stats.jobs, stats.busy);
+
+		for (int i = 0; i < kBplBenchSize; i++)
+		{
+			buffer[i] = Bpl_Pattern(i, false);
+		}
+
+		assert(ok);
+	}
+
+	Blitter_ResetStats();
+}
+#endif
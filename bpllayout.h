@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+// bpllayout.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "blitter.h"
+#include "core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Where the planes of a screen are in memory. Planar puts them back to back,
+// rowBytes * lines apart. Interleaved puts the rows of every plane of a line
+// together, so a line is planes * rowBytes bytes. In that layout the same
+// rectangle of every plane is one block of planes * height rows, and a blit
+// covers all the planes at once. The display takes the plane pointers from
+// Bpl_Offset and the modulos from Bpl_Modulo; the debugger takes
+// Bpl_DebugFlags.
+////////////////////////////////////////////////////////////////////////////////
+struct BplLayout
+{
+	int planes;
+	int rowBytes;
+	int lines;
+	bool interleaved;
+};
+
+inline constexpr BplLayout Bpl_Layout(int planes, int width, int lines, bool interleaved)
+{
+	return {planes, width / 8, lines, interleaved};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bytes from a plane to the next on the same line, and from a line to the next
+// in the same plane.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr int Bpl_PlaneStep(const BplLayout& layout)
+{
+	return layout.interleaved ? layout.rowBytes : layout.rowBytes * layout.lines;
+}
+
+inline constexpr int Bpl_RowStride(const BplLayout& layout)
+{
+	return layout.interleaved ? layout.rowBytes * layout.planes : layout.rowBytes;
+}
+
+inline constexpr int Bpl_Size(const BplLayout& layout)
+{
+	return layout.planes * layout.rowBytes * layout.lines;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Pixel x, a multiple of 8, of line y of plane p.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr int Bpl_Offset(const BplLayout& layout, int p, int x, int y)
+{
+	return p * Bpl_PlaneStep(layout) + y * Bpl_RowStride(layout) + x / 8;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// bpl1mod and bpl2mod for a display that fetches width pixels of each line.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr int Bpl_Modulo(const BplLayout& layout, int width)
+{
+	return Bpl_RowStride(layout) - width / 8;
+}
+
+inline constexpr unsigned short Bpl_DebugFlags(const BplLayout& layout)
+{
+	return layout.interleaved ? debug_resource_bitmap_interleaved : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A rectangle of every plane, x and width multiples of 16, width at most
+// 1024. Interleaved, that is one blit for up to 1024 / planes lines; planar,
+// one blit per plane. Both copy between screens of the same layout.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Bpl_Clear(const BplLayout& layout, void* planes, int x, int y, int width, int height);
+BlitterFence Bpl_Copy(const BplLayout& layout, void* dst, const void* src, int x, int y, int width, int height);
+
+////////////////////////////////////////////////////////////////////////////////
+// Debug builds: checks both calls in both layouts and prints the blits and
+// the blitter time they take for a frame's worth of small rectangles across
+// six planes. buffer is chip RAM of at least kBplBenchmarkSize bytes and is
+// overwritten.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+static const u32 kBplBenchmarkSize = 2 * 6 * 40 * 64;
+
+void Bpl_Benchmark(u8* buffer);
+#endif
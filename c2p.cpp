@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+// c2p.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "c2p.h"
+#include <hardware/blit.h>
+#include "c2pref.h"
+#include "system.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// c2p_a.s
+////////////////////////////////////////////////////////////////////////////////
+extern "C" void C2p_Cpu6(const u8* chunky, u8* planes, u32 planeSize, u32 blocks);
+extern "C" void C2p_Cpu5(const u8* chunky, u8* planes, u32 planeSize, u32 blocks);
+extern "C" void C2p_Blit32(const u8* chunky, u8* streams, u32 streamSize, u32 blocks);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void C2p_Convert(const u8* chunky, u8* planes, int planeSize, int depth, int width, int height)
+{
+	assert(depth == 5 || depth == 6);
+	assert(aligned(width * height, 16));
+	assert(aligned((u32) chunky, 2) && aligned((u32) planes, 2) && aligned(planeSize, 2));
+
+	u32 blocks = (u32) (width * height / 16);
+
+	if (depth == 6)
+	{
+		C2p_Cpu6(chunky, planes, planeSize, blocks);
+	}
+	else
+	{
+		C2p_Cpu5(chunky, planes, planeSize, blocks);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int C2p_ScratchSize(int width, int height)
+{
+	return (16 * (width * height / 8));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+// The CPU half writes the scratch buffer, so it waits for the merges of the
+// previous conversion to be done with it.
+////////////////////////////////////////////////////////////////////////////////
+static BlitterFence sC2pFence;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence C2p_ConvertBlit(const u8* chunky, u8* planes, int planeSize, int depth, int width, int height, u8* scratch)
+{
+	assert(depth == 5 || depth == 6);
+	assert(aligned(width, 32) && width <= 1024 && height <= 1024);
+	assert(aligned((u32) chunky, 2) && aligned((u32) planes, 2) && aligned(planeSize, 2));
+
+	static_assert(kC2pMergeLow == (ABC | NABC | ANBC | ANBNC));
+	static_assert(kC2pMergeHigh == (ABC | ABNC | ANBC | NANBC));
+	static_assert(kC2pMergeOr == (ABC | NABC | ANBC | NANBC | ANBNC));
+
+	const int streamSize = width * height / 8;
+
+	Blitter_Wait(sC2pFence);
+
+	C2p_Blit32(chunky, scratch, streamSize, width * height / 32);
+
+	for (const C2pBlit& blit : kC2pBlits)
+	{
+		if (blit.depth != 0 && blit.depth != depth)
+		{
+			continue;
+		}
+
+		// Descending blits start from the last word.
+		bool descending = (blit.minterm != kC2pMergeHigh);
+		int last = descending ? streamSize - 2 : 0;
+
+		u8* d = (blit.d >= kC2pPlane) ? planes + (blit.d - kC2pPlane) * planeSize : scratch + blit.d * streamSize;
+
+		BlitterJob job = {};
+		job.bltcon0 = (u16) ((blit.shift << ASHIFTSHIFT) | BC0F_SRCA | BC0F_SRCC | BC0F_DEST | blit.minterm);
+		job.bltcon1 = descending ? BC1F_DESC : 0;
+		job.bltafwm = 0xffff;
+		job.bltalwm = 0xffff;
+		job.bltbdat = blit.mask;
+		job.bltapt	= (u32) (scratch + blit.a * streamSize + last);
+		job.bltcpt	= (u32) (scratch + blit.c * streamSize + last);
+		job.bltdpt	= (u32) (d + last);
+		job.bltsize = (u16) ((height << 6) | ((width / 16) & 0x3f));
+
+		sC2pFence = Blitter_Submit(job);
+	}
+
+	return sC2pFence;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+static int C2p_Scanlines(int start)
+{
+	int lines = System_GetVpos() - start;
+	return (lines < 0) ? lines + 312 : lines;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool C2p_Check(const u8* planes, int planeSize, int depth, int width, int height, const u8* chunky, u8* expected)
+{
+	const int size = width * height / 8;
+
+	C2p_Reference(chunky, expected, size, depth, width * height);
+
+	for (int p = 0; p < depth; p++)
+	{
+		for (int i = 0; i < size; i++)
+		{
+			if (planes[p * planeSize + i] != expected[p * size + i])
+			{
+				KPrintF("c2p: plane %ld differs at byte %ld\n", p, i);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Both conversions start on a fresh frame and have to finish within it.
+////////////////////////////////////////////////////////////////////////////////
+void C2p_Benchmark(u8* chunky, u8* planes, int planeSize, int depth, int width, int height, u8* scratch)
+{
+	u32 seed = 0x2545f491;
+	for (int i = 0; i < width * height; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		chunky[i] = (u8) ((seed >> 16) & ((1 << depth) - 1));
+	}
+
+	System_WaitVbl();
+	int start = System_GetVpos();
+	C2p_Convert(chunky, planes, planeSize, depth, width, height);
+	int cpu = C2p_Scanlines(start);
+
+	bool cpuOk = C2p_Check(planes, planeSize, depth, width, height, chunky, scratch);
+
+	System_WaitVbl();
+	start = System_GetVpos();
+	Blitter_Wait(C2p_ConvertBlit(chunky, planes, planeSize, depth, width, height, scratch));
+	int blit = C2p_Scanlines(start);
+
+	bool blitOk = C2p_Check(planes, planeSize, depth, width, height, chunky, scratch);
+
+	KPrintF("c2p: %ld planes, %ld pixel lines: cpu %ld.%02ld, blitter %ld.%02ld scanlines per line\n",
+		depth, width, cpu / height, (cpu * 100 / height) % 100, blit / height, (blit * 100 / height) % 100);
+
+	assert(cpuOk && blitOk);
+}
+#endif
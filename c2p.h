@@ -0,0 +1,35 @@
+////////////////////////////////////////////////////////////////////////////////
+// c2p.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "blitter.h"
+#include "core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Chunky to planar for 5 and 6 plane screens (HAM5, HAM6, EHB, 32 or 64
+// colours). chunky holds one word aligned byte per pixel and is converted to
+// width x height pixels starting at planes, planeSize bytes apart, e.g. line
+// y of sScreenBpl for a window. width * height must be a multiple of 16.
+////////////////////////////////////////////////////////////////////////////////
+void C2p_Convert(const u8* chunky, u8* planes, int planeSize, int depth, int width, int height);
+
+////////////////////////////////////////////////////////////////////////////////
+// Same, with the blitter doing the 4, 2 and 1 bit merges. Needs a chip RAM
+// scratch buffer of C2p_ScratchSize bytes, a width that is a multiple of 32
+// up to 1024 and at most 1024 lines. Returns once the merges are queued, with
+// the fence to wait for before touching the planes. The chunky buffer is free
+// again straight away.
+////////////////////////////////////////////////////////////////////////////////
+int C2p_ScratchSize(int width, int height);
+BlitterFence C2p_ConvertBlit(const u8* chunky, u8* planes, int planeSize, int depth, int width, int height, u8* scratch);
+
+////////////////////////////////////////////////////////////////////////////////
+// Debug builds: checks both paths against C2p_Reference and prints the cost
+// in scanlines per converted line. chunky must hold width x height pixels and
+// is overwritten with a test pattern, as are the planes.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+void C2p_Benchmark(u8* chunky, u8* planes, int planeSize, int depth, int width, int height, u8* scratch);
+#endif
@@ -0,0 +1,199 @@
+/*
+ * c2p_a.s
+ *
+ * Merge based chunky to planar conversion for the 68000. Chunky pixels are
+ * one byte each, 6 or 5 significant bits (HAM6/EHB/64 colours or HAM5/32
+ * colours). A merge of registers a and b with shift s and mask m
+ *
+ *	t = ((a >> s) ^ b) & m;  b ^= t;  a ^= t << s;
+ *
+ * swaps one bit of the pixel/plane index held in the register number with
+ * one held in the bit position. Five of them turn 16 chunky pixels in four
+ * longs into six plane words; the merge that would only produce planes 6
+ * and 7 is cut down to an or. See C2p_Reference in c2pref.h for the result.
+ */
+
+/*
+ * One merge, a and b as above, t scratch, s a constant and m a register or
+ * an immediate. 52 + 4 * s cycles with m in a register.
+ */
+	.macro	MERGE a, b, s, m, t
+	movel	\a, \t
+	lsrl	#\s, \t
+	eorl	\b, \t
+	andl	\m, \t
+	eorl	\t, \b
+	.if	\s == 1
+	addl	\t, \t
+	.else
+	lsll	#\s, \t
+	.endif
+	eorl	\t, \a
+	.endm
+
+/*
+ * Merge with s = 16, using words instead of shifts. 20 cycles. The results
+ * end up swapped: b holds the new a and a the new b.
+ */
+	.macro	MERGE16 a, b, t
+	swap	\b
+	movew	\b, \t
+	movew	\a, \b
+	movew	\t, \a
+	swap	\a
+	.endm
+
+/*
+ * CPU only conversion, 16 pixels per iteration.
+ *
+ * void C2p_Cpu6(const u8* chunky, u8* planes, u32 planeSize, u32 blocks)
+ * void C2p_Cpu5(const u8* chunky, u8* planes, u32 planeSize, u32 blocks)
+ *
+ * Writes blocks words to each of the 6 (5) planes, planeSize bytes apart.
+ * Roughly 670 (594) cycles per block without DMA contention.
+ *
+ * The registers are named after the bit they hold of the pixel (x3..x0)
+ * or colour (c2..c0) index. R0..R3 start as ~x3 ~x2 and the bit positions
+ * as ~x1 ~x0 c2 c1 c0; after the merges R0, R2 and R1 hold planes 1/0, 3/2
+ * and 5/4 in their upper/lower words.
+ */
+	.macro	C2P_CPU depth
+	moveml	d2-d7/a2-a6, sp@-
+	movel	sp@(48), a0		/* chunky */
+	movel	sp@(52), a1		/* plane 0 */
+	movel	sp@(56), d0		/* planeSize */
+	movel	sp@(60), d7		/* blocks */
+	lea	a1@(0,d0:l), a2
+	lea	a2@(0,d0:l), a3
+	lea	a3@(0,d0:l), a4
+	lea	a4@(0,d0:l), a5
+	.if	\depth == 6
+	lea	a5@(0,d0:l), a6
+	.endif
+	movel	#0x0f0f0f0f, d5
+	movel	#0x00ff00ff, d6
+	subql	#1, d7
+
+1:	moveml	a0@+, d0-d3		/* R3 R2 R1 R0 = pixels 0-3 ... 12-15 */
+
+	MERGE	d3, d2, 4, d5, d4	/* R0/R1 ~x2 <-> c2 */
+	MERGE	d1, d0, 4, d5, d4	/* R2/R3 */
+	MERGE	d3, d1, 8, d6, d4	/* R0/R2 ~x3 <-> ~x0 */
+	MERGE	d2, d0, 8, d6, d4	/* R1/R3 */
+
+	.if	\depth == 6
+	MERGE	d2, d0, 1, #0x55555555, d4	/* R1/R3 ~x0 <-> c0 */
+	.else
+	addl	d0, d0			/* R1 |= R3 << 1, plane 5 is empty */
+	orl	d0, d2
+	.endif
+	MERGE	d3, d1, 1, #0x55555555, d4	/* R0/R2 */
+
+	MERGE16	d3, d1, d4		/* R0/R2 c0 <-> ~x1, now in d1/d3 */
+	MERGE	d1, d3, 2, #0x33333333, d4	/* R0/R2 ~x1 <-> c1 */
+
+	movew	d1, a1@+		/* plane 0 */
+	swap	d1
+	movew	d1, a2@+		/* plane 1 */
+	movew	d3, a3@+		/* plane 2 */
+	swap	d3
+	movew	d3, a4@+		/* plane 3 */
+
+	.if	\depth == 6
+	MERGE16	d2, d0, d4		/* R1/R3, now in d0/d2 */
+	lsll	#2, d2			/* R1 |= R3 << 2, planes 6/7 are empty */
+	orl	d2, d0
+	movew	d0, a5@+		/* plane 4 */
+	swap	d0
+	movew	d0, a6@+		/* plane 5 */
+	.else
+	movel	d2, d0			/* plane 4 = low word | high word << 2 */
+	swap	d0
+	lslw	#2, d0
+	orw	d0, d2
+	movew	d2, a5@+
+	.endif
+
+	dbra	d7, 1b
+
+	moveml	sp@+, d2-d7/a2-a6
+	rts
+	.endm
+
+	.text
+	.type	C2p_Cpu6, function
+	.globl	C2p_Cpu6
+C2p_Cpu6:
+	C2P_CPU	6
+	.size	C2p_Cpu6, .-C2p_Cpu6
+
+	.text
+	.type	C2p_Cpu5, function
+	.globl	C2p_Cpu5
+C2p_Cpu5:
+	C2P_CPU	5
+	.size	C2p_Cpu5, .-C2p_Cpu5
+
+/*
+ * First half of the blitter assisted conversion, 32 pixels per iteration.
+ *
+ * void C2p_Blit32(const u8* chunky, u8* streams, u32 streamSize, u32 blocks)
+ *
+ * Does the 16 and 8 bit merges of eight longs R0..R7 (~x4 ~x3 ~x2, bit
+ * positions ~x1 ~x0 c2 c1 c0) and writes Rn to stream n, streamSize bytes
+ * apart. The merges never mix registers with a different ~x2, so the even
+ * and odd registers are done in two runs over the chunky data to get by
+ * with four stream pointers. Roughly 676 cycles per block. The blitter does
+ * the 4, 2 and 1 bit merges, see C2p_ConvertBlit.
+ */
+	.macro	C2P_BLIT32_RUN o0, o2, o4, o6
+	movel	a5, a0
+	movel	d6, d7
+1:	movel	a0@(\o0), d0		/* R0 */
+	movel	a0@(\o2), d1		/* R2 */
+	movel	a0@(\o4), d2		/* R4 */
+	movel	a0@(\o6), d3		/* R6 */
+	lea	a0@(32), a0
+
+	MERGE16	d0, d2, d4		/* R0/R4 ~x4 <-> ~x1, now in d2/d0 */
+	MERGE16	d1, d3, d4		/* R2/R6, now in d3/d1 */
+	MERGE	d2, d3, 8, d5, d4	/* R0/R2 ~x3 <-> ~x0 */
+	MERGE	d0, d1, 8, d5, d4	/* R4/R6 */
+
+	movel	d2, a1@+
+	movel	d3, a2@+
+	movel	d0, a3@+
+	movel	d1, a4@+
+	dbra	d7, 1b
+	.endm
+
+	.text
+	.type	C2p_Blit32, function
+	.globl	C2p_Blit32
+C2p_Blit32:
+	moveml	d2-d7/a2-a6, sp@-
+	movel	sp@(48), a5		/* chunky */
+	movel	sp@(52), a1		/* stream 0 */
+	movel	sp@(56), d0		/* streamSize */
+	movel	sp@(60), d6		/* blocks */
+	subql	#1, d6
+	movel	#0x00ff00ff, d5
+	lea	a1@(0,d0:l), a6		/* stream 1, for the odd run */
+	addl	d0, d0
+
+	lea	a1@(0,d0:l), a2
+	lea	a2@(0,d0:l), a3
+	lea	a3@(0,d0:l), a4
+	C2P_BLIT32_RUN 28, 20, 12, 4	/* R0 R2 R4 R6 = pixels 28-31 ... 4-7 */
+
+	movel	a6, a1
+	movel	sp@(56), d0
+	addl	d0, d0
+	lea	a1@(0,d0:l), a2
+	lea	a2@(0,d0:l), a3
+	lea	a3@(0,d0:l), a4
+	C2P_BLIT32_RUN 24, 16, 8, 0	/* R1 R3 R5 R7 */
+
+	moveml	sp@+, d2-d7/a2-a6
+	rts
+	.size	C2p_Blit32, .-C2p_Blit32
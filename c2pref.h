@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////
+// c2pref.h
+//
+// Portable reference for the chunky to planar conversion in c2p_a.s, shared by
+// the target code and the host-side tools. One byte per pixel in, depth
+// planes of pixels / 8 bytes, planeSize bytes apart, out. Also the merges
+// the blitter does for C2p_ConvertBlit, which tools/hosttest runs through a
+// model of the blitter.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline void C2p_Reference(const unsigned char* chunky, unsigned char* planes, int planeSize, int depth, int pixels)
+{
+	for (int i = 0; i < pixels; i += 8)
+	{
+		for (int p = 0; p < depth; p++)
+		{
+			unsigned char bits = 0;
+			for (int j = 0; j < 8; j++)
+			{
+				bits = (unsigned char) ((bits << 1) | ((chunky[i + j] >> p) & 1));
+			}
+			planes[p * planeSize + i / 8] = bits;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Blitter half of the conversion. C2p_Blit32 leaves R0..R7 in streams S0..S7
+// of the scratch buffer; the 4 bit merges go to T0..T7, the 2 bit merges back
+// to S0..S7 and the 1 bit merges straight into the planes. Each merge of a
+// pair is two blits:
+//
+//   a' = (a & m) | ((b << s) & ~m)		descending, A = b, C = a
+//   b' = (b & ~m) | ((a >> s) & m)		ascending, A = a, C = b
+//
+// with m in BLTBDAT. Bits shifted in from the neighbouring word always land
+// where the mask takes C. Merges whose b' would only hold planes 6/7 (and
+// 5 for 5 planes) are a single a' = a | (b << s) blit. The minterms are
+// bltcon0's low byte, ABC in bit 7 down to NANBNC in bit 0.
+////////////////////////////////////////////////////////////////////////////////
+static const unsigned char kC2pStreamS = 0;
+static const unsigned char kC2pStreamT = 8;
+static const unsigned char kC2pPlane   = 16;
+
+static const unsigned short kC2pMergeLow  = 0xb8;	// (C & B) | (A & ~B)
+static const unsigned short kC2pMergeHigh = 0xe2;	// (A & B) | (C & ~B)
+static const unsigned short kC2pMergeOr	  = 0xba;	// C | (A & ~B)
+
+struct C2pBlit
+{
+	unsigned char a;
+	unsigned char c;
+	unsigned char d;
+	unsigned char shift;
+	unsigned short minterm;
+	unsigned short mask;
+	unsigned char depth;
+};
+
+#define C2P_MERGE(a, b, da, db, shift, mask) \
+	{b, a, da, shift, kC2pMergeLow, mask, 0}, \
+	{a, b, db, shift, kC2pMergeHigh, mask, 0}
+
+static const C2pBlit kC2pBlits[] =
+{
+	// R0/R1 ... R6/R7, ~x2 <-> c2.
+	C2P_MERGE(kC2pStreamS + 0, kC2pStreamS + 1, kC2pStreamT + 0, kC2pStreamT + 1, 4, 0x0f0f),
+	C2P_MERGE(kC2pStreamS + 2, kC2pStreamS + 3, kC2pStreamT + 2, kC2pStreamT + 3, 4, 0x0f0f),
+	C2P_MERGE(kC2pStreamS + 4, kC2pStreamS + 5, kC2pStreamT + 4, kC2pStreamT + 5, 4, 0x0f0f),
+	C2P_MERGE(kC2pStreamS + 6, kC2pStreamS + 7, kC2pStreamT + 6, kC2pStreamT + 7, 4, 0x0f0f),
+
+	// R0/R4 ... R3/R7, ~x1 <-> c1. R5 and R7 are empty afterwards.
+	C2P_MERGE(kC2pStreamT + 0, kC2pStreamT + 4, kC2pStreamS + 0, kC2pStreamS + 4, 2, 0x3333),
+	C2P_MERGE(kC2pStreamT + 2, kC2pStreamT + 6, kC2pStreamS + 2, kC2pStreamS + 6, 2, 0x3333),
+	{kC2pStreamT + 5, kC2pStreamT + 1, kC2pStreamS + 1, 2, kC2pMergeOr, 0x3333, 0},
+	{kC2pStreamT + 7, kC2pStreamT + 3, kC2pStreamS + 3, 2, kC2pMergeOr, 0x3333, 0},
+
+	// R0/R2, R4/R6, R1/R3, ~x0 <-> c0, into planes 0-5.
+	C2P_MERGE(kC2pStreamS + 0, kC2pStreamS + 2, kC2pPlane + 0, kC2pPlane + 1, 1, 0x5555),
+	C2P_MERGE(kC2pStreamS + 4, kC2pStreamS + 6, kC2pPlane + 2, kC2pPlane + 3, 1, 0x5555),
+	{kC2pStreamS + 3, kC2pStreamS + 1, kC2pPlane + 4, 1, kC2pMergeLow, 0x5555, 6},
+	{kC2pStreamS + 1, kC2pStreamS + 3, kC2pPlane + 5, 1, kC2pMergeHigh, 0x5555, 6},
+	{kC2pStreamS + 3, kC2pStreamS + 1, kC2pPlane + 4, 1, kC2pMergeOr, 0x5555, 5},
+};
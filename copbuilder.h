@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+// copbuilder.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+#include "customhelpers.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Copper lists built at compile time. A program is a struct with
+//
+//   template<class Cop> static constexpr void Build(Cop& cop);
+//
+// that calls cop.Add() with CopMove/CopWait/CopEnd commands and cop.Mark()
+// with a slot number in front of the moves that get patched at runtime.
+// CopStatic runs it twice: once to count the commands and find the slots,
+// once to fill a CopArray of exactly that size. Copying kList into a chip
+// variable is a constant initialisation, so nothing runs at startup.
+//
+// A program that needs more than budget bytes fails to compile, with the
+// error pointing at Cop_ListOverBudget.
+////////////////////////////////////////////////////////////////////////////////
+static const int kCopMaxSlots = 8;
+
+#define CopReg(reg) ((u16) offsetof(Custom, reg))
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+template<int size> struct CopArray
+{
+	CopCommand cmd[size];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Not constexpr, so calling it while building a list is a compile error.
+////////////////////////////////////////////////////////////////////////////////
+inline void Cop_ListOverBudget()
+{
+	assert(false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct CopCounter
+{
+	int count = 0;
+	int budget = 0;
+	int slot[kCopMaxSlots] = {};
+
+	constexpr CopCounter(int bytes) : budget(bytes / (int) sizeof(CopCommand))
+	{
+		for (int i = 0; i < kCopMaxSlots; i++)
+		{
+			slot[i] = -1;
+		}
+	}
+
+	constexpr void Add(CopCommand)
+	{
+		if (count == budget)
+		{
+			Cop_ListOverBudget();
+		}
+
+		count++;
+	}
+
+	constexpr void Mark(int index)
+	{
+		slot[index] = count;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+template<int size> struct CopWriter
+{
+	CopArray<size> list = {};
+	int count = 0;
+
+	constexpr void Add(CopCommand command)
+	{
+		list.cmd[count++] = command;
+	}
+
+	constexpr void Mark(int)
+	{
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+template<class Program> constexpr CopCounter Cop_Count(int budget)
+{
+	CopCounter counter(budget);
+	Program::Build(counter);
+	return counter;
+}
+
+template<class Program, int size> constexpr CopArray<size> Cop_Build()
+{
+	CopWriter<size> writer;
+	Program::Build(writer);
+	return writer.list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// kSlot[n] is the index of the first command after Mark(n), -1 if unmarked.
+////////////////////////////////////////////////////////////////////////////////
+template<class Program, int budget> struct CopStatic
+{
+	static constexpr CopCounter kInfo = Cop_Count<Program>(budget);
+	static constexpr int kSize = kInfo.count;
+	static constexpr CopArray<kSize> kList = Cop_Build<Program, kSize>();
+
+	static constexpr int Slot(int index) { return kInfo.slot[index]; }
+};
+
+template<class Program, int budget> constexpr CopCounter CopStatic<Program, budget>::kInfo;
+template<class Program, int budget> constexpr CopArray<CopStatic<Program, budget>::kSize> CopStatic<Program, budget>::kList;
+
+////////////////////////////////////////////////////////////////////////////////
+// Runtime patching of marked moves: a move's data word, or the data words of
+// an xxxPTH/xxxPTL pair.
+////////////////////////////////////////////////////////////////////////////////
+inline void Cop_SetData(CopCommand* move, u16 data)
+{
+	move->data = data;
+}
+
+inline void Cop_SetPointer(CopCommand* move, const void* pointer)
+{
+	move[0].data = (u16) (((u32) pointer) >> 16);
+	move[1].data = (u16) (((u32) pointer) & 0xffff);
+}
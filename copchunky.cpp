@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+// copchunky.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "copchunky.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Blits are at most 64 words wide, so a line goes in chunks of 32 moves.
+////////////////////////////////////////////////////////////////////////////////
+static const int kCopChunkyBlitMoves = 32;
+
+////////////////////////////////////////////////////////////////////////////////
+// One blit per chunk and copy covers every row at once: whole moves, as the
+// no-op ones are the same in every line anyway.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence CopChunky_Replicate(CopCommand* lines, int pixelHeight)
+{
+	static_assert(Dma_CopperMoves(kCopChunkyDma, kCopChunkyWaitHpos + 1, kDmaLineCycles) == kCopChunkyMoves);
+
+	assert(pixelHeight > 0 && kCopChunkyLines % pixelHeight == 0);
+
+	const int rows = kCopChunkyLines / pixelHeight;
+	const int rowBytes = pixelHeight * kCopChunkyLineSize * sizeof(CopCommand);
+	BlitterFence fence = Blitter_Fence();
+
+	for (int k = 1; k < pixelHeight; k++)
+	{
+		for (int i = 0; i < kCopChunkyMoves; i += kCopChunkyBlitMoves)
+		{
+			int moves = min(kCopChunkyMoves - i, kCopChunkyBlitMoves);
+			int mod = rowBytes - moves * sizeof(CopCommand);
+
+			fence = Blitter_Copy(lines + k * kCopChunkyLineSize + 1 + i, mod, lines + 1 + i, mod, moves * 2, rows);
+		}
+	}
+
+	return fence;
+}
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+// copchunky.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <hardware/custom.h>
+#include "blitter.h"
+#include "copbuilder.h"
+#include "core.h"
+#include "dmaslots.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Copper chunky: no bitplanes at all, the picture is colour 0 rewritten by a
+// copper MOVE every 4 colour clocks, i.e. every 8 lowres pixels. Every one of
+// the kCopChunkyLines display lines is a WAIT at kCopChunkyWaitHpos, then
+// kCopChunkyMoves moves, then one back to the border colour that lands in the
+// blanking at the start of the next line.
+//
+// A pixel is pixelWidth / 8 of those moves, the first to color00 and the rest
+// to the no-op register, and pixelHeight lines. The CPU writes 12 bit pixels
+// straight into the data words of the first line of every pixel row, from
+// CopChunky_Row with a step of CopChunky_PixelStep; CopChunky_Replicate then
+// has the blitter copy that line to the other pixelHeight - 1.
+////////////////////////////////////////////////////////////////////////////////
+static const int kCopChunkyWidth		= 320;	// Lowres pixels.
+static const int kCopChunkyLines		= 256;
+static const int kCopChunkyTop			= 0x2c;
+static const int kCopChunkyMovePixels	= 8;
+static const int kCopChunkyMoves		= kCopChunkyWidth / kCopChunkyMovePixels;
+static const int kCopChunkyLineSize		= kCopChunkyMoves + 2;	// Commands.
+static const int kCopChunkyWaitHpos		= 0x40;
+static const u16 kCopChunkyBorder		= 0x000;
+static const u16 kCopChunkyNoop			= 0x1fe;
+
+////////////////////////////////////////////////////////////////////////////////
+// With no bitplanes the copper has every even cycle, and the moves of a line
+// just fit between the WAIT and the end of it: the border move is what runs
+// on into the next line, which lets the WAIT for vpos 256 be a plain one.
+////////////////////////////////////////////////////////////////////////////////
+static constexpr DmaConfig kCopChunkyDma = {0, false, PackDdfstrt(0), PackDdfstop(kCopChunkyWidth), 0, 0, 0};
+
+////////////////////////////////////////////////////////////////////////////////
+// Built like the screen lists (see copbuilder.h); the lines start at
+// Slot(kCopChunkySlotLines).
+////////////////////////////////////////////////////////////////////////////////
+static const int kCopChunkyBudget = (kCopChunkyLines * kCopChunkyLineSize + 4) * sizeof(CopCommand);
+
+enum CopChunkySlot
+{
+	kCopChunkySlotLines,
+};
+
+template<int pixelWidth, int pixelHeight> struct CopChunkyProgram
+{
+	template<class Cop> static constexpr void Build(Cop& cop)
+	{
+		cop.Add(CopMoveColor(0, kCopChunkyBorder));
+
+		cop.Mark(kCopChunkySlotLines);
+		for (int j = 0; j < kCopChunkyLines; j++)
+		{
+			cop.Add(CopWait(kCopChunkyWaitHpos >> 1, (kCopChunkyTop + j) & 0xff));
+
+			for (int i = 0; i < kCopChunkyMoves; i++)
+			{
+				if (i % (pixelWidth / kCopChunkyMovePixels) == 0)
+				{
+					cop.Add(CopMoveColor(0, kCopChunkyBorder));
+				}
+				else
+				{
+					cop.Add({kCopChunkyNoop, 0});
+				}
+			}
+
+			cop.Add(CopMoveColor(0, kCopChunkyBorder));
+		}
+
+		cop.Add(CopEnd());
+	}
+};
+
+template<int pixelWidth, int pixelHeight> using CopChunkyCop = CopStatic<CopChunkyProgram<pixelWidth, pixelHeight>, kCopChunkyBudget>;
+
+////////////////////////////////////////////////////////////////////////////////
+// lines is the list at Slot(kCopChunkySlotLines). Pixel x of a row is at
+// CopChunky_Row(...)[x * CopChunky_PixelStep(pixelWidth)].
+////////////////////////////////////////////////////////////////////////////////
+inline u16* CopChunky_Row(CopCommand* lines, int pixelHeight, int row)
+{
+	return &lines[row * pixelHeight * kCopChunkyLineSize + 1].data;
+}
+
+inline constexpr int CopChunky_PixelStep(int pixelWidth)
+{
+	return (pixelWidth / kCopChunkyMovePixels * (int) (sizeof(CopCommand) / sizeof(u16)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Queues the copies of the first line of every row and returns the fence to
+// wait for before the list is shown, or the first lines written to again.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence CopChunky_Replicate(CopCommand* lines, int pixelHeight);
@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+// dirty.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "dirty.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_Init(DirtyRegion& region, DirtyLine* line, int width, int lines)
+{
+	assert(width > 0 && width % 16 == 0 && lines > 0);
+
+	region.width = width;
+	region.lines = lines;
+	region.line = line;
+
+	Dirty_Clear(region);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_Clear(DirtyRegion& region)
+{
+	for (int y = 0; y < region.lines; y++)
+	{
+		region.line[y].count = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Spans stay sorted and apart. The new one swallows every span it overlaps or
+// touches; if that leaves one too many, the nearest two become one.
+////////////////////////////////////////////////////////////////////////////////
+static void Dirty_AddAligned(DirtyLine& line, int left, int right)
+{
+	DirtySpan span[kDirtySpans + 1];
+	int count = 0;
+	int i = 0;
+
+	for (; i < line.count && line.span[i].right < left; i++)
+	{
+		span[count++] = line.span[i];
+	}
+
+	for (; i < line.count && line.span[i].left <= right; i++)
+	{
+		left = min(left, (int) line.span[i].left);
+		right = max(right, (int) line.span[i].right);
+	}
+
+	span[count++] = {(s16) left, (s16) right};
+
+	for (; i < line.count; i++)
+	{
+		span[count++] = line.span[i];
+	}
+
+	if (count > kDirtySpans)
+	{
+		int best = 0;
+
+		for (int j = 1; j + 1 < count; j++)
+		{
+			if (span[j + 1].left - span[j].right < span[best + 1].left - span[best].right)
+			{
+				best = j;
+			}
+		}
+
+		span[best].right = span[best + 1].right;
+
+		for (int j = best + 1; j + 1 < count; j++)
+		{
+			span[j] = span[j + 1];
+		}
+
+		count--;
+	}
+
+	for (int j = 0; j < count; j++)
+	{
+		line.span[j] = span[j];
+	}
+
+	line.count = count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_AddSpan(DirtyRegion& region, int y, int left, int right)
+{
+	left = max(left, 0) & ~15;
+	right = (min(right, region.width) + 15) & ~15;
+
+	if (y < 0 || y >= region.lines || left >= right)
+	{
+		return;
+	}
+
+	Dirty_AddAligned(region.line[y], left, right);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Dirty_AddSpan for every line of the rectangle.
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_AddRect(DirtyRegion& region, int x, int y, int width, int height)
+{
+	for (int j = max(y, 0); j < min(y + height, region.lines); j++)
+	{
+		Dirty_AddSpan(region, j, x, x + width);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_Merge(DirtyRegion& dst, const DirtyRegion& src)
+{
+	assert(dst.width == src.width && dst.lines == src.lines);
+
+	for (int y = 0; y < src.lines; y++)
+	{
+		const DirtyLine& line = src.line[y];
+
+		for (int i = 0; i < line.count; i++)
+		{
+			Dirty_AddAligned(dst.line[y], line.span[i].left, line.span[i].right);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int Dirty_Pixels(const DirtyRegion& region)
+{
+	int pixels = 0;
+
+	for (int y = 0; y < region.lines; y++)
+	{
+		const DirtyLine& line = region.line[y];
+
+		for (int i = 0; i < line.count; i++)
+		{
+			pixels += line.span[i].right - line.span[i].left;
+		}
+	}
+
+	return pixels;
+}
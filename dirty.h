@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// dirty.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// The parts of a screen that changed, as spans per line, aligned to 16 pixels
+// for c2p and the blitter. Rectangles and spans are merged as they come in,
+// so that a line never has more than kDirtySpans: overlapping or touching
+// spans become one, and past that the two with the smallest gap between them
+// do. Keeping one region per screen buffer, and adding every frame's changes
+// to all of them, gives what each buffer is behind by when its turn comes.
+////////////////////////////////////////////////////////////////////////////////
+static const int kDirtySpans = 4;
+
+struct DirtySpan
+{
+	s16 left;
+	s16 right;	// Exclusive.
+};
+
+struct DirtyLine
+{
+	int count;
+	DirtySpan span[kDirtySpans];
+};
+
+struct DirtyRegion
+{
+	int width;
+	int lines;
+	DirtyLine* line;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// line is lines DirtyLines, the region starts out clean.
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_Init(DirtyRegion& region, DirtyLine* line, int width, int lines);
+void Dirty_Clear(DirtyRegion& region);
+
+////////////////////////////////////////////////////////////////////////////////
+// Clipped to the region, rounded out to 16 pixels.
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_AddSpan(DirtyRegion& region, int y, int left, int right);
+void Dirty_AddRect(DirtyRegion& region, int x, int y, int width, int height);
+
+////////////////////////////////////////////////////////////////////////////////
+// Adds all of src to dst, the same size.
+////////////////////////////////////////////////////////////////////////////////
+void Dirty_Merge(DirtyRegion& dst, const DirtyRegion& src);
+
+////////////////////////////////////////////////////////////////////////////////
+// Pixels covered, for statistics.
+////////////////////////////////////////////////////////////////////////////////
+int Dirty_Pixels(const DirtyRegion& region);
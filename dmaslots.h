@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+// dmaslots.h
+//
+// Model of the chip bus slots on one PAL scanline, shared by the target code
+// and the host-side tools. Positions are in colour clocks (hpos), 0x00-0xe2.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kDmaLineCycles	 = 227;
+static const int kDmaFrameLines	 = 313;
+
+////////////////////////////////////////////////////////////////////////////////
+// Display configuration, with ddfstrt/ddfstop as written to the registers
+// (e.g. from PackDdfstrt/PackDdfstop, which take the same fmode). sprites
+// and audio are the channels fetching on a line, 0-8 and 0-4: a sprite with
+// DMA on but a null control word fetches nothing, and an audio channel needs
+// at most one slot a line. Disk DMA is taken to be off.
+////////////////////////////////////////////////////////////////////////////////
+struct DmaConfig
+{
+	int planes;
+	bool hires;
+	int ddfstrt;
+	int ddfstop;
+	int fmode;
+	int sprites;
+	int audio;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixed slots: refresh at 0xe2 and 0x01-0x05, disk at 0x07-0x0b, audio at
+// 0x0d-0x13, two per sprite at 0x15-0x33, all but the first refresh odd.
+////////////////////////////////////////////////////////////////////////////////
+static const int kDmaRefresh = 0x01;
+static const int kDmaAudio	 = 0x0d;
+static const int kDmaSprites = 0x15;
+
+////////////////////////////////////////////////////////////////////////////////
+// Bitplane fetched in each cycle of a fetch unit, 0 for a free cycle.
+// Lowres: 8 4 6 2 7 3 5 1, hires: 4 2 3 1. With fmode 1-3 (AGA) a unit is
+// 2 or 4 times as long, its planes fetched in the first 8 (4) cycles.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr int Dma_FetchPlane(bool hires, int slot)
+{
+	return (hires ? ((0x1324 >> ((slot & 3) * 4)) & 0xf) : ((0x15372648 >> ((slot & 7) * 4)) & 0xf));
+}
+
+inline constexpr int Dma_FetchUnit(bool hires, int fmode)
+{
+	return ((hires ? 4 : 8) << ((fmode & 1) + ((fmode >> 1) & 1)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr int Dma_FetchEnd(const DmaConfig& config)
+{
+	return (config.ddfstop + Dma_FetchUnit(config.hires, config.fmode));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr bool Dma_IsBitplaneCycle(const DmaConfig& config, int hpos)
+{
+	return ((hpos >= config.ddfstrt) && (hpos < Dma_FetchEnd(config)) &&
+		((hpos - config.ddfstrt) % Dma_FetchUnit(config.hires, config.fmode) < Dma_FetchUnit(config.hires, 0)) &&
+		(Dma_FetchPlane(config.hires, hpos - config.ddfstrt) != 0) && (Dma_FetchPlane(config.hires, hpos - config.ddfstrt) <= config.planes));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Cycles the refresh, audio, sprites or bitplanes take, whatever else wants
+// them. Bitplanes fetched early take the sprite slots.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr bool Dma_IsFixedCycle(const DmaConfig& config, int hpos)
+{
+	return ((hpos == kDmaLineCycles - 1) ||
+		((hpos & 1) && hpos <= kDmaRefresh + 4) ||
+		((hpos & 1) && hpos >= kDmaAudio && hpos < kDmaAudio + config.audio * 2) ||
+		((hpos & 1) && hpos >= kDmaSprites && hpos < kDmaSprites + config.sprites * 4) ||
+		Dma_IsBitplaneCycle(config, hpos));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The copper only runs on even cycles the fixed DMA leaves free.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr bool Dma_IsCopperCycle(const DmaConfig& config, int hpos)
+{
+	return (((hpos & 1) == 0) && (hpos < kDmaLineCycles) && !Dma_IsFixedCycle(config, hpos));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Number of copper MOVEs that complete in [start, end). end may run into the
+// following line(s), i.e. be kDmaLineCycles or more.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr int Dma_CopperMoves(const DmaConfig& config, int start, int end)
+{
+	int cycles = 0;
+	for (int hpos = start; hpos < end; hpos++)
+	{
+		if (Dma_IsCopperCycle(config, hpos % kDmaLineCycles))
+		{
+			cycles++;
+		}
+	}
+	return (cycles / 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Colour moves that fit between a WAIT at the right edge of the display
+// window and the left edge on the next line, for a window sx..sx+width as
+// passed to PackDiwstrt/PackDiwstop. The WAIT costs one cycle to wake up.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr int Dma_SliceWaitHpos(int sx, int width)
+{
+	return (((sx + width + 0x81) / 2 + 1) & ~1);
+}
+
+inline constexpr int Dma_SliceMoves(const DmaConfig& config, int sx, int width)
+{
+	return Dma_CopperMoves(config, Dma_SliceWaitHpos(sx, width) + 1, kDmaLineCycles + (sx + 0x81) / 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Chip bus budget. The copper, the blitter and the CPU share the cycles the
+// fixed DMA leaves free, in that order of priority: the copper and the CPU
+// only ever use even ones, the blitter any. The CPU needs a cycle for every
+// word it reads or writes in chip RAM (none from fast RAM); the blitter one
+// for every word of every channel; the copper two per MOVE or WAIT.
+////////////////////////////////////////////////////////////////////////////////
+struct DmaSlots
+{
+	int fixed;
+	int even;	// Free for the copper, the blitter or the CPU.
+	int odd;	// Free for the blitter.
+};
+
+struct DmaBudget
+{
+	int cpu;
+	int blitter;
+	int copper;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr DmaSlots Dma_LineSlots(const DmaConfig& config)
+{
+	DmaSlots slots = {0, 0, 0};
+
+	for (int hpos = 0; hpos < kDmaLineCycles; hpos++)
+	{
+		if (Dma_IsFixedCycle(config, hpos))
+		{
+			slots.fixed++;
+		}
+		else if (hpos & 1)
+		{
+			slots.odd++;
+		}
+		else
+		{
+			slots.even++;
+		}
+	}
+
+	return slots;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A frame with the bitplanes on lines of its kDmaFrameLines, the rest blank
+// but with the same sprites and audio.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr DmaSlots Dma_FrameSlots(const DmaConfig& config, int lines)
+{
+	DmaConfig blank = config;
+	blank.planes = 0;
+
+	DmaSlots display = Dma_LineSlots(config);
+	DmaSlots border = Dma_LineSlots(blank);
+	int borders = kDmaFrameLines - lines;
+
+	return {display.fixed * lines + border.fixed * borders, display.even * lines + border.even * borders, display.odd * lines + border.odd * borders};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether an effect needing budget a frame fits, for a compile-time check:
+//
+//   static_assert(Dma_BudgetFits(kDma, kScreenHeight, kBudget));
+//
+// The copper and CPU have to fit the even cycles and everything the free
+// ones, whatever the order they come in. It says nothing of a frame that
+// needs a cycle the beam has already passed, so keep a margin.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr bool Dma_BudgetFits(const DmaConfig& config, int lines, const DmaBudget& budget)
+{
+	return ((budget.copper + budget.cpu <= Dma_FrameSlots(config, lines).even) &&
+		(budget.copper + budget.cpu + budget.blitter <= Dma_FrameSlots(config, lines).even + Dma_FrameSlots(config, lines).odd));
+}
@@ -0,0 +1,14 @@
+////////////////////////////////////////////////////////////////////////////////
+// fixed.h
+//
+// Fixed point on the target; everything but the build report is in
+// fixedmath.h.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+#include "gendata.h"
+#include "fixedmath.h"
+
+GEN_REPORT("fixed: sine, reciprocal and square root tables", sizeof(FixTables<0>::kSin) + sizeof(FixTables<0>::kRecip) + sizeof(FixTables<0>::kSqrt), GEN_COMPILED)
@@ -0,0 +1,276 @@
+////////////////////////////////////////////////////////////////////////////////
+// fixedmath.h
+//
+// The fixed point types, operators and tables of fixed.h without anything of
+// the target's own, so that tools/hosttest can check them. The includer
+// provides s16 to u32, assert and the 68000's muluw/mulsw/divsw: core.h on
+// the target, tools/common/types.h and <assert.h> on the host.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "gendata.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixed point: Fix16 is 16.16 in 32 bits, Fix8 8.8 in 16 bits. The 68000 only
+// multiplies and divides 16 bit operands, so everything here is built from
+// muluw/mulsw/divuw/divsw. A Fix8 product is one mulsw, a Fix16 one four
+// multiplies without a call; a plain 32 bit '*' goes through __mulsi3 and a
+// 64 bit one does not link at all. Products round down, quotients toward
+// zero.
+//
+// FromFloat is for constants: constexpr Fix16 kHalf = Fix16::FromFloat(0.5);
+// used at runtime it would need soft float.
+////////////////////////////////////////////////////////////////////////////////
+template<typename T, int frac> struct Fixed
+{
+	T raw;
+
+	static constexpr Fixed FromRaw(T value) { return {value}; }
+	static constexpr Fixed FromInt(int value) { return {(T) (value * (1 << frac))}; }
+	static constexpr Fixed FromFloat(double value) { return {(T) (value * (1 << frac) + ((value < 0) ? -0.5 : 0.5))}; }
+
+	constexpr int Floor() const { return raw >> frac; }
+	constexpr int Round() const { return (raw + (1 << (frac - 1))) >> frac; }
+
+	constexpr Fixed operator-() const { return {(T) -raw}; }
+	constexpr Fixed operator+(Fixed b) const { return {(T) (raw + b.raw)}; }
+	constexpr Fixed operator-(Fixed b) const { return {(T) (raw - b.raw)}; }
+	Fixed& operator+=(Fixed b) { raw += b.raw; return *this; }
+	Fixed& operator-=(Fixed b) { raw -= b.raw; return *this; }
+
+	constexpr bool operator==(Fixed b) const { return raw == b.raw; }
+	constexpr bool operator!=(Fixed b) const { return raw != b.raw; }
+	constexpr bool operator<(Fixed b) const { return raw < b.raw; }
+	constexpr bool operator<=(Fixed b) const { return raw <= b.raw; }
+	constexpr bool operator>(Fixed b) const { return raw > b.raw; }
+	constexpr bool operator>=(Fixed b) const { return raw >= b.raw; }
+};
+
+typedef Fixed<s16, 8> Fix8;
+typedef Fixed<s32, 16> Fix16;
+
+////////////////////////////////////////////////////////////////////////////////
+// Signed times unsigned 16 bit, from muluw and a correction for s < 0.
+////////////////////////////////////////////////////////////////////////////////
+inline u32 Fix_MulSU(s16 s, u16 u)
+{
+	u32 product = muluw((u16) s, u);
+	return (s < 0) ? product - ((u32) u << 16) : product;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline Fix8 operator*(Fix8 a, Fix8 b)
+{
+	return Fix8::FromRaw((s16) (mulsw(a.raw, b.raw) >> 8));
+}
+
+// The quotient must fit, or divsw leaves garbage.
+inline Fix8 operator/(Fix8 a, Fix8 b)
+{
+	return Fix8::FromRaw(divsw(a.raw * 256, b.raw));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// (ah.al * bh.bl) >> 16, modulo 2^32 like the raw values.
+////////////////////////////////////////////////////////////////////////////////
+inline Fix16 operator*(Fix16 a, Fix16 b)
+{
+	s16 ah = (s16) (a.raw >> 16);
+	s16 bh = (s16) (b.raw >> 16);
+	u16 al = (u16) a.raw;
+	u16 bl = (u16) b.raw;
+
+	u32 high = (u32) mulsw(ah, bh) << 16;
+	u32 low = muluw(al, bl) >> 16;
+
+	return Fix16::FromRaw((s32) (high + Fix_MulSU(ah, bl) + Fix_MulSU(bh, al) + low));
+}
+
+inline Fix16 operator*(Fix16 a, s16 b)
+{
+	s16 ah = (s16) (a.raw >> 16);
+	u16 al = (u16) a.raw;
+
+	return Fix16::FromRaw((s32) (((u32) mulsw(ah, b) << 16) + Fix_MulSU(b, al)));
+}
+
+// Two divu in __udivsi3 as the divisor is 16 bits.
+inline Fix16 operator/(Fix16 a, s16 b)
+{
+	return Fix16::FromRaw(a.raw / b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tables, generated by the compiler from the double references below:
+//
+// - sine of kFixAngles steps per turn, times 2^kFixSinShift (2.14);
+// - 1/i in 16.16 for 2 <= i < kFixRecips, Fix_Recip handles 1;
+// - sqrt(m) * 256 for kFixSqrtMin <= m < 4 * kFixSqrtMin, Fix_Sqrt shifts
+//   its argument into that range two bits at a time.
+//
+// Every entry is its reference rounded to nearest. Members of a class
+// template, so there is one copy however many files use them (see gendata.h).
+////////////////////////////////////////////////////////////////////////////////
+static const int kFixAngles	  = 1024; // Power of two.
+static const int kFixSinShift = 14;
+static const int kFixRecips	  = 1024;
+static const int kFixSqrtMin  = 256;
+
+static constexpr double kFixPi = 3.14159265358979323846;
+
+////////////////////////////////////////////////////////////////////////////////
+// Taylor series, good to 1e-9 for |x| <= pi / 2; Newton's method for sqrt.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr double Fix_RefSin(double x)
+{
+	double term = x;
+	double sum = x;
+
+	for (int n = 1; n < 10; n++)
+	{
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+
+	return sum;
+}
+
+inline constexpr double Fix_RefSqrt(double x)
+{
+	double root = (x > 1) ? x : 1;
+
+	for (int i = 0; i < 64; i++)
+	{
+		root = (root + x / root) / 2;
+	}
+
+	return root;
+}
+
+inline constexpr s32 Fix_RefRound(double x)
+{
+	return (s32) (x + ((x < 0) ? -0.5 : 0.5));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The first quarter turn is computed and mirrored, so the table is exactly
+// symmetric.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr GenArray<s16, kFixAngles> Fix_MakeSin()
+{
+	GenArray<s16, kFixAngles> table = {};
+
+	for (int i = 0; i <= kFixAngles / 4; i++)
+	{
+		s16 value = (s16) Fix_RefRound(Fix_RefSin(2 * kFixPi * i / kFixAngles) * (1 << kFixSinShift));
+
+		table.value[i] = value;
+		table.value[kFixAngles / 2 - i] = value;
+		table.value[(kFixAngles / 2 + i) & (kFixAngles - 1)] = (s16) -value;
+		table.value[(kFixAngles - i) & (kFixAngles - 1)] = (s16) -value;
+	}
+
+	return table;
+}
+
+inline constexpr GenArray<u16, kFixRecips> Fix_MakeRecip()
+{
+	GenArray<u16, kFixRecips> table = {};
+
+	for (int i = 2; i < kFixRecips; i++)
+	{
+		table.value[i] = (u16) Fix_RefRound(65536.0 / i);
+	}
+
+	return table;
+}
+
+inline constexpr GenArray<u16, 3 * kFixSqrtMin> Fix_MakeSqrt()
+{
+	GenArray<u16, 3 * kFixSqrtMin> table = {};
+
+	for (int i = 0; i < 3 * kFixSqrtMin; i++)
+	{
+		table.value[i] = (u16) Fix_RefRound(Fix_RefSqrt(kFixSqrtMin + i) * 256);
+	}
+
+	return table;
+}
+
+template<int dummy> struct FixTables
+{
+	static constexpr GenArray<s16, kFixAngles> kSin = Fix_MakeSin();
+	static constexpr GenArray<u16, kFixRecips> kRecip = Fix_MakeRecip();
+	static constexpr GenArray<u16, 3 * kFixSqrtMin> kSqrt = Fix_MakeSqrt();
+};
+
+template<int dummy> constexpr GenArray<s16, kFixAngles> FixTables<dummy>::kSin;
+template<int dummy> constexpr GenArray<u16, kFixRecips> FixTables<dummy>::kRecip;
+template<int dummy> constexpr GenArray<u16, 3 * kFixSqrtMin> FixTables<dummy>::kSqrt;
+
+////////////////////////////////////////////////////////////////////////////////
+// angle in kFixAngles per turn, any int.
+////////////////////////////////////////////////////////////////////////////////
+inline s16 Fix_Sin(int angle)
+{
+	return FixTables<0>::kSin.value[angle & (kFixAngles - 1)];
+}
+
+inline s16 Fix_Cos(int angle)
+{
+	return FixTables<0>::kSin.value[(angle + kFixAngles / 4) & (kFixAngles - 1)];
+}
+
+inline Fix16 Fix_Sin16(int angle)
+{
+	return Fix16::FromRaw(Fix_Sin(angle) * (1 << (16 - kFixSinShift)));
+}
+
+inline Fix16 Fix_Cos16(int angle)
+{
+	return Fix16::FromRaw(Fix_Cos(angle) * (1 << (16 - kFixSinShift)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// 0 < i < kFixRecips.
+////////////////////////////////////////////////////////////////////////////////
+inline Fix16 Fix_Recip(int i)
+{
+	assert(i > 0 && i < kFixRecips);
+
+	return Fix16::FromRaw((i == 1) ? 0x10000 : FixTables<0>::kRecip.value[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// x >= 0. The argument keeps its top 9-10 bits, so the result is within
+// 0.2% plus a unit in the last place.
+////////////////////////////////////////////////////////////////////////////////
+inline Fix16 Fix_Sqrt(Fix16 x)
+{
+	assert(x.raw >= 0);
+
+	u32 m = (u32) x.raw;
+	int shift = 0;
+
+	if (m == 0)
+	{
+		return x;
+	}
+
+	while (m >= 4 * kFixSqrtMin)
+	{
+		m >>= 2;
+		shift++;
+	}
+
+	while (m < kFixSqrtMin)
+	{
+		m <<= 2;
+		shift--;
+	}
+
+	u32 root = FixTables<0>::kSqrt.value[m - kFixSqrtMin];
+	return Fix16::FromRaw((s32) ((shift >= 0) ? root << shift : root >> -shift));
+}
@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+// gendata.h
+//
+// Tables generated at compile time, and the build report of them. Includes
+// nothing, so that headers shared with the host-side tools (fixedmath.h) can
+// use it.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Data generated by the compiler. A generator is a struct with
+//
+//   typedef ... Type;
+//   static const int kSize = ...;
+//   static constexpr Type Value(int index);
+//
+// and Gen_Array<Generator>() is the whole array, evaluated at compile time
+// when it initialises a static. Like the copper lists (see copbuilder.h), a
+// chip or const variable initialised from it is a constant initialisation:
+// the bytes are in the executable and nothing runs at startup. Tables that
+// are easier filled in one go (mirrored, say) can build a GenArray in their
+// own constexpr function instead.
+//
+// gcc drops section attributes on templates, so chip data must be a plain
+// variable:
+//
+//   static GenArray<u16, 1024> sWave __attribute__((section (".MEMF_CHIP"))) = Gen_Array<WaveGenerator>();
+////////////////////////////////////////////////////////////////////////////////
+template<typename T, int size> struct GenArray
+{
+	T value[size];
+};
+
+template<class Generator> constexpr GenArray<typename Generator::Type, Generator::kSize> Gen_Array()
+{
+	GenArray<typename Generator::Type, Generator::kSize> array = {};
+
+	for (int i = 0; i < Generator::kSize; i++)
+	{
+		array.value[i] = Generator::Value(i);
+	}
+
+	return array;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Build report: GEN_REPORT("ham: screen pattern", sizeof(kScreenPattern), GEN_COMPILED)
+// records a line in the .gen_report section of the elf, which is not loaded
+// and so never reaches the executable. The Makefile prints the section after
+// linking: every block of data the compiler generated and every one still
+// built at runtime (GEN_RUNTIME), with its size. Identical lines from several
+// files are merged.
+////////////////////////////////////////////////////////////////////////////////
+#define GEN_COMPILED "generated at compile time"
+#define GEN_RUNTIME "built at runtime"
+
+#define GEN_REPORT(name, bytes, how) private_gen_report(__LINE__, name, bytes, how)
+#define private_gen_report(line, name, bytes, how) private_gen_report2(line, name, bytes, how)
+#define private_gen_report2(line, name, bytes, how) \
+	__attribute__((used)) static void Gen_Report##line() \
+	{ \
+		asm volatile(".pushsection .gen_report,\"MS\",@progbits,1\n\t.string \"" name ": %c0 bytes " how "\"\n\t.popsection" : : "i" ((unsigned int) (bytes))); \
+	}
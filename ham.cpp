@@ -5,190 +5,1556 @@
 #include "ham.h"
 #include <hardware/custom.h>
 #include <hardware/dmabits.h>
+#include <hardware/intbits.h>
+#include "anim.h"
+#include "arena.h"
+#include "blitter.h"
+#include "bpllayout.h"
+#include "c2p.h"
+#include "copbuilder.h"
+#include "copchunky.h"
 #include "core.h"
 #include "customhelpers.h"
+#include "dirty.h"
+#include "dmaslots.h"
+#include "fixed.h"
+#include "gendata.h"
+#include "hamrt.h"
+#include "mem.h"
+#include "profile.h"
 #include "system.h"
 
-#define HAM6
-//#define HAM5
-//#define EHB
+//#define SLICED
 
-#if !defined(HAM6) && !defined(HAM5) && !defined(EHB)
-#error "Define one of the modes!"
-#endif
+//#define C2P
+
+//#define HAMRT
+
+//#define ANIM
+
+//#define LETTERBOX
+
+//#define INTERLEAVED
+
+//#define DIRTY
+
+////////////////////////////////////////////////////////////////////////////////
+// Screen modes. Everything that depends on the mode (plane count, copper list
+// layout, bplcon0, the drawing loops) is a template on it, so a mode is picked
+// once in Ham_Start and nothing below Ham_Update branches on it. Ham_Init
+// picks HAM8 on AGA and HAM6 otherwise; the right mouse button steps through
+// the modes the machine can show. AGA modes fetch the planes 64 bits at a time
+// (kFmode 3), which leaves the CPU 24 of every 32 colour clocks of a fetch unit
+// even with 8 planes, and have a 24 bit palette. The copper chunky mode has no
+// planes and functions of its own.
+////////////////////////////////////////////////////////////////////////////////
+enum HamMode
+{
+	kHamMode6,
+	kHamMode5,
+	kHamModeEhb,
+	kHamMode8,
+	kHamModeCopper,
+	kHamModes
+};
+
+template<HamMode mode> struct HamTraits;
+
+template<> struct HamTraits<kHamMode6>
+{
+	static const int kPlanes = 6;
+	static const int kColors = 16;
+	static const bool kHam	 = true;
+	static const bool kAga	 = false;
+	static const u16 kFmode	 = 0x0000;
+};
+
+template<> struct HamTraits<kHamMode5>
+{
+	static const int kPlanes = 5;
+	static const int kColors = 16;
+	static const bool kHam	 = true;
+	static const bool kAga	 = false;
+	static const u16 kFmode	 = 0x0000;
+};
+
+template<> struct HamTraits<kHamModeEhb>
+{
+	static const int kPlanes = 6;
+	static const int kColors = 32;
+	static const bool kHam	 = false;
+	static const bool kAga	 = false;
+	static const u16 kFmode	 = 0x0000;
+};
+
+template<> struct HamTraits<kHamMode8>
+{
+	static const int kPlanes = 8;
+	static const int kColors = 64;
+	static const bool kHam	 = true;
+	static const bool kAga	 = true;
+	static const u16 kFmode	 = 0x0003;
+};
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 static const int kScreenWidth	   = 320;
 static const int kScreenHeight	   = 256;
-#if defined(HAM5)
-static const int kScreenPlanes	   = 5;
+static const int kScreenMaxPlanes  = 8;
+
+////////////////////////////////////////////////////////////////////////////////
+// Letterboxed: the buffers hold only the kScreenLines lines from kScreenTop,
+// and each frame may show fewer still (see HamWindow). The lines above and
+// below are border, with no planes fetched and no chip RAM behind them. Not
+// with SLICED, whose waits leave no room for the window's.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(LETTERBOX)
+static const int kScreenTop	  = 32;
+static const int kScreenLines = kScreenHeight - 2 * kScreenTop;
 #else
-static const int kScreenPlanes	   = 6;
+static const int kScreenTop	  = 0;
+static const int kScreenLines = kScreenHeight;
 #endif
-static const int kScreenPlaneSize  = kScreenWidth / 8 * kScreenHeight;
-static const int kScreenBufferSize = kScreenPlanes * kScreenPlaneSize;
+
+static const int kScreenPlaneSize  = kScreenWidth / 8 * kScreenLines;
+static const int kScreenBufferSize = kScreenMaxPlanes * kScreenPlaneSize;
+static const u32 kScreenAlign	   = 8;	// For the 64 bit fetch of fmode 3.
 
 ////////////////////////////////////////////////////////////////////////////////
+// Screen buffers: Ham_Update draws into the back buffer and queues it, the VBL
+// interrupt patches the bitplane pointers in the copper list to show it. The
+// pointer moves sit behind a wait for kFlipLine so the interrupt can patch
+// them before the copper gets there; an interrupt that is late leaves the flip
+// for the next frame instead of showing half of it. With three buffers drawing
+// only waits when it gets a whole frame ahead of the display.
 ////////////////////////////////////////////////////////////////////////////////
-static const u16 kPalette[] = {
-	0x000, 0x111, 0x222, 0x333, 0x444, 0x555, 0x666, 0x777,	0x888, 0x999, 0xaaa, 0xbbb, 0xccc, 0xddd, 0xeee, 0xfff,
-	0xf00, 0xf50, 0xfa0, 0xff0, 0x8f0, 0x0f0, 0x0ff, 0x0cf, 0x08f, 0x04f, 0x00f, 0x40f, 0x80f, 0xc0f, 0xf0f, 0xf08,
-};
+static const int kScreenBuffers = 3;
+static const int kFlipFrames	= 1; // VBLs per flip, 2 for 25 fps.
+static const int kFlipLine		= 0x10;
 
 ////////////////////////////////////////////////////////////////////////////////
+// The planes of a buffer (see bpllayout.h): back to back, or with INTERLEAVED
+// a line of every plane after the other, so that clearing or copying a
+// rectangle of all of them is one blit. c2p and the animation deltas write a
+// plane's lines one after the other; interleaved, c2p goes a line at a time
+// and the animation does not play.
 ////////////////////////////////////////////////////////////////////////////////
-struct CopList
+template<HamMode mode> inline constexpr BplLayout Ham_Layout()
 {
-	CopCommand bpl0pth;
-	CopCommand bpl0ptl;
-	CopCommand bpl1pth;
-	CopCommand bpl1ptl;
-	CopCommand bpl2pth;
-	CopCommand bpl2ptl;
-	CopCommand bpl3pth;
-	CopCommand bpl3ptl;
-	CopCommand bpl4pth;
-	CopCommand bpl4ptl;
-	#if !defined(HAM5)
-	CopCommand bpl5pth;
-	CopCommand bpl5ptl;
+	#if defined(INTERLEAVED)
+	return Bpl_Layout(HamTraits<mode>::kPlanes, kScreenWidth, kScreenLines, true);
+	#else
+	return Bpl_Layout(HamTraits<mode>::kPlanes, kScreenWidth, kScreenLines, false);
 	#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Animated band, redrawn in every back buffer so each one holds a whole frame.
+////////////////////////////////////////////////////////////////////////////////
+static const int kBandLines = 8;
+static const int kBandTop	= (kScreenHeight - kBandLines) / 2;
+
+////////////////////////////////////////////////////////////////////////////////
+// AGA palettes past 32 colours are loaded a bank at a time through bplcon3,
+// kBplcon3 being its reset value (PF2OF 3). A colour register takes the high
+// nibbles of a 24 bit colour, setting the low ones to the same, and then the
+// low nibbles with kBplcon3Loct set.
+////////////////////////////////////////////////////////////////////////////////
+static const u16 kBplcon3	  = 0x0c00;
+static const u16 kBplcon3Loct = 0x0200;
+
+////////////////////////////////////////////////////////////////////////////////
+// Sliced HAM: colours 1-15 are reloaded by the copper in the gap between the
+// right edge of one line and the left edge of the next. Colour 0 stays put as
+// it is also the border colour. The slice for vpos 255 waits at 0xFFDF so it
+// doubles as the wrap wait: its moves run on into line 256, where a separate
+// 0xFFDF wait would never match again. Only HAM6 and HAM5 are sliced.
+////////////////////////////////////////////////////////////////////////////////
+static const int kSliceColors	 = 15;
+static const int kSliceWaitHpos	 = Dma_SliceWaitHpos(0, kScreenWidth);
+static const int kSliceFirstLine = 0x2c - 1;
+static const int kSliceWrapRow	 = 0xff - kSliceFirstLine;
 
-	#if !defined(EHB)
-	CopCommand color[16];
+template<HamMode mode> inline constexpr bool Ham_IsSliced()
+{
+	#if defined(SLICED)
+	return (HamTraits<mode>::kHam && !HamTraits<mode>::kAga);
 	#else
-	CopCommand color[32];
+	return false;
 	#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Chunky mode: the band is drawn into a chunky buffer and converted into the
+// back buffer with the blitter doing most of the merges. The next frame is
+// drawn while the blits run. HAM8 has too many planes and draws planar.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(C2P)
+static const int kC2pBenchLines = 4;
+static const int kC2pStatsFrames = 256;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Real-time HAM, on top of C2P: HAM6 draws the band as 12 bit colours at half
+// the resolution both ways and hamrt_a.s turns them into the chunky codes, with
+// tables for the base colours built by the compiler. A 68000 takes most of a
+// frame over it. hamconv -rt shows what the greedy choice costs in quality.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(C2P) && defined(HAMRT)
+static const int kHamRtPixel = 2;
+static const int kHamRtWidth = kScreenWidth / kHamRtPixel;
+static const int kHamRtLines = kBandLines / kHamRtPixel;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Dirty spans, on top of HAMRT: HAM6 shows a still backdrop over the whole
+// buffer, at the real-time HAM resolution, with a square moving over it. Only
+// the spans the square leaves or covers are converted again (see dirty.h),
+// each on to the next set so that the codes after it still hold, and only
+// those go through c2p into the back buffer. sCodes keeps the codes of the
+// whole screen, a line for every kHamRtPixel the display shows; the tracker
+// works in its lines.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(C2P) && defined(HAMRT) && defined(DIRTY)
+static const int kDirtyRows		 = kScreenLines / kHamRtPixel;
+static const int kDirtyCodesSize = kScreenWidth * kDirtyRows;
+static const int kDirtyBob		 = 12;
+static const int kDirtyBobColor	 = 0xfff;
+static const int kDirtyStatsFrames = 256;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Delta animation: the modes data/anim.anm was made for play it instead of the
+// pattern, one delta into the back buffer per flip. hamconv -anim writes it;
+// its interleave has to be kScreenBuffers and it must not be sliced.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(ANIM)
+INCBIN(sAnimData, "data/anim.anm")
+
+static AnimPlayer sAnim;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static constexpr u16 kPalette[] = {
+	0x000, 0x111, 0x222, 0x333, 0x444, 0x555, 0x666, 0x777,	0x888, 0x999, 0xaaa, 0xbbb, 0xccc, 0xddd, 0xeee, 0xfff,
+	0xf00, 0xf50, 0xfa0, 0xff0, 0x8f0, 0x0f0, 0x0ff, 0x0cf, 0x08f, 0x04f, 0x00f, 0x40f, 0x80f, 0xc0f, 0xf0f, 0xf08,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// The 64 base colours of the AGA modes, 0xrrggbb: a 16 step grey ramp, then 48
+// hues round the colour wheel, light for the first 24 and dark for the rest.
+////////////////////////////////////////////////////////////////////////////////
+static constexpr int Ham_HueRamp(int i)
+{
+	return min(abs((i & 255) - 128) * 3, 255);
+}
 
-	CopCommand end;
+struct HamPalette24Generator
+{
+	typedef u32 Type;
+	static const int kSize = 64;
+
+	static constexpr u32 Value(int index)
+	{
+		if (index < 16)
+		{
+			return (u32) (index * 0x111111);
+		}
+
+		int hue = (index - 16) % 24 * 256 / 24;
+		int scale = (index < 40) ? 256 : 160;
+
+		return (u32) ((Ham_HueRamp(hue) * scale >> 8) << 16 | (Ham_HueRamp(hue + 85) * scale >> 8) << 8 | (Ham_HueRamp(hue + 170) * scale >> 8));
+	}
 };
 
+static constexpr GenArray<u32, HamPalette24Generator::kSize> kPalette24 = Gen_Array<HamPalette24Generator>();
+
 ////////////////////////////////////////////////////////////////////////////////
+// The high or low nibbles of a 24 bit colour, as a colour register takes them.
 ////////////////////////////////////////////////////////////////////////////////
-static u16 sScreenBpl[kScreenBufferSize / sizeof(u16)] __attribute__((section (".MEMF_CHIP"))) = {};
+static constexpr u16 Ham_Color24(u32 color, bool low)
+{
+	int shift = low ? 0 : 4;
+
+	return (u16) ((((color >> (16 + shift)) & 15) << 8) | (((color >> (8 + shift)) & 15) << 4) | ((color >> shift) & 15));
+}
 
 ////////////////////////////////////////////////////////////////////////////////
+// The part of the screen a frame shows, in screen pixels: within the kScreenTop
+// to kScreenTop + kScreenLines lines the buffers hold, left and width in whole
+// fetch units (16 pixels, 64 with fmode 3). The copper narrows the display
+// window and the data fetch to it, points the planes at its first line and
+// switches them on there and off after its last, so that nothing outside it
+// costs bitplane DMA. The border shows colour 0.
 ////////////////////////////////////////////////////////////////////////////////
-static CopList sCopList __attribute__((section (".MEMF_CHIP")));
+struct HamWindow
+{
+	int left;
+	int top;
+	int width;
+	int lines;
+};
+
+static constexpr HamWindow kHamFullWindow = {0, kScreenTop, kScreenWidth, kScreenLines};
 
 ////////////////////////////////////////////////////////////////////////////////
+// The window's part of the copper list, before the first line: bplcon0 with
+// no planes, the display window, the fetch and the modulos, then the waits
+// that switch the planes on and off. A line past 255 needs the 0xFFDF wait in
+// front of its own, so each switch has two waits; one that needs no wrap
+// waits for its line twice. Sliced modes already wait on every line and keep
+// their planes on.
 ////////////////////////////////////////////////////////////////////////////////
-bool Ham_Init()
+static const int kHamWindowRegs	 = 7;
+static const int kHamWindowWaits = 6;
+
+template<HamMode mode> inline constexpr int Ham_WindowCommands()
+{
+	return Ham_IsSliced<mode>() ? kHamWindowRegs : kHamWindowRegs + kHamWindowWaits;
+}
+
+struct HamWindowCop
+{
+	CopCommand cmd[kHamWindowRegs + kHamWindowWaits];
+};
+
+template<HamMode mode> static constexpr HamWindowCop Ham_WindowCop(const HamWindow& window)
+{
+	typedef HamTraits<mode> Traits;
+
+	const u16 planesOn = PackBplcon0(Traits::kPlanes, false, Traits::kHam);
+	const u16 planesOff = PackBplcon0(0, false, Traits::kHam);
+	const u16 modulo = (u16) Bpl_Modulo(Ham_Layout<mode>(), window.width);
+	const int top = window.top + 0x2c;
+	const int bottom = window.top + window.lines + 0x2c;
+
+	HamWindowCop cop = {};
+	CopCommand* cmd = cop.cmd;
+
+	*cmd++ = CopMove(bplcon0, Ham_IsSliced<mode>() ? planesOn : planesOff);
+	*cmd++ = CopMove(diwstrt, PackDiwstrt(window.left, 0));
+	*cmd++ = CopMove(diwstop, PackDiwstop(window.left + window.width, kScreenHeight));
+	*cmd++ = CopMove(ddfstrt, PackDdfstrt(window.left));
+	*cmd++ = CopMove(ddfstop, PackDdfstrt(window.left) + PackDdfstop(window.width, false, Traits::kFmode) - PackDdfstrt(0));
+	*cmd++ = CopMove(bpl1mod, modulo);
+	*cmd++ = CopMove(bpl2mod, modulo);
+
+	*cmd++ = (top > 0xff) ? CopWait(0xdf >> 1, 0xff) : CopWait(0, top);
+	*cmd++ = CopWait(0, top & 0xff);
+	*cmd++ = CopMove(bplcon0, planesOn);
+	*cmd++ = (bottom > 0xff && top <= 0xff) ? CopWait(0xdf >> 1, 0xff) : CopWait(0, bottom & 0xff);
+	*cmd++ = CopWait(0, bottom & 0xff);
+	*cmd++ = CopMove(bplcon0, planesOff);
+
+	return cop;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Copper lists, one per mode, built by the compiler (see copbuilder.h). The
+// bitplane pointers and the window are patched at runtime; the palette and the
+// slices are marked too, for whatever loads real ones. A list over kCopBudget
+// bytes is a compile error.
+////////////////////////////////////////////////////////////////////////////////
+static const int kCopBudget = 20 * 1024;
+
+enum HamCopSlot
+{
+	kHamSlotBplpt,
+	kHamSlotPalette,
+	kHamSlotWindow,
+	kHamSlotSlices,
+};
+
+template<HamMode mode> struct HamCopProgram
 {
-	warpmode(true);
+	typedef HamTraits<mode> Traits;
 
-	for (int j = 0; j < kScreenHeight; j++)
+	template<class Cop> static constexpr void Build(Cop& cop)
 	{
-		for (int i = 0; i < (kScreenWidth / 16); i++)
+		cop.Add(CopWait(0, kFlipLine));
+
+		cop.Mark(kHamSlotBplpt);
+		for (int p = 0; p < Traits::kPlanes; p++)
+		{
+			cop.Add({(u16) (CopReg(bplpt) + p * 4), 0});
+			cop.Add({(u16) (CopReg(bplpt) + p * 4 + 2), 0});
+		}
+
+		cop.Mark(kHamSlotPalette);
+		if (Traits::kAga)
+		{
+			for (int bank = 0; bank < Traits::kColors / 32; bank++)
+			{
+				for (int low = 0; low < 2; low++)
+				{
+					cop.Add(CopMove(bplcon3, kBplcon3 | (bank << 13) | (low ? kBplcon3Loct : 0)));
+
+					for (int i = 0; i < 32; i++)
+					{
+						cop.Add(CopMoveColor(i, Ham_Color24(kPalette24.value[bank * 32 + i], low != 0)));
+					}
+				}
+			}
+
+			cop.Add(CopMove(bplcon3, kBplcon3));
+		}
+		else
+		{
+			for (int i = 0; i < Traits::kColors; i++)
+			{
+				cop.Add(CopMoveColor(i, kPalette[i]));
+			}
+		}
+
+		cop.Mark(kHamSlotWindow);
+		const HamWindowCop window = Ham_WindowCop<mode>(kHamFullWindow);
+		for (int i = 0; i < Ham_WindowCommands<mode>(); i++)
+		{
+			cop.Add(window.cmd[i]);
+		}
+
+		if (Ham_IsSliced<mode>())
 		{
-			int col = i + (j >> 2);
-
-			sScreenBpl[kScreenPlaneSize / 2 * 0 + j * kScreenWidth / 16 + i] = (col &  1) ? 0xffff : 0x0000;
-			sScreenBpl[kScreenPlaneSize / 2 * 1 + j * kScreenWidth / 16 + i] = (col &  2) ? 0xffff : 0x0000;
-			sScreenBpl[kScreenPlaneSize / 2 * 2 + j * kScreenWidth / 16 + i] = (col &  4) ? 0xffff : 0x0000;
-			sScreenBpl[kScreenPlaneSize / 2 * 3 + j * kScreenWidth / 16 + i] = (col &  8) ? 0xffff : 0x0000;
-			sScreenBpl[kScreenPlaneSize / 2 * 4 + j * kScreenWidth / 16 + i] = (col & 16) ? 0xffff : 0x0000;
-			#if !defined(HAM5)
-			sScreenBpl[kScreenPlaneSize / 2 * 5 + j * kScreenWidth / 16 + i] = (col & 32) ? 0xffff : 0x0000;
-			#endif
-		}
-	}
-
-	sCopList.bpl0pth = CopMoveH(bplpt[0], sScreenBpl + kScreenPlaneSize / 2 * 0);
-	sCopList.bpl0ptl = CopMoveL(bplpt[0], sScreenBpl + kScreenPlaneSize / 2 * 0);
-	sCopList.bpl1pth = CopMoveH(bplpt[1], sScreenBpl + kScreenPlaneSize / 2 * 1);
-	sCopList.bpl1ptl = CopMoveL(bplpt[1], sScreenBpl + kScreenPlaneSize / 2 * 1);
-	sCopList.bpl2pth = CopMoveH(bplpt[2], sScreenBpl + kScreenPlaneSize / 2 * 2);
-	sCopList.bpl2ptl = CopMoveL(bplpt[2], sScreenBpl + kScreenPlaneSize / 2 * 2);
-	sCopList.bpl3pth = CopMoveH(bplpt[3], sScreenBpl + kScreenPlaneSize / 2 * 3);
-	sCopList.bpl3ptl = CopMoveL(bplpt[3], sScreenBpl + kScreenPlaneSize / 2 * 3);
-	sCopList.bpl4pth = CopMoveH(bplpt[4], sScreenBpl + kScreenPlaneSize / 2 * 4);
-	sCopList.bpl4ptl = CopMoveL(bplpt[4], sScreenBpl + kScreenPlaneSize / 2 * 4);
-	#if !defined(HAM5)
-	sCopList.bpl5pth = CopMoveH(bplpt[5], sScreenBpl + kScreenPlaneSize / 2 * 5);
-	sCopList.bpl5ptl = CopMoveL(bplpt[5], sScreenBpl + kScreenPlaneSize / 2 * 5);
-	#endif
-
-	sCopList.color[ 0] = CopMove(color[ 0], kPalette[ 0]);
-	sCopList.color[ 1] = CopMove(color[ 1], kPalette[ 1]);
-	sCopList.color[ 2] = CopMove(color[ 2], kPalette[ 2]);
-	sCopList.color[ 3] = CopMove(color[ 3], kPalette[ 3]);
-	sCopList.color[ 4] = CopMove(color[ 4], kPalette[ 4]);
-	sCopList.color[ 5] = CopMove(color[ 5], kPalette[ 5]);
-	sCopList.color[ 6] = CopMove(color[ 6], kPalette[ 6]);
-	sCopList.color[ 7] = CopMove(color[ 7], kPalette[ 7]);
-	sCopList.color[ 8] = CopMove(color[ 8], kPalette[ 8]);
-	sCopList.color[ 9] = CopMove(color[ 9], kPalette[ 9]);
-	sCopList.color[10] = CopMove(color[10], kPalette[10]);
-	sCopList.color[11] = CopMove(color[11], kPalette[11]);
-	sCopList.color[12] = CopMove(color[12], kPalette[12]);
-	sCopList.color[13] = CopMove(color[13], kPalette[13]);
-	sCopList.color[14] = CopMove(color[14], kPalette[14]);
-	sCopList.color[15] = CopMove(color[15], kPalette[15]);
-	#if defined(EHB)
-	sCopList.color[16] = CopMove(color[16], kPalette[16]);
-	sCopList.color[17] = CopMove(color[17], kPalette[17]);
-	sCopList.color[18] = CopMove(color[18], kPalette[18]);
-	sCopList.color[19] = CopMove(color[19], kPalette[19]);
-	sCopList.color[20] = CopMove(color[20], kPalette[20]);
-	sCopList.color[21] = CopMove(color[21], kPalette[21]);
-	sCopList.color[22] = CopMove(color[22], kPalette[22]);
-	sCopList.color[23] = CopMove(color[23], kPalette[23]);
-	sCopList.color[24] = CopMove(color[24], kPalette[24]);
-	sCopList.color[25] = CopMove(color[25], kPalette[25]);
-	sCopList.color[26] = CopMove(color[26], kPalette[26]);
-	sCopList.color[27] = CopMove(color[27], kPalette[27]);
-	sCopList.color[28] = CopMove(color[28], kPalette[28]);
-	sCopList.color[29] = CopMove(color[29], kPalette[29]);
-	sCopList.color[30] = CopMove(color[30], kPalette[30]);
-	sCopList.color[31] = CopMove(color[31], kPalette[31]);
-	#endif
-
-	sCopList.end = CopEnd();
-
-	debug_register_bitmap(sScreenBpl , "Bpl", kScreenWidth, kScreenHeight, kScreenPlanes, 0);
-	debug_register_palette(kPalette, "Palette", countof(kPalette), 0);
-
-	warpmode(false);
-
-	#if defined(HAM5)
-	custom.bplcon0 = PackBplcon0(5, false, true);
-	#elif defined(HAM6)
-	custom.bplcon0 = PackBplcon0(6, false, true);
-	#elif defined(EHB)
-	custom.bplcon0 = PackBplcon0(kScreenPlanes, false, false);
+			cop.Mark(kHamSlotSlices);
+			for (int j = 0; j < kScreenHeight; j++)
+			{
+				cop.Add((j == kSliceWrapRow) ? CopWait(0xdf >> 1, 0xff) : CopWait(kSliceWaitHpos >> 1, (kSliceFirstLine + j) & 0xff));
+
+				// Placeholder slices, fading the grey ramp towards a hue per line.
+				// hamconv -sliced writes real ones as .slc, in this same layout.
+				for (int i = 0; i < kSliceColors; i++)
+				{
+					int c = i + 1;
+					int t = (j >> 4) & 15;
+					cop.Add(CopMoveColor(c, (c << 8) | (((c * t) >> 4) << 4) | ((c * (15 - t)) >> 4)));
+				}
+			}
+		}
+
+		cop.Add(CopEnd());
+	}
+};
+
+template<HamMode mode> using HamCop = CopStatic<HamCopProgram<mode>, kCopBudget>;
+template<HamMode mode> using HamCopList = CopArray<HamCop<mode>::kSize>;
+
+////////////////////////////////////////////////////////////////////////////////
+// Copper chunky mode: a plasma written straight into the copper list (see
+// copchunky.h), into one of kCopperLists while another is shown. The pixel
+// width is a multiple of 8 that divides 320, the height divides 256.
+////////////////////////////////////////////////////////////////////////////////
+static const int kCopperLists		= 2;
+static const int kCopperPixelWidth	= 8;
+static const int kCopperPixelHeight = 4;
+static const int kCopperColumns		= kCopChunkyWidth / kCopperPixelWidth;
+static const int kCopperRows		= kCopChunkyLines / kCopperPixelHeight;
+
+typedef CopChunkyCop<kCopperPixelWidth, kCopperPixelHeight> HamCopperCop;
+typedef CopArray<HamCopperCop::kSize> HamCopperList;
+
+static const int kCopperBenchBand = 16; // Lines per c2p in the debug benchmark.
+
+////////////////////////////////////////////////////////////////////////////////
+// The test pattern: word i of line j of plane p, scrolled sideways by frame.
+////////////////////////////////////////////////////////////////////////////////
+static constexpr u16 Ham_PatternWord(int p, int j, int i, int frame)
+{
+	return ((i + (j >> 2) + frame) & (1 << p)) ? 0xffff : 0x0000;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Frame 0 of the pattern in all kScreenMaxPlanes planes, the lines the buffers
+// hold, generated by the compiler (see gendata.h). It need not be in chip RAM:
+// a mode copies the planes it shows into its screen buffers when it starts.
+////////////////////////////////////////////////////////////////////////////////
+struct HamPatternGenerator
+{
+	typedef u16 Type;
+	static const int kSize = kScreenBufferSize / sizeof(u16);
+
+	static constexpr u16 Value(int index)
+	{
+		return Ham_PatternWord(index / (kScreenPlaneSize / 2), index % (kScreenPlaneSize / 2) / (kScreenWidth / 16) + kScreenTop, index % (kScreenWidth / 16), 0);
+	}
+};
+
+static const GenArray<u16, HamPatternGenerator::kSize> kScreenPattern = Gen_Array<HamPatternGenerator>();
+
+////////////////////////////////////////////////////////////////////////////////
+// The copper chunky plasma: a colour per pixel from the sum of a column and a
+// row offset, each 64-192. The colours go once round the hues every 256
+// entries and are there twice over, so the sum needs no mask.
+////////////////////////////////////////////////////////////////////////////////
+static constexpr int Ham_PlasmaRamp(int i)
+{
+	return min(abs((i & 255) - 128) >> 3, 15);
+}
+
+struct HamPlasmaGenerator
+{
+	typedef u16 Type;
+	static const int kSize = 512;
+
+	static constexpr u16 Value(int index)
+	{
+		return (u16) ((Ham_PlasmaRamp(index) << 8) | (Ham_PlasmaRamp(index + 85) << 4) | Ham_PlasmaRamp(index + 170));
+	}
+};
+
+static const GenArray<u16, HamPlasmaGenerator::kSize> kPlasmaColors = Gen_Array<HamPlasmaGenerator>();
+
+struct HamPlasma
+{
+	u8 x[kCopperColumns];
+	u8 y[kCopperRows];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// The running mode's screen buffers and copper list, from the chip arena: a
+// mode marks it when it starts and resets it when it stops. The list is a
+// copy of the one the compiler built, HamCop<mode>::kList.
+////////////////////////////////////////////////////////////////////////////////
+static ArenaMark sModeMark;
+static u16* sScreenBpl[kScreenBuffers];
+static CopCommand* sCopList;
+
+GEN_REPORT("ham: screen pattern", sizeof(kScreenPattern), GEN_COMPILED)
+GEN_REPORT("ham: plasma colours", sizeof(kPlasmaColors), GEN_COMPILED)
+GEN_REPORT("ham: copper lists", sizeof(HamCop<kHamMode6>::kList) + sizeof(HamCop<kHamMode5>::kList) + sizeof(HamCop<kHamModeEhb>::kList) + sizeof(HamCop<kHamMode8>::kList), GEN_COMPILED)
+GEN_REPORT("ham: screen buffers, copied at every mode start", kScreenBuffers * kScreenBufferSize, GEN_RUNTIME)
+GEN_REPORT("ham: copper chunky list", sizeof(HamCopperCop::kList), GEN_COMPILED)
+GEN_REPORT("ham: copper chunky lists, copied at every mode start", kCopperLists * sizeof(HamCopperList), GEN_RUNTIME)
+
+////////////////////////////////////////////////////////////////////////////////
+// The copper chunky mode's lists, from the chip arena like the screen buffers.
+////////////////////////////////////////////////////////////////////////////////
+static CopCommand* sCopperLists[kCopperLists];
+
+////////////////////////////////////////////////////////////////////////////////
+// The VBL writes sFront before clearing sQueued, so reading sQueued first and
+// sFront second never misses the buffer on screen.
+////////////////////////////////////////////////////////////////////////////////
+static volatile int sFront;
+static volatile int sQueued;
+static volatile int sFlipWait;
+static int sBack;
+static int sFrame;
+
+////////////////////////////////////////////////////////////////////////////////
+// The window of the frame in each buffer, shown with it.
+////////////////////////////////////////////////////////////////////////////////
+static HamWindow sWindow[kScreenBuffers];
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static HamMode sMode;
+static bool sModeButton;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const char* const kBufferNames[] = {"Bpl 0", "Bpl 1", "Bpl 2"};
+static const char* const kCopperNames[] = {"Copper 0", "Copper 1"};
+
+////////////////////////////////////////////////////////////////////////////////
+// The chunky band is only ever touched by the CPU, so it goes in fast RAM;
+// the blitter works on the scratch.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(C2P)
+static const u32 kChunkySize = kScreenWidth * kBandLines;
+static const u32 kC2pScratchSize = kScreenWidth * kBandLines * 2;
+
+static u8* sChunky;
+static u8* sC2pScratch;
+
+GEN_REPORT("ham: chunky band, at every mode start", kChunkySize, GEN_RUNTIME)
+#else
+static const u32 kC2pScratchSize = 0;
+#endif
+
+#if defined(C2P) && defined(HAMRT)
+static constexpr HamRtTables Ham_RtTables()
+{
+	HamRtTables tables = {};
+	HamRt_ReferenceTables(tables, kPalette);
+	return tables;
+}
+
+static const HamRtTables kHamRtTables = Ham_RtTables();
+static u16* sRgb;
+
+GEN_REPORT("ham: real-time HAM tables", sizeof(kHamRtTables), GEN_COMPILED)
+GEN_REPORT("ham: real-time HAM band, at every mode start", kHamRtWidth * kHamRtLines * sizeof(u16), GEN_RUNTIME)
+#endif
+
+#if defined(C2P) && defined(HAMRT) && defined(DIRTY)
+static u8* sCodes;
+static DirtyRegion sDirtyFrame;
+static DirtyRegion sDirtyPending[kScreenBuffers];
+static int sBobX;
+static int sBobY;
+static int sDirtyPixels;
+
+GEN_REPORT("ham: dirty span codes and regions, at every mode start", kDirtyCodesSize + (kScreenBuffers + 1) * kDirtyRows * sizeof(DirtyLine), GEN_RUNTIME)
+#endif
+
+template<HamMode mode> inline constexpr bool Ham_IsDirty()
+{
+	#if defined(C2P) && defined(HAMRT) && defined(DIRTY)
+	return (mode == kHamMode6);
+	#else
+	return false;
 	#endif
-	custom.bplcon1 = PackBplcon1(0, 0);
-	custom.bplcon2 = PackBplcon2(false, 0);
-	custom.bpl1mod = 0;
-	custom.bpl2mod = 0;
-	custom.diwstrt = PackDiwstrt(0, 0);
-	custom.diwstop = PackDiwstop(kScreenWidth, kScreenHeight);
-	custom.ddfstrt = PackDdfstrt(0);
-	custom.ddfstop = PackDdfstop(kScreenWidth);
-	custom.fmode   = 0x0000;
-	custom.copcon  = 2;
-	custom.cop1lc  = (u32) &sCopList;
+}
 
-	System_WaitVbl();
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static HamCopList<mode>& Ham_CopList()
+{
+	return *(HamCopList<mode>*) sCopList;
+}
 
-	custom.dmacon = DMAF_SETCLR | DMAF_COPPER | DMAF_RASTER | DMAF_MASTER;
+static u16* Ham_Bpl(int buffer)
+{
+	return sScreenBpl[buffer];
+}
 
-	return true;
+template<HamMode mode> static bool Ham_PlaysAnim()
+{
+	#if defined(ANIM)
+	const AnimHeader& header = *sAnim.header;
+
+	return (HamTraits<mode>::kHam && !HamTraits<mode>::kAga && !Ham_IsSliced<mode>() && !Ham_Layout<mode>().interleaved && header.planes == HamTraits<mode>::kPlanes &&
+		header.width == kScreenWidth && header.height == kScreenLines && header.interleave == kScreenBuffers);
+	#else
+	return false;
+	#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
-void Ham_Deinit()
+template<HamMode mode> static void Ham_DrawPattern(u16* bpl, int top, int lines, int frame)
+{
+	static constexpr BplLayout kLayout = Ham_Layout<mode>();
+
+	for (int j = top; j < top + lines; j++)
+	{
+		for (int i = 0; i < (kScreenWidth / 16); i++)
+		{
+			for (int p = 0; p < HamTraits<mode>::kPlanes; p++)
+			{
+				bpl[Bpl_Offset(kLayout, p, i * 16, j - kScreenTop) / 2] = Ham_PatternWord(p, j, i, frame);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// kScreenPattern is planar; interleaved, it goes in a row at a time.
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_CopyPattern(u16* bpl)
 {
-	debug_unregister(kPalette);
-	debug_unregister(sScreenBpl);
+	static constexpr BplLayout kLayout = Ham_Layout<mode>();
+
+	if (!kLayout.interleaved)
+	{
+		memcpy(bpl, kScreenPattern.value, Bpl_Size(kLayout));
+		return;
+	}
+
+	for (int p = 0; p < kLayout.planes; p++)
+	{
+		for (int j = 0; j < kScreenLines; j++)
+		{
+			memcpy((u8*) bpl + Bpl_Offset(kLayout, p, 0, j), (const u8*) kScreenPattern.value + p * kScreenPlaneSize + j * kLayout.rowBytes, kLayout.rowBytes);
+		}
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
-void Ham_Update()
+#if defined(C2P)
+#if defined(HAMRT)
+static void Ham_DrawRgb(int frame)
 {
-	System_WaitVbl();
+	for (int j = 0; j < kHamRtLines; j++)
+	{
+		const u16* colors = kPlasmaColors.value + j * 16;
+
+		for (int i = 0; i < kHamRtWidth; i++)
+		{
+			sRgb[j * kHamRtWidth + i] = colors[(i + frame * 3) & 255];
+		}
+	}
+}
+#endif
+
+template<HamMode mode> static void Ham_DrawChunky(int frame)
+{
+	#if defined(HAMRT)
+	if (mode == kHamMode6)
+	{
+		Ham_DrawRgb(frame);
+		HamRt_Convert(kHamRtTables, sRgb, sChunky, kHamRtWidth, kHamRtLines, kHamRtPixel, kHamRtPixel);
+		return;
+	}
+	#endif
+
+	for (int j = 0; j < kBandLines; j++)
+	{
+		int y = kBandTop + j;
+
+		for (int i = 0; i < kScreenWidth; i++)
+		{
+			sChunky[j * kScreenWidth + i] = (u8) (((i >> 4) + (y >> 2) + frame) & ((1 << HamTraits<mode>::kPlanes) - 1));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The chunky band into the back buffer.
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static BlitterFence Ham_ConvertBand(u8* bpl)
+{
+	static constexpr BplLayout kLayout = Ham_Layout<mode>();
+
+	u8* band = bpl + Bpl_Offset(kLayout, 0, 0, kBandTop - kScreenTop);
+
+	if (!kLayout.interleaved)
+	{
+		return C2p_ConvertBlit(sChunky, band, Bpl_PlaneStep(kLayout), kLayout.planes, kScreenWidth, kBandLines, sC2pScratch);
+	}
+
+	for (int j = 0; j < kBandLines; j++)
+	{
+		C2p_Convert(sChunky + j * kScreenWidth, band + j * Bpl_RowStride(kLayout), Bpl_PlaneStep(kLayout), kLayout.planes, kScreenWidth, 1);
+	}
+
+	return Blitter_Fence();
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// The backdrop is a diagonal of the plasma hues, the square plain white. In
+// HAMRT pixels, left to right of row y.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(C2P) && defined(HAMRT) && defined(DIRTY)
+static void Ham_DirtyRgb(u16* rgb, int y, int left, int right)
+{
+	bool bob = (y >= sBobY && y < sBobY + kDirtyBob);
+
+	for (int x = left; x < right; x++)
+	{
+		*rgb++ = (bob && x >= sBobX && x < sBobX + kDirtyBob) ? kDirtyBobColor : kPlasmaColors.value[(x + y * 2) & 255];
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Converts a span of row y of sCodes again, on to the next set, and returns
+// where it ended. left and right are in screen pixels, as the codes are.
+////////////////////////////////////////////////////////////////////////////////
+static int Ham_DirtyConvert(int y, int left, int right)
+{
+	u8* codes = sCodes + y * kScreenWidth;
+	int end = HamRt_NextSet(codes, right, kScreenWidth);
+
+	short hold[3];
+	HamRt_ReferenceHold(kHamRtTables, codes, left, hold);
+
+	Ham_DirtyRgb(sRgb, y, left / kHamRtPixel, end / kHamRtPixel);
+	HamRt_ConvertSpan(kHamRtTables, sRgb, codes + left, (end - left) / kHamRtPixel, kHamRtPixel, hold);
+
+	return end;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The pending spans of a buffer from sCodes, each converted once and copied to
+// the lines below it. With the CPU: a span is too short for the blitter's
+// setup to pay off.
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_DirtyBlit(u8* bpl, DirtyRegion& pending)
+{
+	static constexpr BplLayout kLayout = Ham_Layout<mode>();
+
+	for (int y = 0; y < kDirtyRows; y++)
+	{
+		const DirtyLine& line = pending.line[y];
+
+		for (int i = 0; i < line.count; i++)
+		{
+			int left = line.span[i].left;
+			int bytes = (line.span[i].right - left) / 8;
+			u8* dst = bpl + Bpl_Offset(kLayout, 0, left, y * kHamRtPixel);
+
+			C2p_Convert(sCodes + y * kScreenWidth + left, dst, Bpl_PlaneStep(kLayout), kLayout.planes, bytes * 8, 1);
+
+			for (int k = 1; k < kHamRtPixel; k++)
+			{
+				for (int p = 0; p < kLayout.planes; p++)
+				{
+					memcpy(dst + p * Bpl_PlaneStep(kLayout) + k * Bpl_RowStride(kLayout), dst + p * Bpl_PlaneStep(kLayout), bytes);
+				}
+			}
+		}
+	}
+
+	Dirty_Clear(pending);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The square bounces about the backdrop.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_MoveBob(int frame)
+{
+	static const int kRangeX = (kHamRtWidth - kDirtyBob) / 2;
+	static const int kRangeY = (kDirtyRows - kDirtyBob) / 2;
+
+	sBobX = kRangeX + (Fix_Sin(frame * 5) * kRangeX >> kFixSinShift);
+	sBobY = kRangeY + (Fix_Cos(frame * 7) * kRangeY >> kFixSinShift);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The whole backdrop into sCodes and every buffer.
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_DirtyBegin()
+{
+	Ham_MoveBob(sFrame);
+
+	for (int y = 0; y < kDirtyRows; y++)
+	{
+		Ham_DirtyRgb(sRgb, y, 0, kHamRtWidth);
+		HamRt_Convert(kHamRtTables, sRgb, sCodes + y * kScreenWidth, kHamRtWidth, 1, kHamRtPixel, 1);
+		Dirty_AddSpan(sDirtyPending[0], y, 0, kScreenWidth);
+	}
+
+	Ham_DirtyBlit<mode>((u8*) Ham_Bpl(0), sDirtyPending[0]);
+
+	for (int i = 1; i < kScreenBuffers; i++)
+	{
+		Blitter_Wait(Mem_CopyChip(Ham_Bpl(i), Ham_Bpl(0), Bpl_Size(Ham_Layout<mode>())));
+	}
+
+	sDirtyPixels = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The frame's rectangles are where the square was and where it is. Each span
+// grows to where its conversion ended, and goes into every buffer's pending
+// region, the back buffer's then being drawn.
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_DirtyUpdate(u8* bpl, int frame)
+{
+	Dirty_Clear(sDirtyFrame);
+	Dirty_AddRect(sDirtyFrame, sBobX * kHamRtPixel, sBobY, kDirtyBob * kHamRtPixel, kDirtyBob);
+	Ham_MoveBob(frame);
+	Dirty_AddRect(sDirtyFrame, sBobX * kHamRtPixel, sBobY, kDirtyBob * kHamRtPixel, kDirtyBob);
+
+	PROFILE_BEGIN("dirty convert");
+	for (int y = 0; y < kDirtyRows; y++)
+	{
+		const DirtyLine line = sDirtyFrame.line[y];
+
+		for (int i = 0; i < line.count; i++)
+		{
+			int end = Ham_DirtyConvert(y, line.span[i].left, line.span[i].right);
+			Dirty_AddSpan(sDirtyFrame, y, line.span[i].left, end);
+		}
+	}
+	PROFILE_END("dirty convert");
+
+	for (int i = 0; i < kScreenBuffers; i++)
+	{
+		Dirty_Merge(sDirtyPending[i], sDirtyFrame);
+	}
+
+	PROFILE_BEGIN("dirty c2p");
+	sDirtyPixels += Dirty_Pixels(sDirtyPending[sBack]);
+	Ham_DirtyBlit<mode>(bpl, sDirtyPending[sBack]);
+	PROFILE_END("dirty c2p");
+
+	#if defined(DEBUG)
+	if ((frame + 1) % kDirtyStatsFrames == 0)
+	{
+		KPrintF("dirty: %ld of %ld code pixels a frame into the back buffer\n", sDirtyPixels / kDirtyStatsFrames, kDirtyCodesSize);
+		sDirtyPixels = 0;
+	}
+	#endif
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// The window of the buffer's frame goes with it.
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_Show(int buffer)
+{
+	const HamWindow& window = sWindow[buffer];
+	const u8* bpl = (u8*) Ham_Bpl(buffer);
+
+	CopCommand* move = Ham_CopList<mode>().cmd + HamCop<mode>::Slot(kHamSlotBplpt);
+
+	for (int p = 0; p < HamTraits<mode>::kPlanes; p++)
+	{
+		Cop_SetPointer(move + p * 2, bpl + Bpl_Offset(Ham_Layout<mode>(), p, window.left, window.top - kScreenTop));
+	}
+
+	const HamWindowCop cop = Ham_WindowCop<mode>(window);
+	CopCommand* cmd = Ham_CopList<mode>().cmd + HamCop<mode>::Slot(kHamSlotWindow);
+
+	for (int i = 0; i < Ham_WindowCommands<mode>(); i++)
+	{
+		cmd[i] = cop.cmd[i];
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The window of the frame drawn for sFrame: the whole buffer, or with
+// LETTERBOX bars that close in on the band and open out again, the sides
+// narrowing by whole fetch units as they do.
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static HamWindow Ham_FrameWindow(int frame)
+{
+	#if defined(LETTERBOX)
+	static const int kFetch = BplFetchBytes(HamTraits<mode>::kFmode) * 8;
+	static const int kMaxBar = kBandTop - kScreenTop;
+	static const int kMaxSide = max(kFetch, 64);
+
+	int bar = kMaxBar * ((1 << kFixSinShift) - Fix_Cos(frame * 4)) >> (kFixSinShift + 1);
+	int side = kMaxSide * bar / kMaxBar / kFetch * kFetch;
+
+	return {side, kScreenTop + bar, kScreenWidth - 2 * side, kScreenLines - 2 * bar};
+	#else
+	unused(frame);
+	return kHamFullWindow;
+	#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// show puts a buffer on screen, from the VBL and before kFlipLine.
+////////////////////////////////////////////////////////////////////////////////
+template<void (*show)(int buffer)> static void Ham_Vbl()
+{
+	if (sFlipWait > 0)
+	{
+		sFlipWait = sFlipWait - 1;
+	}
+
+	if (sFlipWait == 0 && sQueued >= 0 && System_GetVpos() < kFlipLine)
+	{
+		show(sQueued);
+
+		sFront = sQueued;
+		sQueued = -1;
+		sFlipWait = kFlipFrames;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Queues the back buffer and moves on to the next one, waiting until it is no
+// longer on screen. The buffers go strictly in turn, so the back buffer always
+// holds the frame buffers flips back, which is what animation deltas are made
+// against.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_Flip(int buffers)
+{
+	while (sQueued >= 0)
+	{
+		System_WaitFrame(System_GetFrame() + 1);
+	}
+
+	sQueued = sBack;
+	sBack = (sBack + 1) % buffers;
+
+	while (sBack == sFront)
+	{
+		System_WaitFrame(System_GetFrame() + 1);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The end of every mode's update: flips, then keeps to kFlipFrames VBLs a
+// frame.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_EndFrame(int buffers)
+{
+	PROFILE_BEGIN("flip");
+	Ham_Flip(buffers);
+	PROFILE_END("flip");
+
+	int dropped = System_Pace(kFlipFrames);
+	unused(dropped);
+
+	#if defined(DEBUG)
+	if (dropped != 0)
+	{
+		KPrintF("ham: frame %ld dropped %ld frames, %ld in total\n", sFrame, dropped, System_GetDroppedFrames());
+	}
+	#endif
+
+	sFrame++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Chip bus cycles a frame of a plane mode takes at most (see dmaslots.h): the
+// CPU redrawing the band, or filling the c2p scratch, the merge blits, at
+// most 20 of a stream each reading A and C and writing D, and the copper
+// list. Ham_StartMode checks it against the mode's display.
+////////////////////////////////////////////////////////////////////////////////
+static const int kC2pMergeBlits = 20;
+
+template<HamMode mode> static constexpr DmaBudget Ham_Budget()
+{
+	return {kBandLines * (kScreenWidth / 16) * HamTraits<mode>::kPlanes + (int) kC2pScratchSize / 4,
+		3 * kC2pMergeBlits * (int) kC2pScratchSize / 32,
+		2 * HamCop<mode>::kSize};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_StartMode()
+{
+	typedef HamTraits<mode> Traits;
+
+	static constexpr BplLayout kLayout = Ham_Layout<mode>();
+	static const u32 kScreenSize = Bpl_Size(kLayout);
+	static_assert(kScreenBuffers * (kScreenSize + kScreenAlign) + sizeof(HamCopList<mode>) + kC2pScratchSize <= kArenaChipSize);
+
+	// Every plane starts on a fetch and every line is whole fetches, so the
+	// modulos are too.
+	static_assert(kScreenAlign % BplFetchBytes(Traits::kFmode) == 0 && Bpl_PlaneStep(kLayout) % kScreenAlign == 0 && Bpl_RowStride(kLayout) % kScreenAlign == 0 && (kScreenWidth / 8) % BplFetchBytes(Traits::kFmode) == 0);
+
+	// At most kScreenLines lines fetch; the letterbox bars cost nothing.
+	static constexpr DmaConfig kDma = {Traits::kPlanes, false, PackDdfstrt(0), PackDdfstop(kScreenWidth, false, Traits::kFmode), Traits::kFmode, 0, 0};
+	static_assert(Dma_BudgetFits(kDma, kScreenLines, Ham_Budget<mode>()));
+	static_assert(!Ham_IsSliced<mode>() || kScreenLines == kScreenHeight);
+
+	sModeMark = Arena_Mark();
+
+	HamCopList<mode>& copList = *Arena_New<HamCopList<mode>>(kArenaChip);
+	copList = HamCop<mode>::kList;
+	sCopList = copList.cmd;
+
+	for (int i = 0; i < kScreenBuffers; i++)
+	{
+		sScreenBpl[i] = Arena_New<u16>(kArenaChip, kScreenSize / 2, kScreenAlign);
+	}
+
+	#if defined(ANIM)
+	Anim_Begin(sAnim, sAnimData);
+
+	if (Ham_PlaysAnim<mode>())
+	{
+		CopCommand* move = copList.cmd + HamCop<mode>::Slot(kHamSlotPalette);
+
+		for (int i = 0; i < kAnimPaletteSize; i++)
+		{
+			move[i].data = sAnim.header->palette[i];
+		}
+
+		for (int i = 0; i < kScreenBuffers; i++)
+		{
+			Blitter_Wait(Mem_ClearChip(Ham_Bpl(i), kScreenSize));
+			Anim_Key(sAnim, (u8*) Ham_Bpl(i), kScreenPlaneSize);
+		}
+	}
+	else
+	#endif
+	{
+		Ham_CopyPattern<mode>(Ham_Bpl(0));
+
+		for (int i = 1; i < kScreenBuffers; i++)
+		{
+			Blitter_Wait(Mem_CopyChip(Ham_Bpl(i), Ham_Bpl(0), kScreenSize));
+		}
+	}
+
+	sFront = 0;
+	sQueued = -1;
+	sFlipWait = 0;
+	sBack = 1;
+	sFrame = 0;
+
+	for (int i = 0; i < kScreenBuffers; i++)
+	{
+		sWindow[i] = kHamFullWindow;
+	}
+
+	Ham_Show<mode>(sFront);
+
+	static_assert(kScreenBuffers >= 2 && kScreenBuffers <= countof(kBufferNames));
+
+	#if defined(SLICED)
+	static constexpr DmaConfig kSliceDma = {Traits::kPlanes, false, PackDdfstrt(0), PackDdfstop(kScreenWidth), 0, 0, 0};
+	static_assert(!Ham_IsSliced<mode>() || kSliceColors <= Dma_SliceMoves(kSliceDma, 0, kScreenWidth));
+	#endif
+
+	for (int i = 0; i < kScreenBuffers; i++)
+	{
+		debug_register_bitmap(Ham_Bpl(i), kBufferNames[i], kScreenWidth, kScreenLines, Traits::kPlanes, Bpl_DebugFlags(kLayout));
+	}
+	// The debugger only shows 12 bit palettes.
+	if (!Traits::kAga)
+	{
+		debug_register_palette(kPalette, "Palette", countof(kPalette), 0);
+	}
+
+	// The copper sets bplcon0, the window, the fetch and the modulos.
+	custom.bplcon0 = PackBplcon0(0, false, Traits::kHam);
+	custom.bplcon1 = PackBplcon1(0, 0);
+	custom.bplcon2 = PackBplcon2(false, 0);
+	custom.fmode   = Traits::kFmode;
+	custom.copcon  = 2;
+	custom.cop1lc  = (u32) copList.cmd;
+
+	if (Traits::kAga)
+	{
+		custom.bplcon3 = kBplcon3;
+		custom.bplcon4 = 0x0011;
+	}
+
+	System_WaitVbl();
+
+	custom.dmacon = DMAF_SETCLR | DMAF_COPPER | DMAF_RASTER | DMAF_MASTER;
+
+	System_AddVblCallback(Ham_Vbl<Ham_Show<mode>>);
+
+	#if defined(C2P)
+	if (Traits::kPlanes <= 6 && !Ham_PlaysAnim<mode>())
+	{
+		sChunky = Arena_New<u8>(kArenaFast, kChunkySize);
+		sC2pScratch = Arena_New<u8>(kArenaChip, kC2pScratchSize);
+
+		#if defined(DEBUG)
+		// With the display running, so the cost includes the bitplane DMA. Into
+		// the back buffer, which then gets its lines back.
+		const int benchLines = kLayout.interleaved ? 1 : kC2pBenchLines;
+		C2p_Benchmark(sChunky, (u8*) Ham_Bpl(sBack), Bpl_PlaneStep(kLayout), Traits::kPlanes, kScreenWidth, benchLines, sC2pScratch);
+		Ham_DrawPattern<mode>(Ham_Bpl(sBack), kScreenTop, benchLines, 0);
+		#endif
+
+		#if defined(HAMRT)
+		sRgb = Arena_New<u16>(kArenaFast, kHamRtWidth * kHamRtLines);
+
+		#if defined(DEBUG)
+		if (mode == kHamMode6)
+		{
+			HamRt_Benchmark(kHamRtTables, sRgb, sChunky, kHamRtWidth, kHamRtLines, kHamRtPixel, kHamRtPixel, sC2pScratch);
+		}
+		#endif
+		#endif
+
+		#if defined(HAMRT) && defined(DIRTY)
+		if (Ham_IsDirty<mode>())
+		{
+			static_assert(kChunkySize + kHamRtWidth * kHamRtLines * sizeof(u16) + kDirtyCodesSize + (kScreenBuffers + 1) * kDirtyRows * sizeof(DirtyLine) <= kArenaFastSize);
+
+			sCodes = Arena_New<u8>(kArenaFast, kDirtyCodesSize);
+			Dirty_Init(sDirtyFrame, Arena_New<DirtyLine>(kArenaFast, kDirtyRows), kScreenWidth, kDirtyRows);
+
+			for (int i = 0; i < kScreenBuffers; i++)
+			{
+				Dirty_Init(sDirtyPending[i], Arena_New<DirtyLine>(kArenaFast, kDirtyRows), kScreenWidth, kDirtyRows);
+			}
+
+			Ham_DirtyBegin<mode>();
+		}
+		#endif
+
+		Ham_DrawChunky<mode>(sFrame);
+		Blitter_ResetStats();
+	}
+	#endif
+
+	System_ResetPace();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_StopMode()
+{
+	System_RemoveVblCallback(Ham_Vbl<Ham_Show<mode>>);
+
+	// Nothing may still be drawing into or showing the buffers.
+	Blitter_Wait(Blitter_Fence());
+	System_WaitVbl();
+	custom.dmacon = DMAF_COPPER | DMAF_RASTER;
+
+	if (HamTraits<mode>::kAga)
+	{
+		custom.fmode = 0x0000;
+	}
+	else
+	{
+		debug_unregister(kPalette);
+	}
+
+	for (int i = 0; i < kScreenBuffers; i++)
+	{
+		debug_unregister(Ham_Bpl(i));
+	}
+
+	Arena_Reset(sModeMark);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+template<HamMode mode> static void Ham_UpdateMode()
+{
+	u16* bpl = Ham_Bpl(sBack);
+
+	#if defined(ANIM)
+	if (Ham_PlaysAnim<mode>())
+	{
+		PROFILE_BEGIN("anim");
+		Anim_Next(sAnim, (u8*) bpl, kScreenPlaneSize);
+		PROFILE_END("anim");
+	}
+	else
+	#endif
+	#if defined(C2P) && defined(HAMRT) && defined(DIRTY)
+	if (Ham_IsDirty<mode>())
+	{
+		Ham_DirtyUpdate<mode>((u8*) bpl, sFrame);
+	}
+	else
+	#endif
+	#if defined(C2P)
+	if (HamTraits<mode>::kPlanes <= 6)
+	{
+		PROFILE_BEGIN("c2p");
+		BlitterFence fence = Ham_ConvertBand<mode>((u8*) bpl);
+		PROFILE_END("c2p");
+
+		PROFILE_BEGIN("chunky");
+		Ham_DrawChunky<mode>(sFrame + 1);
+		PROFILE_END("chunky");
+
+		PROFILE_BEGIN("blit wait");
+		Blitter_Wait(fence);
+		PROFILE_END("blit wait");
+
+		#if defined(DEBUG)
+		if ((sFrame + 1) % kC2pStatsFrames == 0)
+		{
+			BlitterStats stats;
+			Blitter_GetStats(stats);
+			Blitter_ResetStats();
+
+			KPrintF("blitter: %ld jobs, busy %ld, waited %ld colour clocks per frame\n",
+				stats.jobs / kC2pStatsFrames, stats.busy / kC2pStatsFrames, stats.wait / kC2pStatsFrames);
+		}
+		#endif
+	}
+	else
+	#endif
+	{
+		PROFILE_BEGIN("pattern");
+		Ham_DrawPattern<mode>(bpl, kBandTop, kBandLines, sFrame);
+		PROFILE_END("pattern");
+	}
+
+	sWindow[sBack] = Ham_FrameWindow<mode>(sFrame);
+
+	Ham_EndFrame(kScreenBuffers);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Offsets for frame, as the sine of the column or row plus a phase.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_PlasmaOffsets(u8* offsets, int count, int step, int phase)
+{
+	for (int i = 0; i < count; i++)
+	{
+		offsets[i] = (u8) (128 + (Fix_Sin(i * step + phase) >> 8));
+	}
+}
+
+static void Ham_PlasmaBegin(HamPlasma& plasma, int frame)
+{
+	Ham_PlasmaOffsets(plasma.x, kCopperColumns, 29, frame * 9);
+	Ham_PlasmaOffsets(plasma.y, kCopperRows, 19, frame * -6);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// One word per pixel, into the first line of every row of the list.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_DrawPlasma(const HamPlasma& plasma, CopCommand* lines)
+{
+	for (int j = 0; j < kCopperRows; j++)
+	{
+		u16* data = CopChunky_Row(lines, kCopperPixelHeight, j);
+		const u16* colors = kPlasmaColors.value + plasma.y[j];
+
+		for (int i = 0; i < kCopperColumns; i++)
+		{
+			data[i * CopChunky_PixelStep(kCopperPixelWidth)] = colors[plasma.x[i]];
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Debug builds: the frame cost of the plasma both ways, written into the list
+// and replicated, and drawn as a 320 pixel wide HAM6 chunky screen that goes
+// through C2p_ConvertBlit in bands of kCopperBenchBand lines. The HAM figure
+// leaves out the DMA of its six planes, so the real gap is wider still.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+static void Ham_DrawPlasmaChunky(const HamPlasma& plasma, u8* chunky, int top, int lines)
+{
+	static_assert(kCopperPixelWidth % 4 == 0);
+
+	u32* dst = (u32*) chunky;
+
+	for (int j = top; j < top + lines; j++)
+	{
+		int y = plasma.y[j / kCopperPixelHeight];
+
+		for (int i = 0; i < kCopperColumns; i++)
+		{
+			u32 c = (u32) ((plasma.x[i] + y) >> 3);
+			c |= c << 8;
+			c |= c << 16;
+
+			for (int k = 0; k < kCopperPixelWidth / 4; k++)
+			{
+				*dst++ = c;
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Beam time in lines, for spans of a few frames.
+////////////////////////////////////////////////////////////////////////////////
+static int Ham_BenchLines()
+{
+	u32 frame;
+	int vpos;
+
+	do
+	{
+		frame = System_GetFrame();
+		vpos = System_GetVpos();
+	}
+	while (frame != System_GetFrame());
+
+	return (int) frame * 312 + vpos;
+}
+
+static void Ham_CopperBenchmark(CopCommand* lines)
+{
+	ArenaScope scope;
+
+	const int planeSize = kCopChunkyWidth / 8 * kCopperBenchBand;
+	u8* chunky = Arena_New<u8>(kArenaFast, kCopChunkyWidth * kCopperBenchBand);
+	u8* planes = Arena_New<u8>(kArenaChip, 6 * planeSize);
+	u8* scratch = Arena_New<u8>(kArenaChip, C2p_ScratchSize(kCopChunkyWidth, kCopperBenchBand));
+
+	HamPlasma plasma;
+	Ham_PlasmaBegin(plasma, 0);
+
+	System_WaitVbl();
+	int start = Ham_BenchLines();
+	Ham_DrawPlasma(plasma, lines);
+	Blitter_Wait(CopChunky_Replicate(lines, kCopperPixelHeight));
+	int copper = Ham_BenchLines() - start;
+
+	System_WaitVbl();
+	start = Ham_BenchLines();
+	for (int top = 0; top < kCopChunkyLines; top += kCopperBenchBand)
+	{
+		Ham_DrawPlasmaChunky(plasma, chunky, top, kCopperBenchBand);
+		C2p_ConvertBlit(chunky, planes, planeSize, 6, kCopChunkyWidth, kCopperBenchBand, scratch);
+	}
+	Blitter_Wait(Blitter_Fence());
+	int ham = Ham_BenchLines() - start;
+
+	KPrintF("copper chunky: %ldx%ld pixels in %ld scanlines a frame, HAM6 chunky and c2p %ld\n", kCopperColumns, kCopperRows, copper, ham);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Jumps the copper to the new list, which it starts from anyway at the next
+// frame. Before kFlipLine it is still waiting for the first line.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_SetCopper(int buffer)
+{
+	custom.cop1lc = (u32) sCopperLists[buffer];
+	custom.copjmp1 = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// No bitplane DMA, so the copper has every even cycle and the CPU and the
+// blitter every other one.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_StartCopper()
+{
+	static_assert(kCopChunkyWidth % kCopperPixelWidth == 0 && kCopperPixelWidth % kCopChunkyMovePixels == 0);
+	static_assert(kCopChunkyLines % kCopperPixelHeight == 0);
+	static_assert(kCopperLists * (sizeof(HamCopperList) + 8) + 6 * kCopChunkyWidth / 8 * kCopperBenchBand + kCopChunkyWidth * kCopperBenchBand * 2 <= kArenaChipSize);
+	static_assert(kCopperLists <= countof(kCopperNames));
+
+	sModeMark = Arena_Mark();
+
+	for (int i = 0; i < kCopperLists; i++)
+	{
+		HamCopperList& list = *Arena_New<HamCopperList>(kArenaChip);
+		list = HamCopperCop::kList;
+		sCopperLists[i] = list.cmd;
+
+		debug_register_copperlist(list.cmd, kCopperNames[i], sizeof(list), 0);
+	}
+
+	sFront = 0;
+	sQueued = -1;
+	sFlipWait = 0;
+	sBack = 1;
+	sFrame = 0;
+
+	custom.bplcon0 = PackBplcon0(0);
+	custom.fmode   = 0x0000;
+	custom.copcon  = 2;
+	custom.cop1lc  = (u32) sCopperLists[sFront];
+
+	System_WaitVbl();
+
+	custom.dmacon = DMAF_SETCLR | DMAF_COPPER | DMAF_MASTER;
+
+	System_AddVblCallback(Ham_Vbl<Ham_SetCopper>);
+
+	#if defined(DEBUG)
+	Ham_CopperBenchmark(sCopperLists[sBack] + HamCopperCop::Slot(kCopChunkySlotLines));
+	#endif
+
+	System_ResetPace();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_StopCopper()
+{
+	System_RemoveVblCallback(Ham_Vbl<Ham_SetCopper>);
+
+	Blitter_Wait(Blitter_Fence());
+	System_WaitVbl();
+	custom.dmacon = DMAF_COPPER;
+
+	for (int i = 0; i < kCopperLists; i++)
+	{
+		debug_unregister(sCopperLists[i]);
+	}
+
+	Arena_Reset(sModeMark);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The copies of the first lines have to be done before the list is queued.
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_UpdateCopper()
+{
+	CopCommand* lines = sCopperLists[sBack] + HamCopperCop::Slot(kCopChunkySlotLines);
+	HamPlasma plasma;
+
+	PROFILE_BEGIN("plasma");
+	Ham_PlasmaBegin(plasma, sFrame);
+	Ham_DrawPlasma(plasma, lines);
+	PROFILE_END("plasma");
+
+	PROFILE_BEGIN("replicate");
+	Blitter_Wait(CopChunky_Replicate(lines, kCopperPixelHeight));
+	PROFILE_END("replicate");
+
+	Ham_EndFrame(kCopperLists);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The one place the mode is switched on.
+////////////////////////////////////////////////////////////////////////////////
+struct HamModeFuncs
+{
+	const char* name;
+	bool aga;
+	void (*start)();
+	void (*stop)();
+	void (*update)();
+};
+
+#define HAM_MODE(mode, name) {name, HamTraits<mode>::kAga, Ham_StartMode<mode>, Ham_StopMode<mode>, Ham_UpdateMode<mode>}
+
+static const HamModeFuncs kHamModeFuncs[kHamModes] =
+{
+	HAM_MODE(kHamMode6, "HAM6"),
+	HAM_MODE(kHamMode5, "HAM5"),
+	HAM_MODE(kHamModeEhb, "EHB"),
+	HAM_MODE(kHamMode8, "HAM8"),
+	{"Copper chunky", false, Ham_StartCopper, Ham_StopCopper, Ham_UpdateCopper},
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Ham_Start(HamMode mode)
+{
+	KPrintF("ham: %s\n", kHamModeFuncs[mode].name);
+
+	sMode = mode;
+	kHamModeFuncs[mode].start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Ham_Init()
+{
+	#if defined(DEBUG)
+	{
+		static_assert(kMemBenchmarkSize <= kArenaChipSize);
+
+		ArenaScope scope;
+		Mem_Benchmark(Arena_New<u8>(kArenaChip, kMemBenchmarkSize));
+	}
+
+	{
+		static_assert(kBplBenchmarkSize <= kArenaChipSize);
+
+		ArenaScope scope;
+		Bpl_Benchmark(Arena_New<u8>(kArenaChip, kBplBenchmarkSize));
+	}
+	#endif
+
+	sModeButton = System_TestRMB();
+
+	Ham_Start(System_IsAGA() ? kHamMode8 : kHamMode6);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Ham_Deinit()
+{
+	kHamModeFuncs[sMode].stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Ham_Update()
+{
+	bool button = System_TestRMB();
+
+	if (button && !sModeButton)
+	{
+		int mode = sMode;
+
+		do
+		{
+			mode = (mode + 1) % kHamModes;
+		}
+		while (kHamModeFuncs[mode].aga && !System_IsAGA());
+
+		kHamModeFuncs[sMode].stop();
+		Ham_Start((HamMode) mode);
+	}
+
+	sModeButton = button;
+
+	kHamModeFuncs[sMode].update();
 }
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamrt.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hamrt.h"
+#include "system.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// hamrt_a.s
+////////////////////////////////////////////////////////////////////////////////
+extern "C" void HamRt_Line1(const u16* rgb, u8* codes, u32 width, const HamRtTables* tables, const short* hold);
+extern "C" void HamRt_Line2(const u16* rgb, u8* codes, u32 width, const HamRtTables* tables, const short* hold);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HamRt_ConvertSpan(const HamRtTables& tables, const u16* rgb, u8* codes, int width, int pixelWidth, const short* hold)
+{
+	assert(width > 0 && (pixelWidth == 1 || pixelWidth == 2));
+
+	if (pixelWidth == 1)
+	{
+		HamRt_Line1(rgb, codes, width, &tables, hold);
+	}
+	else
+	{
+		HamRt_Line2(rgb, codes, width, &tables, hold);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Doubled lines are the same codes, so they are copied rather than converted
+// again: a memcpy of a line costs a tenth of converting it.
+////////////////////////////////////////////////////////////////////////////////
+void HamRt_Convert(const HamRtTables& tables, const u16* rgb, u8* codes, int width, int height, int pixelWidth, int pixelHeight)
+{
+	assert(width > 0 && (pixelWidth == 1 || pixelWidth == 2) && (pixelHeight == 1 || pixelHeight == 2));
+
+	const int lineCodes = width * pixelWidth;
+
+	for (int y = 0; y < height; y++)
+	{
+		HamRt_ConvertSpan(tables, rgb, codes, width, pixelWidth, tables.hold[0]);
+
+		if (pixelHeight == 2)
+		{
+			memcpy(codes + lineCodes, codes, lineCodes);
+		}
+
+		rgb += width;
+		codes += lineCodes * pixelHeight;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+static int HamRt_Scanlines(int start)
+{
+	int lines = System_GetVpos() - start;
+	return (lines < 0) ? lines + 312 : lines;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Smooth hues with a little noise, so that the lines both set and modify.
+// The conversion starts on a fresh frame and has to finish within it.
+////////////////////////////////////////////////////////////////////////////////
+void HamRt_Benchmark(const HamRtTables& tables, u16* rgb, u8* codes, int width, int height, int pixelWidth, int pixelHeight, u8* expected)
+{
+	u32 seed = 0x2545f491;
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			seed = seed * 1103515245 + 12345;
+
+			int r = (x + y) * 15 / (width + height);
+			int g = abs(((x * 2 + y * 3) & 31) - 16) * 15 / 16;
+			int b = (y * 15 / height) ^ (int) ((seed >> 16) & 1);
+
+			rgb[y * width + x] = (u16) ((r << 8) | (g << 4) | b);
+		}
+	}
+
+	System_WaitVbl();
+	int start = System_GetVpos();
+	HamRt_Convert(tables, rgb, codes, width, height, pixelWidth, pixelHeight);
+	int lines = HamRt_Scanlines(start);
+
+	const int size = width * pixelWidth * height * pixelHeight;
+	HamRt_Reference(tables, rgb, expected, width, height, pixelWidth, pixelHeight);
+
+	// The second half of the first line again, from the hold colour there,
+	// has to come out the same.
+	const int half = width / 2;
+	short hold[3];
+	HamRt_ReferenceHold(tables, codes, half * pixelWidth, hold);
+	memset(codes + half * pixelWidth, 0xff, (width - half) * pixelWidth);
+	HamRt_ConvertSpan(tables, rgb + half, codes + half * pixelWidth, width - half, pixelWidth, hold);
+
+	bool ok = true;
+	for (int i = 0; i < size && ok; i++)
+	{
+		if (codes[i] != expected[i])
+		{
+			KPrintF("hamrt: code %ld differs\n", i);
+			ok = false;
+		}
+	}
+
+	KPrintF("hamrt: %ld pixel lines at %ldx%ld: %ld.%02ld scanlines per line\n",
+		width, pixelWidth, pixelHeight, lines / height, (lines * 100 / height) % 100);
+
+	assert(ok);
+}
+#endif
@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamrt.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+#include "hamrtref.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Real-time HAM6 conversion (see hamrtref.h): width x height 12 bit pixels
+// to (width * pixelWidth) x (height * pixelHeight) HAM6 codes, ready for
+// C2p_Convert or C2p_ConvertBlit. pixelWidth and pixelHeight are 1 or 2; the
+// loop costs the same per source pixel either way, so 2x2 converts a band
+// four times as high or as wide in the same time.
+//
+// tables are for the base colours the screen shows. For a constant palette
+// the compiler builds them (see ham.cpp); HamRt_ReferenceTables at runtime
+// takes around a second on a 68000.
+////////////////////////////////////////////////////////////////////////////////
+void HamRt_Convert(const HamRtTables& tables, const u16* rgb, u8* codes, int width, int height, int pixelWidth, int pixelHeight);
+
+////////////////////////////////////////////////////////////////////////////////
+// Part of a line again, width pixels into the codes from x on, starting from
+// the hold colour in front of x (see HamRt_ReferenceHold). To leave the codes
+// after it as they were, the span has to reach the next set (HamRt_NextSet).
+////////////////////////////////////////////////////////////////////////////////
+void HamRt_ConvertSpan(const HamRtTables& tables, const u16* rgb, u8* codes, int width, int pixelWidth, const short* hold);
+
+////////////////////////////////////////////////////////////////////////////////
+// Debug builds: checks the conversion, and a span of it, against
+// HamRt_Reference and prints the cost in scanlines per source line. rgb must
+// hold width x height pixels and is overwritten with a test pattern, as are the
+// codes; expected is scratch of the same size as the codes.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+void HamRt_Benchmark(const HamRtTables& tables, u16* rgb, u8* codes, int width, int height, int pixelWidth, int pixelHeight, u8* expected);
+#endif
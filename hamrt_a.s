@@ -0,0 +1,130 @@
+/*
+ * hamrt_a.s
+ *
+ * Real-time HAM6 conversion of one line, the greedy choice of hamrtref.h
+ * (see HamRt_ReferenceLine there for the result). Every pixel costs four
+ * table reads, three for the errors of the hold colour and one for the
+ * nearest base colour, and two compares to find the channel to modify.
+ *
+ * The hold colour is kept in d4-d6 as byte offsets into the error tables,
+ * hr * 2, hg * 2 and hb * 32, and the pixel doubled in d0, so that each error
+ * table index is the pixel masked and or'ed with a hold register.
+ */
+
+/* Offsets of the tables in HamRtTables, from set. */
+	.set	HOLD, -128
+	.set	ERRORR, 8192
+	.set	ERRORG, ERRORR + 0xf90 * 2
+	.set	ERRORB, ERRORG + 0x100 * 2
+
+/* Stores the code in d0, pixelWidth times. */
+	.macro	STORE width
+	moveb	d0, a1@+
+	.if	\width == 2
+	moveb	d0, a1@+
+	.endif
+	.endm
+
+/*
+ * void HamRt_Line1(const u16* rgb, u8* codes, u32 width, const HamRtTables* tables, const short* hold)
+ * void HamRt_Line2(const u16* rgb, u8* codes, u32 width, const HamRtTables* tables, const short* hold)
+ *
+ * width pixels to width (2 * width) codes, from the hold colour in the
+ * three words at hold, as in HamRtTables.hold: base colour 0 for a whole
+ * line. width must be at least 1. Around 210 (220) cycles a pixel without
+ * DMA contention, see m68kbench.
+ */
+	.macro	HAMRT_LINE width
+	moveml	d2-d7/a2-a5, sp@-
+	movel	sp@(44), a0		/* rgb */
+	movel	sp@(48), a1		/* codes */
+	movel	sp@(52), d7		/* width */
+	movel	sp@(56), a2		/* tables */
+	movel	sp@(60), a3		/* hold */
+	movew	a3@, d4			/* hold colour */
+	movew	a3@(2), d5
+	movew	a3@(4), d6
+	lea	a2@(-HOLD), a2		/* set */
+	lea	a2@(ERRORR), a3
+	lea	a2@(ERRORG), a4
+	lea	a2@(ERRORB), a5
+	subql	#1, d7
+
+1:	movew	a0@+, d0
+	addw	d0, d0
+	movew	d0, d1
+	moveb	d4, d1
+	movew	a3@(0,d1:w), d1		/* er */
+	movew	d0, d2
+	andw	#0x1e0, d2
+	orw	d5, d2
+	movew	a4@(0,d2:w), d2		/* eg */
+	movew	d0, d3
+	andw	#0x1e, d3
+	orw	d6, d3
+	movew	a5@(0,d3:w), d3		/* eb */
+	movew	a2@(0,d0:w), d0		/* set */
+
+	cmpw	d2, d1
+	jhi	4f
+	cmpw	d2, d3
+	jhi	5f
+
+	addw	d3, d1			/* green: set < er + eb */
+	cmpw	d1, d0
+	jlt	2f
+	moveb	a0@(-1), d5		/* gb */
+	lsrb	#4, d5
+	moveq	#0x30, d0
+	orb	d5, d0
+	STORE	\width
+	addw	d5, d5
+	dbra	d7, 1b
+	jra	3f
+
+2:	moveq	#15, d1			/* set */
+	andw	d1, d0
+	STORE	\width
+	lslw	#3, d0
+	movew	a2@(HOLD,d0:w), d4
+	movew	a2@(HOLD + 2,d0:w), d5
+	movew	a2@(HOLD + 4,d0:w), d6
+	dbra	d7, 1b
+	jra	3f
+
+4:	cmpw	d1, d3
+	jhi	5f
+	addw	d3, d2			/* red: set < eg + eb */
+	cmpw	d2, d0
+	jlt	2b
+	moveb	a0@(-2), d4		/* 0r */
+	moveq	#0x20, d0
+	orb	d4, d0
+	STORE	\width
+	addw	d4, d4
+	dbra	d7, 1b
+	jra	3f
+
+5:	addw	d2, d1			/* blue: set < er + eg */
+	cmpw	d1, d0
+	jlt	2b
+	moveb	a0@(-1), d6		/* gb */
+	moveq	#15, d0
+	andw	d0, d6
+	moveq	#0x10, d0
+	orb	d6, d0
+	STORE	\width
+	lslw	#5, d6
+	dbra	d7, 1b
+
+3:	moveml	sp@+, d2-d7/a2-a5
+	rts
+	.endm
+
+	.globl	HamRt_Line1
+HamRt_Line1:
+	HAMRT_LINE 1
+
+	.globl	HamRt_Line2
+HamRt_Line2:
+	HAMRT_LINE 2
@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamrtref.h
+//
+// Real-time HAM6 conversion, shared by the 68000 line loops in hamrt_a.s, the
+// C++ around them and the host-side tools, with a portable reference. Pixels
+// are 12 bit 0x0rgb words; out come HAM6 pixel codes, one byte each, for
+// c2p.
+//
+// A line starts with the hold colour at base colour 0 and takes every pixel
+// greedily, from lookup tables built for the palette. With er, eg and eb the
+// weighted squared errors of the channels of the hold colour, modifying the
+// channel with the largest (ties going to green, then red) leaves the other
+// two; setting the nearest base colour leaves its own error, and wins ties.
+// hamconv -rt measures what that costs against its optimal search.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kHamRtColors		= 4096;
+static const int kHamRtPaletteSize	= 16;
+static const int kHamRtWeightR		= 3;
+static const int kHamRtWeightG		= 4;
+static const int kHamRtWeightB		= 2;
+
+static const int kHamRtSet			= 0x00;
+static const int kHamRtModifyB		= 0x10;
+static const int kHamRtModifyR		= 0x20;
+static const int kHamRtModifyG		= 0x30;
+
+////////////////////////////////////////////////////////////////////////////////
+// The tables for one palette, as native words. Errors are 16 * w * d * d, at
+// most 32400 for a whole colour.
+//
+//   hold       hr * 2, hg * 2, hb * 32 and a pad word for every base colour:
+//              the hold colour as hamrt_a.s keeps it, byte offsets into the
+//              error tables below
+//   set        for every 0x0rgb, the error of the nearest base colour less
+//              16, plus its index: set < er + eb (say) is true exactly when
+//              setting is no worse than modifying green
+//   errorR     [(rgb & 0xf80) | hr], the low bit of green in the index only
+//              so that hamrt_a.s can build it with one byte move
+//   errorG     [(rgb & 0x0f0) | hg]
+//   errorB     [(hb << 4) | (rgb & 0x00f)]
+//
+// hamrt_a.s depends on this layout.
+////////////////////////////////////////////////////////////////////////////////
+struct HamRtTables
+{
+	short hold[kHamRtPaletteSize][4];
+	short set[kHamRtColors];
+	short errorR[0xf90];
+	short errorG[0x100];
+	short errorB[0x100];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Cheap enough to run at compile time, for a constant palette.
+////////////////////////////////////////////////////////////////////////////////
+inline constexpr void HamRt_ReferenceTables(HamRtTables& tables, const unsigned short* palette)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		for (int j = 0; j < 16; j++)
+		{
+			int d = (i - j) * (i - j) * 16;
+
+			for (int g = 0; g < 0x100; g += 0x80)
+			{
+				tables.errorR[(i << 8) | g | j] = (short) (kHamRtWeightR * d);
+			}
+
+			tables.errorG[(i << 4) | j] = (short) (kHamRtWeightG * d);
+			tables.errorB[(i << 4) | j] = (short) (kHamRtWeightB * d);
+		}
+	}
+
+	for (int i = 0; i < kHamRtPaletteSize; i++)
+	{
+		tables.hold[i][0] = (short) ((palette[i] >> 8 & 15) << 1);
+		tables.hold[i][1] = (short) ((palette[i] >> 4 & 15) << 1);
+		tables.hold[i][2] = (short) ((palette[i] & 15) << 5);
+		tables.hold[i][3] = 0;
+	}
+
+	for (int rgb = 0; rgb < kHamRtColors; rgb++)
+	{
+		int best = 0x7fff;
+
+		for (int i = 0; i < kHamRtPaletteSize; i++)
+		{
+			int error = tables.errorR[(rgb & 0xf00) | (tables.hold[i][0] >> 1)] + tables.errorG[(rgb & 0x0f0) | (tables.hold[i][1] >> 1)] + tables.errorB[(tables.hold[i][2] >> 1) | (rgb & 0x00f)];
+
+			if (error - 16 + i < best)
+			{
+				best = error - 16 + i;
+			}
+		}
+
+		tables.set[rgb] = (short) best;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// One line of width pixels, each written pixelWidth times, 1 or 2. A line
+// starts from base colour 0; the rest of one from the hold colour of
+// HamRt_ReferenceHold.
+////////////////////////////////////////////////////////////////////////////////
+inline void HamRt_ReferenceLine(const HamRtTables& tables, const unsigned short* rgb, unsigned char* codes, int width, int pixelWidth, const short* hold = nullptr)
+{
+	if (hold == nullptr)
+	{
+		hold = tables.hold[0];
+	}
+
+	int hr = hold[0] >> 1;
+	int hg = hold[1] >> 1;
+	int hb = hold[2] >> 1;
+
+	for (int x = 0; x < width; x++)
+	{
+		int t = rgb[x];
+		int er = tables.errorR[(t & 0xf80) | hr];
+		int eg = tables.errorG[(t & 0x0f0) | hg];
+		int eb = tables.errorB[hb | (t & 0x00f)];
+		int set = tables.set[t];
+		int code;
+
+		if (er > eg && er >= eb)
+		{
+			code = (set < eg + eb) ? kHamRtSet : kHamRtModifyR;
+		}
+		else if (eb > eg)
+		{
+			code = (set < er + eg) ? kHamRtSet : kHamRtModifyB;
+		}
+		else
+		{
+			code = (set < er + eb) ? kHamRtSet : kHamRtModifyG;
+		}
+
+		switch (code)
+		{
+		case kHamRtSet:
+			code = set & 15;
+			hr = tables.hold[code][0] >> 1;
+			hg = tables.hold[code][1] >> 1;
+			hb = tables.hold[code][2] >> 1;
+			break;
+
+		case kHamRtModifyR:
+			hr = t >> 8;
+			code |= hr;
+			break;
+
+		case kHamRtModifyG:
+			hg = t >> 4 & 15;
+			code |= hg;
+			break;
+
+		default:
+			hb = (t & 15) << 4;
+			code |= t & 15;
+			break;
+		}
+
+		for (int i = 0; i < pixelWidth; i++)
+		{
+			*codes++ = (unsigned char) code;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The hold colour in front of code x of a line, as the display has it there,
+// in the three words of HamRtTables.hold: from the last set before x, or base
+// colour 0, with the modifies since.
+////////////////////////////////////////////////////////////////////////////////
+inline void HamRt_ReferenceHold(const HamRtTables& tables, const unsigned char* codes, int x, short* hold)
+{
+	int i = x - 1;
+	while (i >= 0 && (codes[i] & 0x30) != kHamRtSet)
+	{
+		i--;
+	}
+
+	const short* base = tables.hold[(i >= 0) ? codes[i] : 0];
+	hold[0] = base[0];
+	hold[1] = base[1];
+	hold[2] = base[2];
+
+	for (i++; i < x; i++)
+	{
+		int value = codes[i] & 15;
+
+		switch (codes[i] & 0x30)
+		{
+		case kHamRtModifyR:
+			hold[0] = (short) (value << 1);
+			break;
+
+		case kHamRtModifyG:
+			hold[1] = (short) (value << 1);
+			break;
+
+		default:
+			hold[2] = (short) (value << 5);
+			break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The first set at or after code x of a line of width codes, or width. A set
+// does not depend on the codes in front of it, so converting again from x up
+// to there changes nothing after it.
+////////////////////////////////////////////////////////////////////////////////
+inline int HamRt_NextSet(const unsigned char* codes, int x, int width)
+{
+	while (x < width && (codes[x] & 0x30) != kHamRtSet)
+	{
+		x++;
+	}
+
+	return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// width x height pixels to (width * pixelWidth) x (height * pixelHeight)
+// codes, pixelWidth and pixelHeight 1 or 2.
+////////////////////////////////////////////////////////////////////////////////
+inline void HamRt_Reference(const HamRtTables& tables, const unsigned short* rgb, unsigned char* codes, int width, int height, int pixelWidth, int pixelHeight)
+{
+	const int lineCodes = width * pixelWidth;
+
+	for (int y = 0; y < height; y++)
+	{
+		for (int i = 0; i < pixelHeight; i++)
+		{
+			HamRt_ReferenceLine(tables, rgb + y * width, codes + (y * pixelHeight + i) * lineCodes, width, pixelWidth);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////
+// lz.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lz.h"
+#include "system.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// lz_a.s
+////////////////////////////////////////////////////////////////////////////////
+extern "C" void Lz_Decode(LzStream* stream, u8* limit);
+
+////////////////////////////////////////////////////////////////////////////////
+// Raster lines since some frame. The VBL interrupt bumps the frame counter
+// around vpos 0, so the pair is read again if the counter moved meanwhile.
+////////////////////////////////////////////////////////////////////////////////
+static u32 Lz_GetLine()
+{
+	for (;;)
+	{
+		u32 frame = System_GetFrame();
+		int vpos = System_GetVpos();
+
+		if (System_GetFrame() == frame)
+		{
+			return frame * 313 + (u32) vpos;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Lz_Begin(LzStream& stream, const u8* packed, void* dst)
+{
+	stream.src = packed + kLzHeaderSize;
+	stream.dst = (u8*) dst;
+	stream.end = stream.dst + Lz_Size(packed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Lz_Depack(LzStream& stream, int lines)
+{
+	u32 start = Lz_GetLine();
+
+	while (stream.dst < stream.end)
+	{
+		u8* limit = ((u32) (stream.end - stream.dst) > kLzChunk) ? stream.dst + kLzChunk : stream.end;
+		Lz_Decode(&stream, limit);
+
+		if ((int) (Lz_GetLine() - start) >= lines)
+		{
+			break;
+		}
+	}
+
+	return stream.dst >= stream.end;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Lz_DepackAll(const u8* packed, void* dst)
+{
+	LzStream stream;
+	Lz_Begin(stream, packed, dst);
+	Lz_Decode(&stream, stream.end);
+}
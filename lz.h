@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////
+// lz.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+#include "lzref.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Streaming depacker for assets packed with tools/lzpack, e.g. INCBIN data
+// unpacked straight into sScreenBpl. Lz_Begin sets up a stream; Lz_Depack
+// then unpacks chunks of kLzChunk bytes until lines raster lines have gone
+// by, and can be called once per frame next to a running effect until it
+// returns true. The budget is checked between chunks, so a call overruns it
+// by one chunk and the sequence running over its end: around 8 lines for
+// typical data, and the "max" column of lzpack -bench bounds the sequence.
+// Lz_DepackAll does the whole asset in one go.
+//
+// The destination must have room for Lz_Size bytes and must not be read
+// past stream.dst while the stream is still running.
+////////////////////////////////////////////////////////////////////////////////
+static const u32 kLzChunk = 256;
+
+struct LzStream
+{
+	const u8* src;
+	u8* dst;
+	u8* end;
+};
+
+inline u32 Lz_Size(const u8* packed) { return Lz_ReferenceSize(packed); }
+
+void Lz_Begin(LzStream& stream, const u8* packed, void* dst);
+bool Lz_Depack(LzStream& stream, int lines);
+void Lz_DepackAll(const u8* packed, void* dst);
@@ -0,0 +1,130 @@
+/*
+ * lz_a.s
+ *
+ * 68000 depacker for the format in lzref.h. Lengths fit in a word and come
+ * in whole bytes, so the loop has no bit buffer and no 32 bit arithmetic.
+ * Copies of 8 bytes and more go a long at a time when source and
+ * destination have the same parity, which for a match means an even offset
+ * of 4 or more; lzpack prefers those. Everything else is a byte at a time.
+ */
+
+/*
+ * len bytes from src@+ to a1@+, len a word. Trashes d0, d4 and len. A match
+ * closer than 4 bytes must not come here with 8 bytes or more.
+ */
+	.macro	COPY src, len
+	cmpw	#8, \len
+	jcs	.Lcopy6\@
+	movew	\src, d0
+	movew	a1, d4
+	eorw	d4, d0
+	lsrw	#1, d0
+	jcs	.Lcopy3\@
+	lsrw	#1, d4
+	jcc	.Lcopy0\@
+	moveb	\src@+, a1@+
+	subqw	#1, \len
+.Lcopy0\@:
+	movew	\len, d4
+	lsrw	#2, \len
+	jra	.Lcopy2\@
+.Lcopy1\@:
+	movel	\src@+, a1@+
+.Lcopy2\@:
+	dbra	\len, .Lcopy1\@
+	btst	#1, d4
+	jeq	.Lcopy9\@
+	movew	\src@+, a1@+
+	jra	.Lcopy9\@
+.Lcopy3\@:
+	movew	\len, d4
+	lsrw	#2, \len
+	jra	.Lcopy5\@
+.Lcopy4\@:
+	moveb	\src@+, a1@+
+	moveb	\src@+, a1@+
+	moveb	\src@+, a1@+
+	moveb	\src@+, a1@+
+.Lcopy5\@:
+	dbra	\len, .Lcopy4\@
+	btst	#1, d4
+	jeq	.Lcopy9\@
+	moveb	\src@+, a1@+
+	moveb	\src@+, a1@+
+	jra	.Lcopy9\@
+.Lcopy7\@:
+	moveb	\src@+, a1@+
+.Lcopy6\@:
+	dbra	\len, .Lcopy7\@
+	jra	.Lcopy10\@
+.Lcopy9\@:
+	btst	#0, d4
+	jeq	.Lcopy10\@
+	moveb	\src@+, a1@+
+.Lcopy10\@:
+	.endm
+
+/*
+ * void Lz_Decode(LzStream* stream, u8* limit)
+ *
+ * Unpacks whole sequences from stream->src to stream->dst until dst has
+ * reached limit, then stores both back. limit must not be past stream->end;
+ * the last sequence can run up to kLzMaxSequence - 1 bytes over it.
+ */
+	.globl	Lz_Decode
+Lz_Decode:
+	moveml	d2-d4/a2-a3, sp@-
+	movel	sp@(24), a3		/* stream */
+	movel	sp@(28), d3		/* limit */
+	movel	a3@, a0			/* src */
+	movel	a3@(4), a1		/* dst */
+	jra	.Lnext
+
+.Lsequence:
+	moveq	#0, d2
+	moveb	a0@+, d2		/* token */
+	movew	d2, d1
+	lsrw	#4, d1			/* literals */
+	cmpw	#15, d1
+	jne	.Lliterals
+	moveq	#0, d0
+	moveb	a0@+, d0
+	addw	d0, d1
+.Lliterals:
+	COPY	a0, d1
+
+	moveq	#0, d0
+	moveb	a0@+, d0
+	lslw	#8, d0
+	moveb	a0@+, d0		/* offset */
+	tstw	d0
+	jeq	.Lnext
+	movel	a1, a2
+	subal	d0, a2			/* match */
+	andw	#15, d2
+	cmpw	#15, d2
+	jne	.Lmatch
+	moveq	#0, d1
+	moveb	a0@+, d1
+	addw	d1, d2
+.Lmatch:
+	addqw	#4, d2			/* length, kLzMinMatch */
+	cmpw	#4, d0
+	jcs	.Lrun
+	COPY	a2, d2
+	jra	.Lnext
+
+.Lrun:
+	subqw	#1, d2
+.Lrun1:
+	moveb	a2@+, a1@+
+	dbra	d2, .Lrun1
+
+.Lnext:
+	cmpal	d3, a1
+	jcs	.Lsequence
+
+	movel	a0, a3@
+	movel	a1, a3@(4)
+	moveml	sp@+, d2-d4/a2-a3
+	rts
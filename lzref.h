@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzref.h
+//
+// The packed asset format, shared by the 68000 depacker in lz_a.s and the host
+// packer in tools/lzpack, with a portable reference depacker. A packed asset
+// is the unpacked size as a big endian long, then sequences of
+//
+//   token         literals in the high nibble, match length - kLzMinMatch
+//                 in the low one
+//   [extra]       when the literal nibble is 15, a byte added to it
+//   literals
+//   offset        big endian word, 0 for a sequence without a match
+//   [extra]       when there is a match and its nibble is 15, a byte added
+//
+// up to the unpacked size. A match copies from offset bytes back in the
+// output, overlapping forwards. Everything is whole bytes with at most one
+// extra byte per length, so the 68000 never shifts bits in and out of a
+// buffer and a sequence is never longer than kLzMaxSequence.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kLzHeaderSize	= 4;
+static const int kLzMinMatch	= 4;
+static const int kLzMaxLiterals = 15 + 255;
+static const int kLzMaxMatch	= kLzMinMatch + 15 + 255;
+static const int kLzMaxOffset	= 65535;
+static const int kLzMaxSequence = kLzMaxLiterals + kLzMaxMatch;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline unsigned int Lz_ReferenceSize(const unsigned char* packed)
+{
+	return ((unsigned int) packed[0] << 24) | ((unsigned int) packed[1] << 16) | ((unsigned int) packed[2] << 8) | packed[3];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Unpacks the whole asset into dst, returning the number of packed bytes.
+////////////////////////////////////////////////////////////////////////////////
+inline unsigned int Lz_Reference(const unsigned char* packed, unsigned char* dst)
+{
+	const unsigned char* src = packed + kLzHeaderSize;
+	unsigned char* end = dst + Lz_ReferenceSize(packed);
+
+	while (dst < end)
+	{
+		int token = *src++;
+		int literals = token >> 4;
+
+		if (literals == 15)
+		{
+			literals += *src++;
+		}
+
+		for (int i = 0; i < literals; i++)
+		{
+			*dst++ = *src++;
+		}
+
+		int offset = (src[0] << 8) | src[1];
+		src += 2;
+
+		if (offset != 0)
+		{
+			int length = token & 15;
+
+			if (length == 15)
+			{
+				length += *src++;
+			}
+
+			const unsigned char* match = dst - offset;
+
+			for (int i = 0; i < length + kLzMinMatch; i++)
+			{
+				*dst++ = *match++;
+			}
+		}
+	}
+
+	return (unsigned int) (src - packed);
+}
@@ -2,8 +2,10 @@
 // main.cpp
 ////////////////////////////////////////////////////////////////////////////////
 
+#include "blitter.h"
 #include "core.h"
 #include "ham.h"
+#include "profile.h"
 #include "system.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -12,16 +14,21 @@ int main()
 {
 	if (System_Init())
 	{
+		Blitter_Init();
+
 		if (Ham_Init())
 		{
 			while (!System_TestLMB())
 			{
 				Ham_Update();
+
+				PROFILE_UPDATE();
 			}
 
 			Ham_Deinit();
 		}
 
+		Blitter_Deinit();
 		System_Deinit();
 	}
 }
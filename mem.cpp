@@ -0,0 +1,316 @@
+////////////////////////////////////////////////////////////////////////////////
+// mem.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mem.h"
+#include <exec/memory.h>
+#include <hardware/custom.h>
+#include "system.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// words from an even address; a null src clears.
+////////////////////////////////////////////////////////////////////////////////
+static BlitterFence Mem_Blit(u8* dst, const u8* src, u32 words)
+{
+	assert(((u32) dst & 1) == 0);
+
+	BlitterFence fence = Blitter_Fence();
+
+	while (words != 0)
+	{
+		const MemBlit blit = Mem_NextBlit(words);
+		const u32 bytes = blit.words * blit.lines * 2;
+
+		if (src != nullptr)
+		{
+			fence = Blitter_Copy(dst, 0, src, 0, blit.words, blit.lines);
+			src += bytes;
+		}
+		else
+		{
+			fence = Blitter_Clear(dst, 0, blit.words, blit.lines);
+		}
+
+		dst += bytes;
+		words -= blit.words * blit.lines;
+	}
+
+	return fence;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Mem_ClearChip(void* dst, u32 size)
+{
+	u8* d = (u8*) dst;
+	const MemSplit split = Mem_Split((u32) d, (u32) d, size);
+
+	if (split.words == 0)
+	{
+		memset(d, 0, size);
+		return Blitter_Fence();
+	}
+
+	assert((TypeOfMem(dst) & MEMF_CHIP) != 0);
+
+	if (split.head != 0)
+	{
+		d[0] = 0;
+	}
+
+	if (split.tail != 0)
+	{
+		d[size - 1] = 0;
+	}
+
+	return Mem_Blit(d + split.head, nullptr, split.words);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Mem_CopyChip(void* dst, const void* src, u32 size)
+{
+	u8* d = (u8*) dst;
+	const u8* s = (const u8*) src;
+	const MemSplit split = Mem_Split((u32) d, (u32) s, size);
+
+	if (split.words == 0)
+	{
+		memcpy(d, s, size);
+		return Blitter_Fence();
+	}
+
+	assert((TypeOfMem(dst) & MEMF_CHIP) != 0 && (TypeOfMem((APTR) src) & MEMF_CHIP) != 0);
+	assert(d + size <= s || s + size <= d);
+
+	if (split.head != 0)
+	{
+		d[0] = s[0];
+	}
+
+	if (split.tail != 0)
+	{
+		d[size - 1] = s[size - 1];
+	}
+
+	return Mem_Blit(d + split.head, s + split.head, split.words);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+
+////////////////////////////////////////////////////////////////////////////////
+// The buffer holds Mem_Pattern of each byte's offset, so every byte after a
+// call can be checked without a second buffer. The copies read from kMemSrc
+// onwards and write from kMemDst onwards, kMemGuard bytes either side of the
+// destination are checked to be untouched.
+////////////////////////////////////////////////////////////////////////////////
+static const u32 kMemGuard		 = 8;
+static const u32 kMemDst		 = 16;
+static const u32 kMemSrc		 = kMemBenchmarkSize / 2;
+static const u32 kMemCheckSizes	 = 72;
+static const u32 kMemBenchBytes	 = 8 * 1024;
+static const u32 kMemFrameClocks = 313 * 227;
+
+static const u32 kMemLargeSizes[] = {255, 256, 257, 300, 1023, 1024, 1025, 1151, 8192 + 129};
+static const int kMemMoveOffsets[] = {-17, -4, -1, 1, 3, 16};
+static const u32 kMemBenchSizes[] = {16, 64, 256, 1024, 4096, 8192};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u8 Mem_Pattern(u32 offset)
+{
+	return (u8) (offset * 7 + (offset >> 8) * 13 + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// size bytes at dst must be value, or the pattern from src if src >= 0.
+// Puts the pattern back.
+////////////////////////////////////////////////////////////////////////////////
+static bool Mem_Check(u8* buffer, u32 dst, u32 size, int src, u8 value)
+{
+	bool ok = true;
+
+	for (u32 i = dst - kMemGuard; i < dst + size + kMemGuard; i++)
+	{
+		u8 expected = Mem_Pattern(i);
+
+		if (i >= dst && i < dst + size)
+		{
+			expected = (src >= 0) ? Mem_Pattern(src + (i - dst)) : value;
+		}
+
+		ok = ok && (buffer[i] == expected);
+		buffer[i] = Mem_Pattern(i);
+	}
+
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool Mem_CheckSize(u8* buffer, u32 size, u32 dstAlign, u32 srcAlign)
+{
+	u32 dst = kMemDst + dstAlign;
+	u32 src = kMemSrc + srcAlign;
+	bool ok = true;
+
+	ok = ok && (memset(buffer + dst, 0xa5, size) == buffer + dst);
+	ok = ok && Mem_Check(buffer, dst, size, -1, 0xa5);
+
+	ok = ok && (memcpy(buffer + dst, buffer + src, size) == buffer + dst);
+	ok = ok && Mem_Check(buffer, dst, size, (int) src, 0);
+
+	for (int i = 0; i < countof(kMemMoveOffsets); i++)
+	{
+		u32 to = src + kMemMoveOffsets[i] + dstAlign - srcAlign;
+
+		ok = ok && (memmove(buffer + to, buffer + src, size) == buffer + to);
+		ok = ok && Mem_Check(buffer, to, size, (int) src, 0);
+	}
+
+	if (size >= kMemBlitMin)
+	{
+		Blitter_Wait(Mem_ClearChip(buffer + dst, size));
+		ok = ok && Mem_Check(buffer, dst, size, -1, 0);
+
+		Blitter_Wait(Mem_CopyChip(buffer + dst, buffer + src, size));
+		ok = ok && Mem_Check(buffer, dst, size, (int) src, 0);
+	}
+
+	if (!ok)
+	{
+		KPrintF("mem: failed at %ld bytes, dst+%ld src+%ld\n", size, dstAlign, srcAlign);
+	}
+
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Mem_Clock()
+{
+	volatile u32* vpos = (u32*) &custom.vposr;
+
+	u32 vhpos = *vpos;
+	return (((vhpos >> 8) & 0x1ff) * 227 + (vhpos & 0xff));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Mem_BenchSet(u8* dst, const u8*, u32 size)
+{
+	memset(dst, 0x5a, size);
+}
+
+static void Mem_BenchCopy(u8* dst, const u8* src, u32 size)
+{
+	memcpy(dst, src, size);
+}
+
+static void Mem_BenchMove(u8* dst, const u8* src, u32 size)
+{
+	// Overlapping with the destination above, so backwards.
+	memmove(dst - kMemDst + kMemSrc + 4, src, size);
+}
+
+static void Mem_BenchClearChip(u8* dst, const u8*, u32 size)
+{
+	Blitter_Wait(Mem_ClearChip(dst, size));
+}
+
+static void Mem_BenchCopyChip(u8* dst, const u8* src, u32 size)
+{
+	Blitter_Wait(Mem_CopyChip(dst, src, size));
+}
+
+struct MemBench
+{
+	const char* name;
+	void (*func)(u8* dst, const u8* src, u32 size);
+};
+
+static const MemBench kMemBenches[] =
+{
+	{"memset      ", Mem_BenchSet},
+	{"memcpy      ", Mem_BenchCopy},
+	{"memmove     ", Mem_BenchMove},
+	{"ClearChip   ", Mem_BenchClearChip},
+	{"CopyChip    ", Mem_BenchCopyChip},
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Hundredths of a cycle per byte. Starts on a fresh frame and stays within
+// it, kMemBenchBytes at the slowest rate being well under a frame.
+////////////////////////////////////////////////////////////////////////////////
+static u32 Mem_Time(const MemBench& bench, u8* buffer, u32 size, u32 dstAlign, u32 srcAlign)
+{
+	u32 reps = max(kMemBenchBytes / size, 1u);
+
+	System_WaitVbl();
+	u32 start = Mem_Clock();
+
+	for (u32 i = 0; i < reps; i++)
+	{
+		bench.func(buffer + kMemDst + dstAlign, buffer + kMemSrc + srcAlign, size);
+	}
+
+	u32 end = Mem_Clock();
+	u32 clocks = (end >= start) ? end - start : end + kMemFrameClocks - start;
+
+	// Two CPU cycles per colour clock.
+	return clocks * 200 / (reps * size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Mem_Benchmark(u8* buffer)
+{
+	static_assert(kMemSrc >= kMemDst + 8192 + 129 + kMemGuard + 4);
+
+	for (u32 i = 0; i < kMemBenchmarkSize; i++)
+	{
+		buffer[i] = Mem_Pattern(i);
+	}
+
+	warpmode(true);
+
+	bool ok = true;
+
+	for (u32 dstAlign = 0; dstAlign < 4; dstAlign++)
+	{
+		for (u32 srcAlign = 0; srcAlign < 4; srcAlign++)
+		{
+			for (u32 size = 0; size < kMemCheckSizes; size++)
+			{
+				ok = Mem_CheckSize(buffer, size, dstAlign, srcAlign) && ok;
+			}
+
+			for (int i = 0; i < countof(kMemLargeSizes); i++)
+			{
+				ok = Mem_CheckSize(buffer, kMemLargeSizes[i], dstAlign, srcAlign) && ok;
+			}
+		}
+	}
+
+	warpmode(false);
+
+	for (int i = 0; i < countof(kMemBenches); i++)
+	{
+		for (int j = 0; j < countof(kMemBenchSizes); j++)
+		{
+			u32 size = kMemBenchSizes[j];
+			u32 even = Mem_Time(kMemBenches[i], buffer, size, 0, 0);
+			u32 odd = Mem_Time(kMemBenches[i], buffer, size, 1, 1);
+			u32 mixed = Mem_Time(kMemBenches[i], buffer, size, 0, 1);
+
+			KPrintF("mem: %s %5ld bytes: %ld.%02ld %ld.%02ld %ld.%02ld cycles per byte (+0/+0 +1/+1 +0/+1)\n", kMemBenches[i].name, size,
+				even / 100, even % 100, odd / 100, odd % 100, mixed / 100, mixed % 100);
+		}
+	}
+
+	assert(ok);
+}
+
+#endif
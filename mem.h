@@ -0,0 +1,33 @@
+////////////////////////////////////////////////////////////////////////////////
+// mem.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "blitter.h"
+#include "core.h"
+#include "memsplit.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Large chip RAM clears and copies through the blitter queue. The blitter
+// takes the word aligned middle, 64 words a line; the CPU does the odd bytes
+// at either end before returning. The fence is the one to wait for before
+// touching the area, and once it is done System_WaitBlt returns straight away
+// too. Below kMemBlitMin bytes, and for copies where one address is odd and
+// the other even, it is all memset/memcpy (see memsplit.h). The areas must
+// not overlap.
+////////////////////////////////////////////////////////////////////////////////
+BlitterFence Mem_ClearChip(void* dst, u32 size);
+BlitterFence Mem_CopyChip(void* dst, const void* src, u32 size);
+
+////////////////////////////////////////////////////////////////////////////////
+// Debug builds: checks memset, memcpy, memmove and the two above byte by byte,
+// for small sizes at every alignment and a few large ones, then prints cycles
+// per byte for a range of sizes and alignments. buffer is chip RAM of at least
+// kMemBenchmarkSize bytes and is overwritten.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+static const u32 kMemBenchmarkSize = 40 * 1024;
+
+void Mem_Benchmark(u8* buffer);
+#endif
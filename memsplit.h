@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+// memsplit.h
+//
+// How Mem_ClearChip and Mem_CopyChip divide an area between the CPU and the
+// blitter, shared by mem.cpp and the host-side tools.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const unsigned int kMemBlitMin = 1024;
+static const int kMemBlitWords		  = 64;
+static const int kMemBlitLines		  = 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+// size bytes at dst, and at src for a copy (a clear passes dst for both):
+// head bytes for the CPU, words for the blitter from dst + head on, then tail
+// bytes for the CPU. It is all the CPU's below kMemBlitMin bytes and when one
+// address is odd and the other even.
+////////////////////////////////////////////////////////////////////////////////
+struct MemSplit
+{
+	unsigned int head;
+	unsigned int words;
+	unsigned int tail;
+};
+
+inline MemSplit Mem_Split(unsigned int dst, unsigned int src, unsigned int size)
+{
+	if (size < kMemBlitMin || ((dst ^ src) & 1) != 0)
+	{
+		return {size, 0, 0};
+	}
+
+	unsigned int head = dst & 1;
+	unsigned int tail = (size - head) & 1;
+
+	return {head, (size - head - tail) / 2, tail};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The next blit of words left to do: lines of kMemBlitWords words, up to
+// kMemBlitLines of them, while there are that many, then one line of the
+// rest.
+////////////////////////////////////////////////////////////////////////////////
+struct MemBlit
+{
+	int words;
+	int lines;
+};
+
+inline MemBlit Mem_NextBlit(unsigned int words)
+{
+	if (words < (unsigned int) kMemBlitWords)
+	{
+		return {(int) words, 1};
+	}
+
+	unsigned int lines = words / kMemBlitWords;
+
+	return {kMemBlitWords, (int) ((lines < (unsigned int) kMemBlitLines) ? lines : kMemBlitLines)};
+}
@@ -0,0 +1,318 @@
+////////////////////////////////////////////////////////////////////////////////
+// profile.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "profile.h"
+
+#if defined(DEBUG)
+
+#include <hardware/custom.h>
+#include "system.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kProfileEvents	 = 1024; // Power of two.
+static const int kProfileZones	 = 16;
+static const int kProfileDepth	 = 8;
+static const int kProfileFrames	 = 50;
+static const u32 kLineClocks	 = 227;
+static const u32 kFrameClocks	 = 313 * kLineClocks;
+
+////////////////////////////////////////////////////////////////////////////////
+// Overlay layout, in the debugger's PAL coordinates. One pixel per scanline,
+// so the budget mark is a frame in from the start of the bars.
+////////////////////////////////////////////////////////////////////////////////
+static const int kOverlayLeft	= 16;
+static const int kOverlayTop	= 16;
+static const int kOverlayLine	= 12;
+static const int kOverlayBars	= 240;
+static const u32 kOverlayText	= 0x00ffffff;
+static const u32 kOverlayAvg	= 0x0000c000;
+static const u32 kOverlayRange	= 0x00ffff00;
+static const u32 kOverlayBudget	= 0x00ff0000;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct ProfileEvent
+{
+	const char* name;
+	u32 frame;
+	u32 vhpos;
+};
+
+struct ProfileZone
+{
+	const char* name;
+	u32 calls;
+	u32 min;
+	u32 max;
+	u32 total;
+};
+
+struct ProfileOpen
+{
+	const char* name;
+	u32 clock;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// vhpos only needs 17 bits, the top one marks a begin.
+////////////////////////////////////////////////////////////////////////////////
+static const u32 kProfileBegin = 0x80000000;
+
+static ProfileEvent sEvents[kProfileEvents];
+static u32 sWritten;
+static u32 sRead;
+static u32 sLost;
+
+static ProfileZone sZones[kProfileZones];
+static ProfileOpen sOpen[kProfileDepth];
+static int sDepth;
+static u32 sLastClock;
+static u32 sReportFrame;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Profile_Mark(const char* name, bool begin)
+{
+	volatile u32* vpos = (u32*) &custom.vposr;
+
+	ProfileEvent& event = sEvents[sWritten & (kProfileEvents - 1)];
+	event.name = name;
+	event.frame = System_GetFrame();
+	event.vhpos = (*vpos & 0x1ffff) | (begin ? kProfileBegin : 0);
+
+	sWritten++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The frame counter goes up a little after the beam wraps, so a marker in
+// that gap looks a frame early; time never runs backwards, so that is undone.
+////////////////////////////////////////////////////////////////////////////////
+static u32 Profile_Clock(const ProfileEvent& event)
+{
+	u32 beam = ((event.vhpos >> 8) & 0x1ff) * kLineClocks + (event.vhpos & 0xff);
+	u32 clock = event.frame * kFrameClocks + beam;
+
+	if ((s32) (clock - sLastClock) < 0)
+	{
+		clock += kFrameClocks;
+	}
+
+	sLastClock = clock;
+	return clock;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The same literal at both ends of a zone need not be merged into one string.
+////////////////////////////////////////////////////////////////////////////////
+static bool Profile_SameName(const char* a, const char* b)
+{
+	if (a == b)
+	{
+		return true;
+	}
+
+	while (*a != 0 && *a == *b)
+	{
+		a++;
+		b++;
+	}
+
+	return (*a == *b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static ProfileZone* Profile_Zone(const char* name)
+{
+	for (int i = 0; i < kProfileZones; i++)
+	{
+		ProfileZone& zone = sZones[i];
+
+		if (zone.name == nullptr)
+		{
+			zone.name = name;
+			zone.min = ~0u;
+			return &zone;
+		}
+
+		if (Profile_SameName(zone.name, name))
+		{
+			return &zone;
+		}
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Profile_Event(const ProfileEvent& event)
+{
+	u32 clock = Profile_Clock(event);
+
+	if (event.vhpos & kProfileBegin)
+	{
+		if (sDepth < kProfileDepth)
+		{
+			sOpen[sDepth].name = event.name;
+			sOpen[sDepth].clock = clock;
+		}
+
+		sDepth++;
+		return;
+	}
+
+	// An end without its begin (lost, or nested too deep) is skipped.
+	if (sDepth == 0)
+	{
+		return;
+	}
+
+	sDepth--;
+
+	if (sDepth >= kProfileDepth || !Profile_SameName(sOpen[sDepth].name, event.name))
+	{
+		return;
+	}
+
+	ProfileZone* zone = Profile_Zone(event.name);
+	if (zone == nullptr)
+	{
+		return;
+	}
+
+	u32 clocks = clock - sOpen[sDepth].clock;
+
+	zone->calls++;
+	zone->total += clocks;
+	zone->min = (clocks < zone->min) ? clocks : zone->min;
+	zone->max = (clocks > zone->max) ? clocks : zone->max;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scanlines with two decimals, e.g. "12.34".
+////////////////////////////////////////////////////////////////////////////////
+static char* Profile_FormatLines(char* text, u32 clocks)
+{
+	u32 hundredths = clocks * 100 / kLineClocks;
+
+	char digits[10];
+	int count = 0;
+
+	do
+	{
+		digits[count++] = (char) ('0' + hundredths % 10);
+		hundredths /= 10;
+	}
+	while (hundredths != 0 || count < 3);
+
+	while (count > 0)
+	{
+		if (count == 2)
+		{
+			*text++ = '.';
+		}
+
+		*text++ = digits[--count];
+	}
+
+	return text;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static char* Profile_Append(char* text, const char* string)
+{
+	while (*string != 0)
+	{
+		*text++ = *string++;
+	}
+
+	return text;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Profile_Report()
+{
+	debug_clear();
+
+	int x = kOverlayLeft + kOverlayBars;
+	int lines = 0;
+
+	for (int i = 0; i < kProfileZones && sZones[i].name != nullptr; i++)
+	{
+		ProfileZone& zone = sZones[i];
+
+		if (zone.calls == 0)
+		{
+			continue;
+		}
+
+		u32 avg = zone.total / zone.calls;
+
+		char text[96];
+		char* p = Profile_Append(text, zone.name);
+		p = Profile_Append(p, " ");
+		p = Profile_FormatLines(p, zone.min);
+		p = Profile_Append(p, "/");
+		p = Profile_FormatLines(p, avg);
+		p = Profile_Append(p, "/");
+		p = Profile_FormatLines(p, zone.max);
+		*p = 0;
+
+		KPrintF("profile: %s min/avg/max scanlines, %ld calls\n", text, zone.calls);
+
+		int y = kOverlayTop + lines * kOverlayLine;
+		debug_text(kOverlayLeft, y, text, kOverlayText);
+		debug_filled_rect(x, y + 2, x + avg / kLineClocks + 1, y + kOverlayLine - 2, kOverlayAvg);
+		debug_rect(x + zone.min / kLineClocks, y + 1, x + zone.max / kLineClocks + 1, y + kOverlayLine - 1, kOverlayRange);
+		lines++;
+
+		zone.calls = 0;
+		zone.total = 0;
+		zone.min = ~0u;
+		zone.max = 0;
+	}
+
+	if (lines != 0)
+	{
+		int budget = x + kFrameClocks / kLineClocks;
+		debug_filled_rect(budget, kOverlayTop, budget + 1, kOverlayTop + lines * kOverlayLine, kOverlayBudget);
+	}
+
+	if (sLost != 0)
+	{
+		KPrintF("profile: %ld markers lost, call PROFILE_UPDATE more often\n", sLost);
+		sLost = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Profile_Update()
+{
+	if (sWritten - sRead > kProfileEvents)
+	{
+		sLost += sWritten - sRead - kProfileEvents;
+		sRead = sWritten - kProfileEvents;
+		sDepth = 0;
+	}
+
+	while (sRead != sWritten)
+	{
+		Profile_Event(sEvents[sRead & (kProfileEvents - 1)]);
+		sRead++;
+	}
+
+	u32 frame = System_GetFrame();
+	if ((s32) (frame - sReportFrame) >= kProfileFrames)
+	{
+		sReportFrame = frame;
+		Profile_Report();
+	}
+}
+
+#endif
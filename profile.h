@@ -0,0 +1,34 @@
+////////////////////////////////////////////////////////////////////////////////
+// profile.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Raster profiler. PROFILE_BEGIN/PROFILE_END mark a zone with a static name
+// and only store the name pointer and the beam position in a ring buffer.
+// Zones may nest but not overlap and are for the main loop only, not for
+// interrupts.
+//
+// PROFILE_UPDATE, once per frame, matches up the markers; every second it
+// prints min/avg/max scanlines per zone through KPrintF and draws them as
+// bars on the debugger overlay. Without DEBUG all of it compiles to nothing.
+////////////////////////////////////////////////////////////////////////////////
+#if defined(DEBUG)
+
+#define PROFILE_BEGIN(name) Profile_Mark(name, true)
+#define PROFILE_END(name) Profile_Mark(name, false)
+#define PROFILE_UPDATE() Profile_Update()
+
+void Profile_Mark(const char* name, bool begin);
+void Profile_Update();
+
+#else
+
+#define PROFILE_BEGIN(name)
+#define PROFILE_END(name)
+#define PROFILE_UPDATE()
+
+#endif
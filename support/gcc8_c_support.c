@@ -9,38 +9,7 @@ unsigned long strlen(const char* s) {
 	return t;
 }
 
-__attribute__((optimize("no-tree-loop-distribute-patterns")))
-	void* memset(void *dest, int val, unsigned long len) {
-	unsigned char *ptr = (unsigned char *)dest;
-	while(len-- > 0)
-		*ptr++ = val;
-	return dest;
-}
-
-__attribute__((optimize("no-tree-loop-distribute-patterns")))
-void* memcpy(void *dest, const void *src, unsigned long len) {
-	char *d = (char *)dest;
-	const char *s = (const char *)src;
-	while(len--)
-		*d++ = *s++;
-	return dest;
-}
-
-__attribute__((optimize("no-tree-loop-distribute-patterns")))
-void* memmove(void *dest, const void *src, unsigned long len) {
-	char *d = dest;
-	const char *s = src;
-	if (d < s) {
-		while (len--)
-			*d++ = *s++;
-	} else {
-		const char *lasts = s + (len - 1);
-		char *lastd = d + (len - 1);
-		while (len--)
-			*lastd-- = *lasts--;
-	}
-	return dest;
-}
+// memset, memcpy and memmove are in gcc8_a_support.s.
 
 // vbcc
 typedef unsigned char *va_list;
@@ -59,17 +59,20 @@ void debug_unregister(const void* addr);
             ".byte 0\n" \
 			".popsection\n" \
     ); \
-    extern const __attribute__((aligned(2))) char incbin_ ## name ## _start[1024*1024]; \
+    extern const __attribute__((__aligned__(2))) char incbin_ ## name ## _start[1024*1024]; \
 	extern const void* incbin_ ## name ## _end;\
     const void* name = &incbin_ ## name ## _start;
 
+// The product is 32 bits, so it needs a 32 bit operand to end up in.
 inline unsigned int muluw(unsigned short a, unsigned short b) {
-    asm("muluw %1,%0":"+d"(a): "mid"(b): "cc");
-    return a;
+    unsigned int r = a;
+    asm("muluw %1,%0":"+d"(r): "mid"(b): "cc");
+    return r;
 }
 inline int mulsw(short a, short b) {
-    asm("mulsw %1,%0":"+d"(a): "mid"(b): "cc");
-    return a;
+    int r = a;
+    asm("mulsw %1,%0":"+d"(r): "mid"(b): "cc");
+    return r;
 }
 inline unsigned short divuw(unsigned int a, unsigned short b) {
     asm("divuw %1,%0":"+d"(a): "mid"(b): "cc");
@@ -8,11 +8,12 @@
 #include <hardware/cia.h>
 #include <hardware/custom.h>
 #include <hardware/dmabits.h>
+#include <hardware/intbits.h>
 #include <proto/dos.h>
 #include <proto/exec.h>
 #include <proto/graphics.h>
 #include <proto/intuition.h>
-#include <proto/mathffp.h>
+#include "arena.h"
 #include "core.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -21,7 +22,6 @@ struct ExecBase* SysBase;
 struct IntuitionBase* IntuitionBase;
 struct GfxBase* GfxBase;
 struct DosLibrary* DOSBase;
-struct Library* MathBase;
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -46,6 +46,74 @@ static u16 sSavedDMACON;
 static u16 sSavedINTENA;
 static System_IrqFunc* sSavedIrqHandler;
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static System_IntFunc* volatile sIntHandler[INTB_BLIT - INTB_COPER + 1];
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kVblCallbacks = 8;
+
+static System_IntFunc* volatile sVblCallback[kVblCallbacks];
+static volatile u32 sFrame;
+static volatile u32 sSleepFrame;
+static u32 sDeadline;
+static u32 sDroppedFrames;
+
+////////////////////////////////////////////////////////////////////////////////
+// Blitter first, its handler usually starts the next blit.
+////////////////////////////////////////////////////////////////////////////////
+static __attribute__((interrupt_handler)) void System_Level3()
+{
+	u16 intreq = custom.intreqr & custom.intenar;
+
+	for (int intb = INTB_BLIT; intb >= INTB_COPER; intb--)
+	{
+		if (intreq & (1 << intb))
+		{
+			// Twice, the first write can still be in the pipeline of a 68040/060.
+			custom.intreq = (u16) (1 << intb);
+			custom.intreq = (u16) (1 << intb);
+
+			System_IntFunc* func = sIntHandler[intb - INTB_COPER];
+			if (func != nullptr)
+			{
+				func();
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void System_Vbl()
+{
+	sFrame = sFrame + 1;
+
+	for (int i = 0; i < kVblCallbacks; i++)
+	{
+		System_IntFunc* func = sVblCallback[i];
+		if (func != nullptr)
+		{
+			func();
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Run through Supervisor. The test is done with all interrupts masked and stop
+// lowers the mask and waits in one go, so a VBL can't slip in between them.
+////////////////////////////////////////////////////////////////////////////////
+static __attribute__((interrupt_handler)) void System_Sleep()
+{
+	asm volatile("movew #0x2700,%%sr" : : : "cc", "memory");
+
+	if ((s32) (sFrame - sSleepFrame) < 0)
+	{
+		asm volatile("stop #0x2000" : : : "cc", "memory");
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 bool System_Init()
@@ -77,8 +145,7 @@ bool System_Init()
 		return false;
 	}
 
-	MathBase = OpenLibrary("mathffp.library", 0);
-	if (MathBase == nullptr)
+	if (!Arena_Init())
 	{
 		CloseLibrary((Library*) DOSBase);
 		CloseLibrary((Library*) GfxBase);
@@ -136,9 +203,29 @@ bool System_Init()
 		sVBR = (volatile void*) Supervisor((ULONG (*)()) getvbr);
 	}
 
-	// Save current interrupt handler.
+	// Save current interrupt handler and install ours, with all of its
+	// sources still disabled.
 	sSavedIrqHandler = System_GetIrqHandler();
 
+	for (int i = 0; i < countof(sIntHandler); i++)
+	{
+		sIntHandler[i] = nullptr;
+	}
+
+	for (int i = 0; i < kVblCallbacks; i++)
+	{
+		sVblCallback[i] = nullptr;
+	}
+
+	sFrame = 0;
+	sDeadline = 0;
+	sDroppedFrames = 0;
+
+	System_SetIrqHandler(System_Level3);
+	custom.intena = INTF_SETCLR | INTF_INTEN;
+
+	System_SetIntHandler(INTB_VERTB, System_Vbl);
+
 	System_WaitVbl();
 
 	return true;
@@ -191,7 +278,8 @@ void System_Deinit()
 		Write(Output(), (APTR) sError, strlen(sError) + 1);
 	}
 
-	CloseLibrary((Library*) MathBase);
+	Arena_Deinit();
+
 	CloseLibrary((Library*) DOSBase);
 	CloseLibrary((Library*) GfxBase);
 	CloseLibrary((Library*) IntuitionBase);
@@ -225,6 +313,108 @@ void System_SetIrqHandler(System_IrqFunc* func)
 	*((System_IrqFunc**) (((u8*) sVBR) + 0x6c)) = func;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void System_SetIntHandler(int intb, System_IntFunc* func)
+{
+	assert(intb >= INTB_COPER && intb <= INTB_BLIT);
+
+	if (func != nullptr)
+	{
+		sIntHandler[intb - INTB_COPER] = func;
+		custom.intena = (u16) (INTF_SETCLR | (1 << intb));
+	}
+	else
+	{
+		custom.intena = (u16) (1 << intb);
+		sIntHandler[intb - INTB_COPER] = nullptr;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+u32 System_GetFrame()
+{
+	return sFrame;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void System_WaitFrame(u32 frame)
+{
+	sSleepFrame = frame;
+
+	while ((s32) (sFrame - frame) < 0)
+	{
+		Supervisor((ULONG (*)()) System_Sleep);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void System_AddVblCallback(System_IntFunc* func)
+{
+	for (int i = 0; i < kVblCallbacks; i++)
+	{
+		if (sVblCallback[i] == nullptr)
+		{
+			sVblCallback[i] = func;
+			return;
+		}
+	}
+
+	assert(false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void System_RemoveVblCallback(System_IntFunc* func)
+{
+	for (int i = 0; i < kVblCallbacks; i++)
+	{
+		if (sVblCallback[i] == func)
+		{
+			sVblCallback[i] = nullptr;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int System_Pace(int frames)
+{
+	u32 frame = sFrame;
+	u32 deadline = sDeadline + frames;
+	s32 late = (s32) (frame - deadline);
+
+	if (late > 0)
+	{
+		sDeadline = frame;
+		sDroppedFrames += late;
+
+		return late;
+	}
+
+	System_WaitFrame(deadline);
+	sDeadline = deadline;
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void System_ResetPace()
+{
+	sDeadline = sFrame;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+u32 System_GetDroppedFrames()
+{
+	return sDroppedFrames;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 void System_WaitVbl()
@@ -250,6 +440,15 @@ void System_WaitBlt()
 	while (*dmaconr & DMAF_BLTDONE) {}
 }
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int System_GetVpos()
+{
+	volatile u32* vpos = (u32*) &custom.vposr;
+
+	return ((*vpos >> 8) & 0x1ff);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 bool System_TestLMB()
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "core.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 struct Custom;
@@ -12,13 +14,13 @@ struct CIA;
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 typedef void (System_IrqFunc)();
+typedef void (System_IntFunc)();
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 extern struct ExecBase* SysBase;
 extern struct GfxBase* GfxBase;
 extern struct DosLibrary* DOSBase;
-extern struct Library* MathBase;
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -44,10 +46,41 @@ bool System_IsAGA();
 System_IrqFunc* System_GetIrqHandler();
 void System_SetIrqHandler(System_IrqFunc* func);
 
+////////////////////////////////////////////////////////////////////////////////
+// System_Init installs a level 3 handler that acknowledges the copper, VBL and
+// blitter interrupts and calls a plain function for each. Setting one enables
+// its interrupt, setting nullptr disables it. intb is INTB_COPER, INTB_VERTB
+// or INTB_BLIT.
+////////////////////////////////////////////////////////////////////////////////
+void System_SetIntHandler(int intb, System_IntFunc* func);
+
+////////////////////////////////////////////////////////////////////////////////
+// VBL scheduler. The frame counter goes up by one every vertical blank, then
+// the callbacks run in the order they were added, still in the interrupt.
+// System_WaitFrame sleeps with the CPU stopped until the counter reaches
+// frame.
+////////////////////////////////////////////////////////////////////////////////
+u32 System_GetFrame();
+void System_WaitFrame(u32 frame);
+void System_AddVblCallback(System_IntFunc* func);
+void System_RemoveVblCallback(System_IntFunc* func);
+
+////////////////////////////////////////////////////////////////////////////////
+// Frame pacing for a main loop that should take frames VBLs per iteration.
+// System_Pace sleeps until the deadline and moves it on; when the deadline
+// has already passed it returns the number of frames missed instead and
+// starts over from the current frame. System_ResetPace starts over from the
+// current frame, e.g. after loading.
+////////////////////////////////////////////////////////////////////////////////
+int System_Pace(int frames);
+void System_ResetPace();
+u32 System_GetDroppedFrames();
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 void System_WaitVbl();
 void System_WaitBlt();
+int System_GetVpos();
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+// image.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "image.h"
+#include <ctype.h>
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool ReadPpmInt(const std::vector<u8>& data, size_t& pos, int& value)
+{
+	// Skip whitespace and comments.
+	while (pos < data.size())
+	{
+		if (data[pos] == '#')
+		{
+			while (pos < data.size() && data[pos] != '\n')
+			{
+				pos++;
+			}
+		}
+		else if (isspace(data[pos]))
+		{
+			pos++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (pos >= data.size() || !isdigit(data[pos]))
+	{
+		return false;
+	}
+
+	value = 0;
+	while (pos < data.size() && isdigit(data[pos]))
+	{
+		value = value * 10 + (data[pos++] - '0');
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Image_LoadPpm(const std::string& path, Image& image)
+{
+	std::vector<u8> data;
+	if (!File_Load(path, data))
+	{
+		return false;
+	}
+
+	if (data.size() < 2 || data[0] != 'P' || data[1] != '6')
+	{
+		fprintf(stderr, "%s: not a binary PPM (P6) file\n", path.c_str());
+		return false;
+	}
+
+	size_t pos = 2;
+	int maxval;
+	if (!ReadPpmInt(data, pos, image.width) || !ReadPpmInt(data, pos, image.height) || !ReadPpmInt(data, pos, maxval))
+	{
+		fprintf(stderr, "%s: bad PPM header\n", path.c_str());
+		return false;
+	}
+
+	// Single whitespace byte before the raster.
+	pos++;
+
+	if (image.width <= 0 || image.height <= 0 || maxval <= 0 || maxval > 255)
+	{
+		fprintf(stderr, "%s: unsupported PPM size or depth\n", path.c_str());
+		return false;
+	}
+
+	size_t size = (size_t) image.width * image.height * 3;
+	if (data.size() < pos + size)
+	{
+		fprintf(stderr, "%s: truncated PPM raster\n", path.c_str());
+		return false;
+	}
+
+	image.rgb.resize(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		image.rgb[i] = (u8) ((data[pos + i] * 255 + maxval / 2) / maxval);
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Image_SavePpm(const std::string& path, const Image& image)
+{
+	char header[64];
+	int length = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", image.width, image.height);
+
+	std::vector<u8> data(header, header + length);
+	data.insert(data.end(), image.rgb.begin(), image.rgb.end());
+
+	return File_Save(path, data.data(), data.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool File_Load(const std::string& path, std::vector<u8>& data)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "%s: cannot open\n", path.c_str());
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	data.resize(size > 0 ? size : 0);
+	bool ok = (fread(data.data(), 1, data.size(), file) == data.size());
+	fclose(file);
+
+	if (!ok)
+	{
+		fprintf(stderr, "%s: read error\n", path.c_str());
+	}
+
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool File_Save(const std::string& path, const void* data, size_t size)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "%s: cannot create\n", path.c_str());
+		return false;
+	}
+
+	bool ok = (fwrite(data, 1, size, file) == size);
+	ok = (fclose(file) == 0) && ok;
+
+	if (!ok)
+	{
+		fprintf(stderr, "%s: write error\n", path.c_str());
+	}
+
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+std::string Path_StripExtension(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+	{
+		return path;
+	}
+
+	return path.substr(0, dot);
+}
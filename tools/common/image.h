@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////////////////////////////
+// image.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "types.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 24-bit RGB image, 3 bytes per pixel, rows top to bottom.
+////////////////////////////////////////////////////////////////////////////////
+struct Image
+{
+	int width = 0;
+	int height = 0;
+	std::vector<u8> rgb;
+
+	const u8* Row(int y) const { return &rgb[(size_t) y * width * 3]; }
+	u8* Row(int y) { return &rgb[(size_t) y * width * 3]; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool Image_LoadPpm(const std::string& path, Image& image);
+bool Image_SavePpm(const std::string& path, const Image& image);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool File_Load(const std::string& path, std::vector<u8>& data);
+bool File_Save(const std::string& path, const void* data, size_t size);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+std::string Path_StripExtension(const std::string& path);
+
+////////////////////////////////////////////////////////////////////////////////
+// Expands a 12-bit 0x0rgb colour to 24-bit.
+////////////////////////////////////////////////////////////////////////////////
+inline void Rgb12To24(u16 c, u8* rgb) { rgb[0] = (u8) (((c >> 8) & 15) * 17); rgb[1] = (u8) (((c >> 4) & 15) * 17); rgb[2] = (u8) ((c & 15) * 17); }
@@ -0,0 +1,43 @@
+////////////////////////////////////////////////////////////////////////////////
+// types.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Basic types, matching core.h on the target.
+////////////////////////////////////////////////////////////////////////////////
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef unsigned int uint;
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+////////////////////////////////////////////////////////////////////////////////
+// The 68000's 16 bit multiplies and divides, as support/gcc8_c_support.h has
+// them, for the target headers that use them (fixedmath.h). A divide whose
+// quotient does not fit in 16 bits is undefined here, garbage on the 68000.
+////////////////////////////////////////////////////////////////////////////////
+inline u32 muluw(u16 a, u16 b) { return (u32) a * b; }
+inline s32 mulsw(s16 a, s16 b) { return (s32) a * b; }
+inline u16 divuw(u32 a, u16 b) { return (u16) (a / b); }
+inline s16 divsw(s32 a, s16 b) { return (s16) (a / b); }
+
+////////////////////////////////////////////////////////////////////////////////
+// Arrays.
+////////////////////////////////////////////////////////////////////////////////
+#define countof(a) ((int) (sizeof(a) / sizeof((a)[0])))
+
+////////////////////////////////////////////////////////////////////////////////
+// Big endian helpers for data read by the 68000.
+////////////////////////////////////////////////////////////////////////////////
+inline void PutBE16(u8* p, u16 v) { p[0] = (u8) (v >> 8); p[1] = (u8) v; }
+inline void PutBE32(u8* p, u32 v) { p[0] = (u8) (v >> 24); p[1] = (u8) (v >> 16); p[2] = (u8) (v >> 8); p[3] = (u8) v; }
+inline u16 GetBE16(const u8* p) { return (u16) ((p[0] << 8) | p[1]); }
+inline u32 GetBE32(const u8* p) { return (((u32) p[0] << 24) | ((u32) p[1] << 16) | ((u32) p[2] << 8) | p[3]); }
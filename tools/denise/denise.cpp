@@ -0,0 +1,427 @@
+////////////////////////////////////////////////////////////////////////////////
+// denise.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "denise.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "dmaslots.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u16 kDmafCopper = 0x0080;
+static const u16 kDmafRaster = 0x0100;
+static const u16 kDmafMaster = 0x0200;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+enum CopperState
+{
+	kCopperFetch1,
+	kCopperFetch2,
+	kCopperWait,
+	kCopperStopped,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Register write seen by the pixel pipeline partway along a line.
+////////////////////////////////////////////////////////////////////////////////
+struct LineEvent
+{
+	int hpos;
+	u16 reg;
+	u16 value;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct Copper
+{
+	CopperState state;
+	u16 ir1;
+	u16 ir2;
+
+	// Frame cycle the copper may next use the bus.
+	int wake;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static inline bool CopperCompare(u16 ir1, u16 ir2, int vpos, int hpos)
+{
+	u16 mask = (u16) (0x8000 | (ir2 & 0x7ffe));
+	u16 beam = (u16) (((vpos & 0xff) << 8) | (hpos & 0xfe));
+	return ((beam & mask) >= (ir1 & 0xfffe & mask));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Denise_Reset(Denise& denise, u32 chipSize)
+{
+	denise.chip.assign(chipSize, 0);
+	memset(denise.regs, 0, sizeof(denise.regs));
+	memset(denise.bplpt, 0, sizeof(denise.bplpt));
+	denise.copPc = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Denise_Write(Denise& denise, u16 reg, u16 value)
+{
+	reg &= 0x1fe;
+
+	if (reg == kDeniseDmacon)
+	{
+		u16& dmacon = denise.regs[reg / 2];
+		dmacon = (value & 0x8000) ? (u16) (dmacon | (value & 0x7fff)) : (u16) (dmacon & ~value);
+		return;
+	}
+
+	denise.regs[reg / 2] = value;
+
+	if (reg >= kDeniseBplpt && reg < kDeniseBplpt + 6 * 4)
+	{
+		int p = (reg - kDeniseBplpt) / 4;
+		denise.bplpt[p] = (((u32) denise.regs[(kDeniseBplpt + p * 4) / 2] << 16) | denise.regs[(kDeniseBplpt + p * 4 + 2) / 2]) & ~1u;
+	}
+	else if (reg == kDeniseCopjmp1 || reg == kDeniseCopjmp2)
+	{
+		u16 lc = (reg == kDeniseCopjmp1) ? kDeniseCop1lc : kDeniseCop2lc;
+		denise.copPc = (((u32) denise.regs[lc / 2] << 16) | denise.regs[lc / 2 + 1]) & ~1u;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+u16 Denise_Read(const Denise& denise, u16 reg)
+{
+	return denise.regs[(reg & 0x1fe) / 2];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// One copper bus cycle. Returns the register written, or 0.
+////////////////////////////////////////////////////////////////////////////////
+static u16 CopperCycle(Denise& denise, Copper& copper, DeniseFrame& frame, int vpos, int hpos, u16& value)
+{
+	if (copper.state == kCopperFetch1)
+	{
+		copper.ir1 = Denise_Peek(denise, denise.copPc);
+		denise.copPc += 2;
+		copper.state = kCopperFetch2;
+		return 0;
+	}
+
+	u16 ir2 = Denise_Peek(denise, denise.copPc);
+	denise.copPc += 2;
+	copper.state = kCopperFetch1;
+
+	if ((copper.ir1 & 1) == 0)
+	{
+		// MOVE. Registers below 0x80 (0x40 with CDANG) are protected.
+		u16 reg = copper.ir1 & 0x1fe;
+		u16 lowest = (Denise_Read(denise, kDeniseCopcon) & 2) ? 0x40 : 0x80;
+		if (reg < lowest)
+		{
+			copper.state = kCopperStopped;
+			return 0;
+		}
+
+		frame.copperMoves++;
+		value = ir2;
+		return reg;
+	}
+
+	if ((ir2 & 1) == 0)
+	{
+		if (copper.ir1 == 0xffff && ir2 == 0xfffe)
+		{
+			frame.copperEnded = true;
+			copper.state = kCopperStopped;
+			return 0;
+		}
+
+		frame.copperWaits++;
+		copper.state = kCopperWait;
+		copper.ir2 = ir2;
+	}
+	else if (CopperCompare(copper.ir1, ir2, vpos, hpos))
+	{
+		denise.copPc += 4;
+	}
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u16 DecodePixel(const u16* color, u16 bplcon0, int value, u16& hold)
+{
+	int planes = (bplcon0 >> 12) & 7;
+	value &= (1 << planes) - 1;
+
+	if ((bplcon0 & 0x800) && (planes == 5 || planes == 6))
+	{
+		int data = value & 15;
+		switch ((value >> 4) & 3)
+		{
+			case 0: hold = color[data]; break;
+			case 1: hold = (u16) ((hold & 0xff0) | data); break;
+			case 2: hold = (u16) ((hold & 0x0ff) | (data << 8)); break;
+			case 3: hold = (u16) ((hold & 0xf0f) | (data << 4)); break;
+		}
+		return hold;
+	}
+
+	if (planes == 6 && !(bplcon0 & 0x400) && (value & 32))
+	{
+		hold = (u16) ((color[value & 31] >> 1) & 0x777);
+		return hold;
+	}
+
+	hold = color[value & 31];
+	return hold;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Steps the beam over one frame, one colour clock at a time. The copper and
+// bitplane DMA share the bus as modelled in dmaslots.h; fetched words are
+// shifted out 2 * ddfstrt + 17 lowres pixels in (plus the BPLCON1 delays)
+// and decoded with the colour registers as they were at each pixel.
+////////////////////////////////////////////////////////////////////////////////
+bool Denise_RunFrame(Denise& denise, DeniseFrame& frame, int width, int height)
+{
+	frame.image.width = width;
+	frame.image.height = height;
+	frame.image.rgb.assign((size_t) width * height * 3, 0);
+	frame.copperMoves = 0;
+	frame.copperWaits = 0;
+	frame.copperEnded = false;
+
+	if (Denise_Read(denise, kDeniseBplcon0) & 0x8000)
+	{
+		fprintf(stderr, "Hires screens are not modelled\n");
+		return false;
+	}
+
+	// The copper restarts from COP1LC at the vertical blank.
+	Denise_Write(denise, kDeniseCopjmp1, 0);
+	Copper copper = {kCopperFetch1, 0, 0, 0};
+
+	std::vector<LineEvent> events;
+	u8 pixels[2 * kDmaLineCycles + 64];
+
+	for (int vpos = 0; vpos < kDeniseLines; vpos++)
+	{
+		u16 diwstrt = Denise_Read(denise, kDeniseDiwstrt);
+		u16 diwstop = Denise_Read(denise, kDeniseDiwstop);
+		int diwTop = diwstrt >> 8;
+		int diwBottom = (diwstop >> 8) | ((diwstop & 0x8000) ? 0 : 0x100);
+		bool inside = (vpos >= diwTop && vpos < diwBottom);
+
+		u16 dmacon = Denise_Read(denise, kDeniseDmacon);
+		bool bitplanes = inside && (dmacon & (kDmafRaster | kDmafMaster)) == (kDmafRaster | kDmafMaster);
+		bool copperDma = (dmacon & (kDmafCopper | kDmafMaster)) == (kDmafCopper | kDmafMaster);
+
+		u16 lineColors[32];
+		for (int i = 0; i < 32; i++)
+		{
+			lineColors[i] = Denise_Read(denise, (u16) (kDeniseColor + i * 2));
+		}
+		u16 lineBplcon0 = Denise_Read(denise, kDeniseBplcon0);
+
+		events.clear();
+		memset(pixels, 0, sizeof(pixels));
+
+		u16 data[6] = {};
+		bool fetched = false;
+
+		for (int hpos = 0; hpos < kDmaLineCycles; hpos++)
+		{
+			u16 bplcon0 = Denise_Read(denise, kDeniseBplcon0);
+			u16 ddfstrt = Denise_Read(denise, kDeniseDdfstrt) & 0xfc;
+			u16 ddfstop = Denise_Read(denise, kDeniseDdfstop) & 0xfc;
+			DmaConfig config = {bitplanes ? ((bplcon0 >> 12) & 7) : 0, false, ddfstrt, ddfstop, 0, 0, 0};
+
+			if (Dma_IsBitplaneCycle(config, hpos))
+			{
+				int p = Dma_FetchPlane(false, hpos - ddfstrt) - 1;
+				data[p] = Denise_Peek(denise, denise.bplpt[p]);
+				denise.bplpt[p] += 2;
+				fetched = true;
+
+				// Plane 1 comes last in each fetch unit.
+				if (p == 0)
+				{
+					u16 bplcon1 = Denise_Read(denise, kDeniseBplcon1);
+					int x = 2 * (hpos - 7) + 17;
+
+					for (int q = 0; q < config.planes; q++)
+					{
+						int delay = (q & 1) ? ((bplcon1 >> 4) & 15) : (bplcon1 & 15);
+						for (int i = 0; i < 16; i++)
+						{
+							if (data[q] & (0x8000 >> i))
+							{
+								pixels[x + delay + i] |= (u8) (1 << q);
+							}
+						}
+					}
+				}
+			}
+
+			if (copperDma && copper.state == kCopperWait && CopperCompare(copper.ir1, copper.ir2, vpos, hpos))
+			{
+				// One cycle to wake up before the next fetch.
+				copper.state = kCopperFetch1;
+				copper.wake = vpos * kDmaLineCycles + hpos + 1;
+			}
+			else if (copperDma && (copper.state == kCopperFetch1 || copper.state == kCopperFetch2) && Dma_IsCopperCycle(config, hpos) && vpos * kDmaLineCycles + hpos >= copper.wake)
+			{
+				u16 value = 0;
+				u16 reg = CopperCycle(denise, copper, frame, vpos, hpos, value);
+				if (reg != 0)
+				{
+					Denise_Write(denise, reg, value);
+
+					if ((reg >= kDeniseColor && reg < kDeniseColor + 64) || reg == kDeniseBplcon0)
+					{
+						events.push_back({2 * hpos + kDeniseColorDelay, reg, value});
+					}
+					if (reg == kDeniseCopjmp1 || reg == kDeniseCopjmp2)
+					{
+						copper.state = kCopperFetch1;
+					}
+				}
+			}
+		}
+
+		if (fetched)
+		{
+			s16 bpl1mod = (s16) Denise_Read(denise, kDeniseBpl1mod);
+			s16 bpl2mod = (s16) Denise_Read(denise, kDeniseBpl2mod);
+			for (int p = 0; p < 6; p++)
+			{
+				denise.bplpt[p] += (p & 1) ? bpl2mod : bpl1mod;
+			}
+		}
+
+		int y = vpos - frame.y;
+		if (y < 0 || y >= height)
+		{
+			continue;
+		}
+
+		int diwLeft = diwstrt & 0xff;
+		int diwRight = (diwstop & 0xff) | 0x100;
+
+		u16 hold = lineColors[0];
+		size_t event = 0;
+		u8* out = frame.image.Row(y);
+
+		for (int i = 0; i < width; i++)
+		{
+			int x = frame.x + i;
+			for (; event < events.size() && events[event].hpos <= x; event++)
+			{
+				if (events[event].reg == kDeniseBplcon0)
+				{
+					lineBplcon0 = events[event].value;
+				}
+				else
+				{
+					lineColors[(events[event].reg - kDeniseColor) / 2] = events[event].value & 0xfff;
+				}
+			}
+
+			u16 c;
+			if (inside && x >= diwLeft && x < diwRight && x < (int) sizeof(pixels))
+			{
+				c = DecodePixel(lineColors, lineBplcon0, pixels[x], hold);
+			}
+			else
+			{
+				c = hold = lineColors[0];
+			}
+
+			Rgb12To24(c, &out[i * 3]);
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Denise_SetupScreen(Denise& denise, const DeniseScreen& screen)
+{
+	const u32 planeSize = (u32) (screen.width / 8 * screen.height);
+	const u32 planesAddress = 0x1000;
+	const u32 copperAddress = (planesAddress + planeSize * screen.planes + 0xfff) & ~0xfffu;
+
+	u32 chipSize = 0x80000;
+	while (chipSize < copperAddress + 0x10000)
+	{
+		chipSize *= 2;
+	}
+	Denise_Reset(denise, chipSize);
+
+	memcpy(&denise.chip[planesAddress], screen.planeData, planeSize * screen.planes);
+
+	u32 pc = copperAddress;
+	auto emit = [&](u16 ir1, u16 ir2)
+	{
+		Denise_Poke(denise, pc, ir1);
+		Denise_Poke(denise, pc + 2, ir2);
+		pc += 4;
+	};
+
+	for (int p = 0; p < screen.planes; p++)
+	{
+		u32 address = planesAddress + planeSize * p;
+		emit((u16) (kDeniseBplpt + p * 4), (u16) (address >> 16));
+		emit((u16) (kDeniseBplpt + p * 4 + 2), (u16) address);
+	}
+
+	for (int i = 0; i < screen.paletteSize; i++)
+	{
+		emit((u16) (kDeniseColor + i * 2), screen.palette[i]);
+	}
+
+	if (screen.sliceColors > 0)
+	{
+		const int firstLine = 0x2c - 1;
+		const int waitHpos = Dma_SliceWaitHpos(0, screen.width);
+
+		for (int j = 0; j < screen.height; j++)
+		{
+			// As in ham.cpp the slice for vpos 255 waits at 0xFFDF for the wrap.
+			u16 wait = (firstLine + j == 0xff) ? 0xffdf : (u16) ((((firstLine + j) & 0xff) << 8) | (waitHpos & 0xfe) | 1);
+			emit(wait, 0xfffe);
+
+			const u8* moves = &screen.slices[(size_t) j * screen.sliceColors * 4];
+			for (int i = 0; i < screen.sliceColors; i++)
+			{
+				emit(GetBE16(&moves[i * 4]), GetBE16(&moves[i * 4 + 2]));
+			}
+		}
+	}
+
+	emit(0xffff, 0xfffe);
+
+	// As PackBplcon0, PackDiwstrt/stop and PackDdfstrt/stop for sx = sy = 0.
+	u16 ddfstrt = ((0x81 - 17) / 2) & 0xfc;
+	Denise_Write(denise, kDeniseBplcon0, (u16) ((screen.planes << 12) | (screen.ham ? 0x800 : 0) | 0x200));
+	Denise_Write(denise, kDeniseBplcon1, 0);
+	Denise_Write(denise, kDeniseBplcon2, 0);
+	Denise_Write(denise, kDeniseBpl1mod, 0);
+	Denise_Write(denise, kDeniseBpl2mod, 0);
+	Denise_Write(denise, kDeniseDiwstrt, (u16) ((0x2c << 8) | 0x81));
+	Denise_Write(denise, kDeniseDiwstop, (u16) ((((screen.height - 256 + 0x2c) & 0xff) << 8) | ((screen.width - 256 + 0x81) & 0xff)));
+	Denise_Write(denise, kDeniseDdfstrt, ddfstrt);
+	Denise_Write(denise, kDeniseDdfstop, (u16) (ddfstrt + 8 * (screen.width / 16 - 1)));
+	Denise_Write(denise, kDeniseCopcon, 2);
+	Denise_Write(denise, kDeniseCop1lc, (u16) (copperAddress >> 16));
+	Denise_Write(denise, kDeniseCop1lc + 2, (u16) copperAddress);
+	Denise_Write(denise, kDeniseDmacon, 0x8000 | kDmafCopper | kDmafRaster | kDmafMaster);
+}
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////
+// denise.h
+//
+// Reference model of the OCS display path: copper, bitplane DMA and Denise's
+// colour decode for normal, EHB, HAM6 and HAM5 lowres screens. It works on
+// an image of chip RAM and the custom registers, exactly as the target code
+// sets them up, and renders one PAL frame to 24-bit RGB.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include "image.h"
+#include "types.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Register offsets, as offsetof(Custom, reg) on the target.
+////////////////////////////////////////////////////////////////////////////////
+static const u16 kDeniseCopcon	= 0x02e;
+static const u16 kDeniseCop1lc	= 0x080;
+static const u16 kDeniseCop2lc	= 0x084;
+static const u16 kDeniseCopjmp1 = 0x088;
+static const u16 kDeniseCopjmp2 = 0x08a;
+static const u16 kDeniseDiwstrt = 0x08e;
+static const u16 kDeniseDiwstop = 0x090;
+static const u16 kDeniseDdfstrt = 0x092;
+static const u16 kDeniseDdfstop = 0x094;
+static const u16 kDeniseDmacon	= 0x096;
+static const u16 kDeniseBplpt	= 0x0e0;
+static const u16 kDeniseBplcon0 = 0x100;
+static const u16 kDeniseBplcon1 = 0x102;
+static const u16 kDeniseBplcon2 = 0x104;
+static const u16 kDeniseBpl1mod = 0x108;
+static const u16 kDeniseBpl2mod = 0x10a;
+static const u16 kDeniseColor	= 0x180;
+
+////////////////////////////////////////////////////////////////////////////////
+// PAL frame and the lowres pixel a write to a colour register first affects,
+// relative to the copper cycle doing the write.
+////////////////////////////////////////////////////////////////////////////////
+static const int kDeniseLines	   = 312;
+static const int kDeniseColorDelay = 1;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct Denise
+{
+	std::vector<u8> chip;
+	u16 regs[0x100] = {};
+
+	// Live DMA pointers.
+	u32 bplpt[6] = {};
+	u32 copPc = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Area of the frame to capture, in lowres hpos and vpos as DIWSTRT/DIWSTOP
+// see them. The default is the 320x256 window of PackDiwstrt(0, 0).
+////////////////////////////////////////////////////////////////////////////////
+struct DeniseFrame
+{
+	int x = 0x81;
+	int y = 0x2c;
+	Image image;
+
+	// Copper and DMA statistics for the frame.
+	int copperMoves = 0;
+	int copperWaits = 0;
+	bool copperEnded = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void Denise_Reset(Denise& denise, u32 chipSize);
+void Denise_Write(Denise& denise, u16 reg, u16 value);
+u16 Denise_Read(const Denise& denise, u16 reg);
+bool Denise_RunFrame(Denise& denise, DeniseFrame& frame, int width, int height);
+
+////////////////////////////////////////////////////////////////////////////////
+// Chip RAM helpers, big endian like the 68000.
+////////////////////////////////////////////////////////////////////////////////
+inline u16 Denise_Peek(const Denise& denise, u32 address) { address &= (u32) (denise.chip.size() - 2); return GetBE16(&denise.chip[address]); }
+inline void Denise_Poke(Denise& denise, u32 address, u16 value) { address &= (u32) (denise.chip.size() - 2); PutBE16(&denise.chip[address], value); }
+
+////////////////////////////////////////////////////////////////////////////////
+// Builds the same screen as Ham_Init: planes back to back, a copper list
+// loading the bitplane pointers and the palette, optional sliced palette
+// reloads (CopList::Slice), and the display registers.
+////////////////////////////////////////////////////////////////////////////////
+struct DeniseScreen
+{
+	int width = 320;
+	int height = 256;
+	int planes = 6;
+	bool ham = true;
+	const u8* planeData = nullptr;
+	const u16* palette = nullptr;
+	int paletteSize = 16;
+
+	// sliceColors big endian MOVEs per line, as written by hamconv -sliced.
+	const u8* slices = nullptr;
+	int sliceColors = 0;
+};
+
+void Denise_SetupScreen(Denise& denise, const DeniseScreen& screen);
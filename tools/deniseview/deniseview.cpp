@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////////
+// deniseview.cpp
+//
+// Renders what the target would put on screen, using the display model in
+// denise/. Either from hamconv style files:
+//
+//   deniseview -ham6 -pal image.pal -slc image.slc 15 image.bpl -o out.ppm
+//
+// or from a raw chip RAM dump plus custom register values, e.g. as saved
+// from an emulator:
+//
+//   deniseview -chip chip.bin -reg 0x100=0x6a00 -reg 0x80=0x0002 ... -o out.ppm
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+#include "denise.h"
+#include "image.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void PrintUsage()
+{
+	printf("usage: deniseview [options] [input.bpl]\n");
+	printf("  -ham6         6 plane HAM (default)\n");
+	printf("  -ham5         5 plane HAM\n");
+	printf("  -ehb          6 plane extra half brite\n");
+	printf("  -planes <n>   n plane normal screen\n");
+	printf("  -size <WxH>   screen size (default: 320x256)\n");
+	printf("  -pal <file>   big endian 0x0rgb palette\n");
+	printf("  -slc <file> <n>  n colour MOVEs per line, as written by hamconv -sliced\n");
+	printf("  -chip <file>  raw chip RAM image instead of input.bpl\n");
+	printf("  -reg <r=v>    set custom register at offset r to v (with -chip)\n");
+	printf("  -frames <n>   render n frames and report the speed\n");
+	printf("  -o <file>     output PPM (default: input.ppm)\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+	DeniseScreen screen;
+	std::string input, output, palFile, slcFile, chipFile;
+	std::vector<std::pair<u16, u16>> regs;
+	int frames = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-ham6"))
+		{
+			screen.planes = 6;
+			screen.ham = true;
+		}
+		else if (!strcmp(argv[i], "-ham5"))
+		{
+			screen.planes = 5;
+			screen.ham = true;
+		}
+		else if (!strcmp(argv[i], "-ehb"))
+		{
+			screen.planes = 6;
+			screen.ham = false;
+		}
+		else if (!strcmp(argv[i], "-planes") && i + 1 < argc)
+		{
+			screen.planes = atoi(argv[++i]);
+			screen.ham = false;
+		}
+		else if (!strcmp(argv[i], "-size") && i + 1 < argc)
+		{
+			if (sscanf(argv[++i], "%dx%d", &screen.width, &screen.height) != 2)
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "-pal") && i + 1 < argc)
+		{
+			palFile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-slc") && i + 2 < argc)
+		{
+			slcFile = argv[++i];
+			screen.sliceColors = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-chip") && i + 1 < argc)
+		{
+			chipFile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-reg") && i + 1 < argc)
+		{
+			int reg, value;
+			if (sscanf(argv[++i], "%i=%i", &reg, &value) != 2)
+			{
+				PrintUsage();
+				return 1;
+			}
+			regs.push_back({(u16) reg, (u16) value});
+		}
+		else if (!strcmp(argv[i], "-frames") && i + 1 < argc)
+		{
+			frames = std::max(atoi(argv[++i]), 1);
+		}
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+		{
+			output = argv[++i];
+		}
+		else if (argv[i][0] == '-' || !input.empty())
+		{
+			PrintUsage();
+			return 1;
+		}
+		else
+		{
+			input = argv[i];
+		}
+	}
+
+	if (input.empty() == chipFile.empty() || screen.planes < 1 || screen.planes > 6 || screen.width % 16 || screen.height < 1)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (output.empty())
+	{
+		output = Path_StripExtension(chipFile.empty() ? input : chipFile) + ".ppm";
+	}
+
+	Denise denise;
+
+	if (!chipFile.empty())
+	{
+		std::vector<u8> chip;
+		if (!File_Load(chipFile, chip))
+		{
+			return 1;
+		}
+
+		u32 chipSize = 0x80000;
+		while (chipSize < chip.size())
+		{
+			chipSize *= 2;
+		}
+
+		Denise_Reset(denise, chipSize);
+		memcpy(denise.chip.data(), chip.data(), chip.size());
+
+		for (auto& reg : regs)
+		{
+			Denise_Write(denise, reg.first, reg.second);
+		}
+	}
+	else
+	{
+		std::vector<u8> planes, pal, slc;
+		if (!File_Load(input, planes) || (!palFile.empty() && !File_Load(palFile, pal)) || (!slcFile.empty() && !File_Load(slcFile, slc)))
+		{
+			return 1;
+		}
+
+		if (planes.size() < (size_t) screen.width / 8 * screen.height * screen.planes ||
+			slc.size() < (size_t) screen.height * screen.sliceColors * 4)
+		{
+			fprintf(stderr, "Input files are too short for a %dx%d, %d plane screen\n", screen.width, screen.height, screen.planes);
+			return 1;
+		}
+
+		std::vector<u16> palette(32, 0);
+		for (size_t i = 0; i < std::min(pal.size() / 2, palette.size()); i++)
+		{
+			palette[i] = GetBE16(&pal[i * 2]);
+		}
+
+		screen.planeData = planes.data();
+		screen.palette = palette.data();
+		screen.paletteSize = screen.ham ? 16 : std::min(1 << screen.planes, 32);
+		screen.slices = slc.empty() ? nullptr : slc.data();
+
+		Denise_SetupScreen(denise, screen);
+	}
+
+	DeniseFrame frame;
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < frames; i++)
+	{
+		if (!Denise_RunFrame(denise, frame, screen.width, screen.height))
+		{
+			return 1;
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (!Image_SavePpm(output, frame.image))
+	{
+		return 1;
+	}
+
+	printf("%s: %d copper moves, %d waits%s\n", output.c_str(), frame.copperMoves, frame.copperWaits, frame.copperEnded ? "" : ", no end of list");
+
+	if (frames > 1)
+	{
+		printf("%d frames in %.3f s (%.1f frames/s)\n", frames, seconds, frames / seconds);
+	}
+
+	return 0;
+}
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+// dmabudget.cpp
+//
+// Prints the chip bus cycles a display configuration leaves the copper, the
+// blitter and the CPU, per line and per frame, from the model in dmaslots.h
+// that Dma_BudgetFits checks at compile time:
+//
+//   tools/bin/dmabudget -planes 6 -sprites 8 -budget 20000 30000 600
+//
+// -map draws a display line, one character per colour clock. With -budget it
+// fails if the cycles an effect needs a frame do not fit.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dmaslots.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void PrintUsage()
+{
+	printf("usage: dmabudget [options]\n");
+	printf("  -planes <n>     bitplanes, 0-8 (default 6)\n");
+	printf("  -hires          hires instead of lowres\n");
+	printf("  -fmode <n>      AGA bitplane fetch mode, 0-3 (default 0)\n");
+	printf("  -width <n>      display width in pixels, for the default ddf (default 320)\n");
+	printf("  -ddf <strt> <stop>  ddfstrt and ddfstop as written, hex\n");
+	printf("  -lines <n>      lines with bitplanes a frame (default 256)\n");
+	printf("  -sprites <n>    sprites fetching on every line, 0-8 (default 0)\n");
+	printf("  -audio <n>      audio channels playing, 0-4 (default 0)\n");
+	printf("  -map            draw a display line\n");
+	printf("  -budget <cpu> <blitter> <copper>  cycles an effect needs a frame\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// One character per cycle: r refresh, a audio, s sprite, 1-8 bitplane, c
+// copper (or blitter or CPU), b blitter only.
+////////////////////////////////////////////////////////////////////////////////
+static void PrintMap(const DmaConfig& config)
+{
+	for (int hpos = 0; hpos < kDmaLineCycles; hpos++)
+	{
+		if (hpos % 64 == 0)
+		{
+			printf("%s0x%02x ", hpos ? "\n" : "", hpos);
+		}
+
+		char c = (hpos & 1) ? 'b' : 'c';
+
+		if (Dma_IsBitplaneCycle(config, hpos))
+		{
+			c = (char) ('0' + Dma_FetchPlane(config.hires, hpos - config.ddfstrt));
+		}
+		else if (Dma_IsFixedCycle(config, hpos))
+		{
+			c = (hpos >= kDmaSprites && hpos < kDmaLineCycles - 1) ? 's' : ((hpos >= kDmaAudio && hpos < kDmaLineCycles - 1) ? 'a' : 'r');
+		}
+
+		putchar(c);
+	}
+
+	printf("\n\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void PrintSlots(const char* name, const DmaSlots& slots, int cycles)
+{
+	printf("%-10s %8d %8d %8d %7.1f%% %7.1f%%\n", name, slots.fixed, slots.even, slots.odd,
+		100.0 * slots.even / cycles, 100.0 * (slots.even + slots.odd) / cycles);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+	DmaConfig config = {6, false, -1, -1, 0, 0, 0};
+	DmaBudget budget = {0, 0, 0};
+	int width = 320;
+	int lines = 256;
+	bool map = false;
+	bool check = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-planes") && i + 1 < argc)
+		{
+			config.planes = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-hires"))
+		{
+			config.hires = true;
+		}
+		else if (!strcmp(argv[i], "-fmode") && i + 1 < argc)
+		{
+			config.fmode = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-width") && i + 1 < argc)
+		{
+			width = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-ddf") && i + 2 < argc)
+		{
+			config.ddfstrt = (int) strtol(argv[++i], nullptr, 16);
+			config.ddfstop = (int) strtol(argv[++i], nullptr, 16);
+		}
+		else if (!strcmp(argv[i], "-lines") && i + 1 < argc)
+		{
+			lines = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-sprites") && i + 1 < argc)
+		{
+			config.sprites = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-audio") && i + 1 < argc)
+		{
+			config.audio = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-map"))
+		{
+			map = true;
+		}
+		else if (!strcmp(argv[i], "-budget") && i + 3 < argc)
+		{
+			budget.cpu = atoi(argv[++i]);
+			budget.blitter = atoi(argv[++i]);
+			budget.copper = atoi(argv[++i]);
+			check = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	// The default fetch is a window of width pixels from the usual left edge,
+	// PackDdfstrt(0) and PackDdfstop(width).
+	if (config.ddfstrt < 0)
+	{
+		int unit = Dma_FetchUnit(config.hires, config.fmode);
+		int unitPixels = unit * (config.hires ? 4 : 2);
+
+		config.ddfstrt = config.hires ? 0x3c : 0x38;
+		config.ddfstop = config.ddfstrt + (width / unitPixels - 1) * unit;
+	}
+
+	if (config.planes < 0 || config.planes > 8 || config.fmode < 0 || config.fmode > 3 || config.sprites < 0 || config.sprites > 8 ||
+		config.audio < 0 || config.audio > 4 || lines < 0 || lines > kDmaFrameLines)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	printf("%d %s planes, fmode %d, ddf 0x%02x-0x%02x, %d lines, %d sprites, %d audio channels\n\n",
+		config.planes, config.hires ? "hires" : "lowres", config.fmode, config.ddfstrt, config.ddfstop, lines, config.sprites, config.audio);
+
+	if (map)
+	{
+		PrintMap(config);
+	}
+
+	DmaConfig blank = config;
+	blank.planes = 0;
+
+	printf("%-10s %8s %8s %8s %8s %8s\n", "cycles", "fixed", "even", "odd", "even %", "free %");
+	PrintSlots("line", Dma_LineSlots(config), kDmaLineCycles);
+	PrintSlots("border", Dma_LineSlots(blank), kDmaLineCycles);
+	PrintSlots("frame", Dma_FrameSlots(config, lines), kDmaLineCycles * kDmaFrameLines);
+
+	if (check)
+	{
+		bool fits = Dma_BudgetFits(config, lines, budget);
+		DmaSlots frame = Dma_FrameSlots(config, lines);
+
+		printf("\nbudget: cpu %d, blitter %d, copper %d: %s (%d of %d even, %d of %d free)\n", budget.cpu, budget.blitter, budget.copper,
+			fits ? "fits" : "DOES NOT FIT", budget.cpu + budget.copper, frame.even, budget.cpu + budget.copper + budget.blitter, frame.even + frame.odd);
+
+		return fits ? 0 : 1;
+	}
+
+	return 0;
+}
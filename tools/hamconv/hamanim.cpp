@@ -0,0 +1,680 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamanim.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hamanim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+// PAL 68000 cycles per raster line.
+////////////////////////////////////////////////////////////////////////////////
+static const double kLineCycles = 7093790.0 / 50.0 / 313.0;
+
+////////////////////////////////////////////////////////////////////////////////
+// A run of one word this long gets an op of its own, and unchanged rows in a
+// run of stored words are stored as well unless there are kSkipRows of them.
+////////////////////////////////////////////////////////////////////////////////
+static const int kSameRows = 3;
+static const int kSkipRows = 2;
+
+////////////////////////////////////////////////////////////////////////////////
+// Every code that gives the colour the encoder chose, per pixel of a line, as
+// a mask over the 64 codes of a 6 bit pixel. As long as each pixel keeps the
+// same colour, the hold colour does too, so any of them can go anywhere.
+////////////////////////////////////////////////////////////////////////////////
+static void ValidCodes(const HamImage& ham, int y, u64* valid)
+{
+	const u8* row = ham.Row(y);
+	u16 hold = ham.palette[0];
+
+	for (int x = 0; x < ham.width; x++)
+	{
+		u16 color = HamEnc_Hold(hold, row[x], ham.palette);
+		u64 mask = 0;
+
+		for (int i = 0; i < kHamPaletteSize; i++)
+		{
+			if (ham.palette[i] == color)
+			{
+				mask |= (u64) 1 << (kHamSet | i);
+			}
+		}
+
+		if ((hold & 0xff0) == (color & 0xff0))
+		{
+			mask |= (u64) 1 << (kHamModifyB | (color & 15));
+		}
+
+		if (ham.mode == kHamModeHam6 && (hold & 0x0ff) == (color & 0x0ff))
+		{
+			mask |= (u64) 1 << (kHamModifyR | (color >> 8));
+		}
+
+		if (ham.mode == kHamModeHam6 && (hold & 0xf0f) == (color & 0xf0f))
+		{
+			mask |= (u64) 1 << (kHamModifyG | ((color >> 4) & 15));
+		}
+
+		valid[x] = mask;
+		hold = color;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The deltas, as the pairs of frames they go between: each frame over the one
+// interleave before it round the loop, and the first interleave frames over
+// the key frame once.
+////////////////////////////////////////////////////////////////////////////////
+struct AnimPair
+{
+	int from;
+	int to;
+};
+
+static std::vector<AnimPair> Pairs(int frames, int interleave)
+{
+	std::vector<AnimPair> pairs;
+
+	for (int k = 1; k < interleave && k < frames; k++)
+	{
+		pairs.push_back({0, k});
+	}
+
+	for (int k = 0; k < frames; k++)
+	{
+		pairs.push_back({(k + frames - interleave % frames) % frames, k});
+	}
+
+	return pairs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A delta costs the words that differ, not the pixels, so the codes are
+// swapped one pixel at a time among the valid ones, keeping a swap when it
+// leaves fewer differing words over all the deltas the frame is in. This goes
+// line by line, the words of one plane not reaching past a line, over a few
+// passes until nothing improves. Starting from the encoder's codes, it can
+// only end up with fewer words, and the colours stay exactly as encoded.
+////////////////////////////////////////////////////////////////////////////////
+void HamAnim_Stabilize(const HamAnimOptions& options, std::vector<HamImage>& hams)
+{
+	const int kPasses = 4;
+	const int frames = (int) hams.size();
+	const int width = hams[0].width;
+	const int planes = HamEnc_Planes(hams[0].mode);
+	const int words = (width + 15) / 16;
+
+	std::vector<AnimPair> pairs = Pairs(frames, options.interleave);
+	std::vector<std::vector<int>> touching(frames);
+	for (int i = 0; i < (int) pairs.size(); i++)
+	{
+		touching[pairs[i].from].push_back(i);
+		touching[pairs[i].to].push_back(i);
+	}
+
+	std::vector<u64> valid((size_t) frames * width);
+	std::vector<u8> differ(pairs.size() * planes * words);
+	std::vector<u8*> rows(frames);
+
+	for (int y = 0; y < hams[0].height; y++)
+	{
+		for (int k = 0; k < frames; k++)
+		{
+			ValidCodes(hams[k], y, &valid[(size_t) k * width]);
+			rows[k] = hams[k].Row(y);
+		}
+
+		std::fill(differ.begin(), differ.end(), 0);
+		for (int i = 0; i < (int) pairs.size(); i++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				u8 bits = rows[pairs[i].from][x] ^ rows[pairs[i].to][x];
+				for (int p = 0; p < planes; p++)
+				{
+					differ[((size_t) i * planes + p) * words + x / 16] += (bits >> p) & 1;
+				}
+			}
+		}
+
+		for (int pass = 0; pass < kPasses; pass++)
+		{
+			bool improved = false;
+
+			for (int k = 0; k < frames; k++)
+			{
+				for (int x = 0; x < width; x++)
+				{
+					u8 code = rows[k][x];
+					u8 best = code;
+					int bestGain = 0;
+
+					for (u64 mask = valid[(size_t) k * width + x] & ~((u64) 1 << code); mask != 0; mask &= mask - 1)
+					{
+						u8 candidate = (u8) __builtin_ctzll(mask);
+						int gain = 0;
+
+						for (int i : touching[k])
+						{
+							u8 other = rows[(pairs[i].from == k) ? pairs[i].to : pairs[i].from][x];
+							u8 before = code ^ other;
+							u8 after = candidate ^ other;
+
+							for (int p = 0; p < planes; p++)
+							{
+								int n = differ[((size_t) i * planes + p) * words + x / 16];
+								int m = n - ((before >> p) & 1) + ((after >> p) & 1);
+								gain += (n > 0) - (m > 0);
+							}
+						}
+
+						if (gain > bestGain)
+						{
+							best = candidate;
+							bestGain = gain;
+						}
+					}
+
+					if (best != code)
+					{
+						for (int i : touching[k])
+						{
+							u8 other = rows[(pairs[i].from == k) ? pairs[i].to : pairs[i].from][x];
+							for (int p = 0; p < planes; p++)
+							{
+								u8& n = differ[((size_t) i * planes + p) * words + x / 16];
+								n = (u8) (n - (((code ^ other) >> p) & 1) + (((best ^ other) >> p) & 1));
+							}
+						}
+
+						rows[k][x] = best;
+						improved = true;
+					}
+				}
+			}
+
+			if (!improved)
+			{
+				break;
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lossy: a pixel within deadband of the one the frame is drawn over, in every
+// channel, takes its value, so small changes such as noise leave it alone.
+// This goes round the loop twice, so the first frames also see the last ones,
+// always comparing against the original pixel. The deltas from the key frame
+// to the first interleave frames are not helped, but they only play once.
+////////////////////////////////////////////////////////////////////////////////
+void HamAnim_Deadband(const std::vector<const Image*>& images, const HamAnimOptions& options, std::vector<Image>& filtered)
+{
+	const int frames = (int) images.size();
+
+	filtered.resize(frames);
+	for (int k = 0; k < frames; k++)
+	{
+		filtered[k] = *images[k];
+	}
+
+	for (int k = options.interleave; k < 2 * frames; k++)
+	{
+		const u8* in = images[k % frames]->rgb.data();
+		const u8* ref = filtered[(k - options.interleave) % frames].rgb.data();
+		u8* out = filtered[k % frames].rgb.data();
+
+		for (size_t i = 0; i < images[0]->rgb.size(); i += 3)
+		{
+			bool close = true;
+			for (int c = 0; c < 3; c++)
+			{
+				close = close && abs(in[i + c] - ref[i + c]) <= options.deadband;
+			}
+
+			for (int c = 0; c < 3; c++)
+			{
+				out[i + c] = close ? ref[i + c] : in[i + c];
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Ops for one word column, from prev to cur, rows rowBytes apart. Unchanged
+// rows at the end need no op at all.
+////////////////////////////////////////////////////////////////////////////////
+static bool EncodeColumn(const u8* prev, const u8* cur, int rows, int rowBytes, std::vector<u8>& ops, std::vector<u8>& words)
+{
+	auto word = [&](const u8* p, int y) { return GetBE16(p + y * rowBytes); };
+	auto same = [&](int y) { return word(prev, y) == word(cur, y); };
+	auto run = [&](int y, int end)
+	{
+		int n = 1;
+		while (y + n < end && n < kAnimMaxSame && word(cur, y + n) == word(cur, y))
+		{
+			n++;
+		}
+		return n;
+	};
+
+	int end = rows;
+	while (end > 0 && same(end - 1))
+	{
+		end--;
+	}
+
+	size_t countAt = ops.size();
+	int count = 0;
+	ops.push_back(0);
+
+	for (int y = 0; y < end; count++)
+	{
+		if (same(y))
+		{
+			int n = 1;
+			while (y + n < end && n < kAnimMaxSkip && same(y + n))
+			{
+				n++;
+			}
+
+			ops.push_back((u8) n);
+			y += n;
+			continue;
+		}
+
+		int n = run(y, end);
+		if (n >= kSameRows)
+		{
+			ops.push_back(0x00);
+			ops.push_back((u8) n);
+			words.push_back(cur[y * rowBytes]);
+			words.push_back(cur[y * rowBytes + 1]);
+			y += n;
+			continue;
+		}
+
+		n = 1;
+		while (y + n < end && n < kAnimMaxUniq && run(y + n, end) < kSameRows)
+		{
+			int unchanged = 0;
+			while (unchanged < kSkipRows && y + n + unchanged < end && same(y + n + unchanged))
+			{
+				unchanged++;
+			}
+
+			if (unchanged == kSkipRows)
+			{
+				break;
+			}
+
+			n++;
+		}
+
+		ops.push_back((u8) (0x80 | n));
+		for (int i = 0; i < n; i++, y++)
+		{
+			words.push_back(cur[y * rowBytes]);
+			words.push_back(cur[y * rowBytes + 1]);
+		}
+	}
+
+	if (count > kAnimMaxOps)
+	{
+		return false;
+	}
+
+	ops[countAt] = (u8) count;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool EncodeDelta(const std::vector<u8>& prev, const std::vector<u8>& cur, int planes, int rowBytes, int rows, std::vector<u8>& delta)
+{
+	const int planeSize = rowBytes * rows;
+
+	std::vector<u8> ops, words;
+	u16 mask = 0;
+
+	for (int p = 0; p < planes; p++)
+	{
+		const u8* a = &prev[(size_t) p * planeSize];
+		const u8* b = &cur[(size_t) p * planeSize];
+
+		if (memcmp(a, b, planeSize) == 0)
+		{
+			continue;
+		}
+
+		mask |= (u16) (1 << p);
+
+		for (int column = 0; column < rowBytes; column += 2)
+		{
+			if (!EncodeColumn(a + column, b + column, rows, rowBytes, ops, words))
+			{
+				fprintf(stderr, "More than %d ops in a column\n", kAnimMaxOps);
+				return false;
+			}
+		}
+	}
+
+	if (ops.size() & 1)
+	{
+		ops.push_back(0);
+	}
+
+	delta.assign(kAnimDeltaHeader, 0);
+	PutBE32(&delta[0], (u32) (kAnimDeltaHeader + ops.size() + words.size()));
+	PutBE16(&delta[4], (u16) ops.size());
+	PutBE16(&delta[6], mask);
+	delta.insert(delta.end(), ops.begin(), ops.end());
+	delta.insert(delta.end(), words.begin(), words.end());
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool HamAnim_Write(const std::vector<HamImage>& hams, const HamAnimOptions& options, std::vector<u8>& anim, std::vector<HamAnimDelta>& deltas)
+{
+	const int frames = (int) hams.size();
+	const int interleave = options.interleave;
+	const int planes = HamEnc_Planes(hams[0].mode);
+	const int rowBytes = hams[0].width / 8;
+	const int rows = hams[0].height;
+
+	std::vector<std::vector<u8>> planar(frames);
+	for (int i = 0; i < frames; i++)
+	{
+		HamEnc_ToPlanar(hams[i], planar[i]);
+	}
+
+	anim.assign(kAnimHeaderSize, 0);
+	PutBE16(&anim[kAnimWidth * 2], (u16) hams[0].width);
+	PutBE16(&anim[kAnimHeight * 2], (u16) rows);
+	PutBE16(&anim[kAnimPlanes * 2], (u16) planes);
+	PutBE16(&anim[kAnimFrames * 2], (u16) frames);
+	PutBE16(&anim[kAnimInterleave * 2], (u16) interleave);
+	PutBE16(&anim[kAnimDeltas * 2], (u16) (frames + interleave));
+
+	for (int i = 0; i < kAnimPaletteSize; i++)
+	{
+		PutBE16(&anim[kAnimPalette * 2 + i * 2], hams[0].palette[i]);
+	}
+
+	const std::vector<u8> cleared(planar[0].size(), 0);
+	deltas.clear();
+
+	for (int k = 0; k < frames + interleave; k++)
+	{
+		if (k == interleave)
+		{
+			PutBE32(&anim[kAnimLoop * 2], (u32) anim.size());
+		}
+
+		const std::vector<u8>& prev = (k == 0) ? cleared : planar[(k >= interleave) ? (k - interleave) % frames : 0];
+
+		std::vector<u8> delta;
+		if (!EncodeDelta(prev, planar[k % frames], planes, rowBytes, rows, delta))
+		{
+			return false;
+		}
+
+		HamAnimDelta stats;
+		stats.bytes = (u32) delta.size();
+		stats.words = (u32) (delta.size() - kAnimDeltaHeader - GetBE16(&delta[4])) / 2;
+		stats.cycles = HamAnim_Model(delta.data(), (u32) rowBytes);
+		deltas.push_back(stats);
+
+		anim.insert(anim.end(), delta.begin(), delta.end());
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Plays the animation the way anim.cpp does, over interleave buffers that all
+// start with the key frame, for two loops.
+////////////////////////////////////////////////////////////////////////////////
+bool HamAnim_Verify(const std::vector<u8>& anim, const std::vector<HamImage>& hams)
+{
+	const u8* header = anim.data();
+	const int frames = (int) Anim_ReferenceWord(header + kAnimFrames * 2);
+	const int interleave = (int) Anim_ReferenceWord(header + kAnimInterleave * 2);
+	const int deltas = (int) Anim_ReferenceWord(header + kAnimDeltas * 2);
+	const u32 rowBytes = Anim_ReferenceWord(header + kAnimWidth * 2) / 8;
+	const u32 planeSize = rowBytes * Anim_ReferenceWord(header + kAnimHeight * 2);
+
+	std::vector<std::vector<u8>> planar(frames);
+	for (int i = 0; i < frames; i++)
+	{
+		HamEnc_ToPlanar(hams[i], planar[i]);
+	}
+
+	std::vector<std::vector<u8>> buffers(interleave, std::vector<u8>(planar[0].size(), 0));
+	const u8* next = header + kAnimHeaderSize;
+
+	for (std::vector<u8>& buffer : buffers)
+	{
+		Anim_ReferenceApply(next, buffer.data(), planeSize, rowBytes);
+	}
+
+	next += Anim_ReferenceLong(next);
+	int delta = 1;
+
+	for (int shown = 1; shown < 2 * frames + interleave; shown++)
+	{
+		std::vector<u8>& buffer = buffers[shown % interleave];
+		Anim_ReferenceApply(next, buffer.data(), planeSize, rowBytes);
+
+		if (buffer != planar[shown % frames])
+		{
+			fprintf(stderr, "Delta %d does not give frame %d\n", delta, shown % frames);
+			return false;
+		}
+
+		if (++delta < deltas)
+		{
+			next += Anim_ReferenceLong(next);
+		}
+		else
+		{
+			delta = interleave;
+			next = header + Anim_ReferenceLong(header + kAnimLoop * 2);
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Follows Anim_Apply instruction by instruction; see anim_a.s.
+////////////////////////////////////////////////////////////////////////////////
+u32 HamAnim_Model(const u8* delta, u32 rowBytes)
+{
+	const u32 skipCycles = 38 + 2 * __builtin_popcount(rowBytes & 0xffff);
+
+	const u8* op = delta + kAnimDeltaHeader;
+	u32 mask = GetBE16(delta + 6);
+
+	// Saving registers and reading the header, then restoring them.
+	u32 cycles = 210 + 100;
+
+	for (; mask != 0; mask >>= 1)
+	{
+		if ((mask & 1) == 0)
+		{
+			cycles += 8 + 8 + 10 + 8;
+			continue;
+		}
+
+		cycles += 8 + 10 + 8 + 8;
+
+		for (u32 column = 0; column < rowBytes / 2; column++)
+		{
+			cycles += 26 + 14 + 8 + ((column + 1 < rowBytes / 2) ? 10 : 14);
+
+			for (int count = *op++; count > 0; count--)
+			{
+				int code = *op++;
+				cycles += 10 + 4 + 8;
+
+				if (code > 0 && code < 0x80)
+				{
+					cycles += 10 + skipCycles + 8 + 10;
+				}
+				else if (code == 0)
+				{
+					int n = *op++;
+					cycles += 8 + 10 + 8 + 4 + 8 + 26 * n + 4 + 10;
+				}
+				else
+				{
+					cycles += 8 + 8 + 8 + 30 * (code & 0x7f) + 4;
+				}
+			}
+		}
+	}
+
+	return cycles + 8 + 8 + 8;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct HamAnimTotals
+{
+	u64 bytes = 0;
+	u64 cycles = 0;
+	u32 maxBytes = 0;
+	u32 maxCycles = 0;
+	double psnr = 0.0;
+};
+
+static void Accumulate(const std::vector<HamAnimDelta>& deltas, HamAnimTotals& totals)
+{
+	for (size_t k = 1; k < deltas.size(); k++)
+	{
+		totals.bytes += deltas[k].bytes;
+		totals.cycles += deltas[k].cycles;
+		totals.maxBytes = std::max(totals.maxBytes, deltas[k].bytes);
+		totals.maxCycles = std::max(totals.maxCycles, deltas[k].cycles);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool HamAnim_Run(const std::vector<const Image*>& images, const HamEncOptions& encOptions, const HamAnimOptions& options, const std::string& path, bool quiet)
+{
+	if (encOptions.sliceColors > 0)
+	{
+		fprintf(stderr, "Animations cannot be sliced\n");
+		return false;
+	}
+
+	if (options.interleave < 1 || images.size() > 0xffff - (size_t) options.interleave)
+	{
+		fprintf(stderr, "Bad interleave or too many frames\n");
+		return false;
+	}
+
+	for (const Image* image : images)
+	{
+		if (image->width != images[0]->width || image->height != images[0]->height)
+		{
+			fprintf(stderr, "All frames must be %dx%d\n", images[0]->width, images[0]->height);
+			return false;
+		}
+	}
+
+	HamEncOptions shared = encOptions;
+	shared.sharedPalette = true;
+
+	std::vector<HamImage> plain;
+	if (!HamEnc_Encode(images, shared, plain))
+	{
+		return false;
+	}
+
+	std::vector<HamImage> stable = plain;
+	if (options.deadband > 0)
+	{
+		std::vector<Image> filtered;
+		HamAnim_Deadband(images, options, filtered);
+
+		std::vector<const Image*> filteredPtrs;
+		for (const Image& image : filtered)
+		{
+			filteredPtrs.push_back(&image);
+		}
+
+		if (!HamEnc_Encode(filteredPtrs, shared, stable))
+		{
+			return false;
+		}
+	}
+
+	HamAnim_Stabilize(options, stable);
+
+	std::vector<u8> anims[2];
+	std::vector<HamAnimDelta> deltas[2];
+	HamAnimTotals totals[2];
+
+	for (int i = 0; i < 2; i++)
+	{
+		const std::vector<HamImage>& hams = (i == 0) ? plain : stable;
+
+		if (!HamAnim_Write(hams, options, anims[i], deltas[i]) || !HamAnim_Verify(anims[i], hams))
+		{
+			return false;
+		}
+
+		Accumulate(deltas[i], totals[i]);
+
+		for (size_t k = 0; k < hams.size(); k++)
+		{
+			Image decoded;
+			HamEnc_Decode(hams[k], decoded);
+			totals[i].psnr += HamEnc_Psnr(*images[k], decoded) / hams.size();
+		}
+	}
+
+	if (!File_Save(path, anims[1].data(), anims[1].size()))
+	{
+		return false;
+	}
+
+	if (!quiet)
+	{
+		printf("%5s %5s | %-28s | %-28s\n", "", "", "as encoded", "stabilized");
+		printf("%5s %5s | %8s %6s %7s %5s | %8s %6s %7s %5s\n", "delta", "frame", "bytes", "words", "cycles", "lines", "bytes", "words", "cycles", "lines");
+
+		for (size_t k = 0; k < deltas[0].size(); k++)
+		{
+			printf("%5d %5d", (int) k, (int) (k % images.size()));
+
+			for (int i = 0; i < 2; i++)
+			{
+				const HamAnimDelta& delta = deltas[i][k];
+				printf(" | %8u %6u %7u %5.1f", delta.bytes, delta.words, delta.cycles, delta.cycles / kLineCycles);
+			}
+
+			printf("\n");
+		}
+	}
+
+	const size_t count = deltas[0].size() - 1;
+
+	printf("%s: %d frames, interleave %d, key frame %u bytes, %u bytes in all\n", path.c_str(), (int) images.size(), options.interleave, deltas[1][0].bytes, (u32) anims[1].size());
+
+	for (int i = 0; i < 2; i++)
+	{
+		const HamAnimTotals& t = totals[i];
+		printf("  %-11s per frame %7.0f bytes (max %6u), %6.1f lines (max %6.1f), PSNR %.2f dB\n", (i == 0) ? "as encoded:" : "stabilized:",
+			(double) t.bytes / count, t.maxBytes, t.cycles / kLineCycles / count, t.maxCycles / kLineCycles, t.psnr);
+	}
+
+	return true;
+}
@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamanim.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "animref.h"
+#include "hamenc.h"
+#include "image.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// interleave is the number of screen buffers the player goes through, each
+// delta being made against the frame that many back. deadband, in 8-bit
+// steps, lets pixels that barely change keep their old value (see
+// HamAnim_Deadband); 0 leaves the frames as they are.
+////////////////////////////////////////////////////////////////////////////////
+struct HamAnimOptions
+{
+	int interleave = 3;
+	int deadband = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// One delta: its bytes, the words it stores and the 68000 cycles Anim_Apply
+// takes for it, counted per instruction along the path anim_a.s takes, without
+// DMA contention.
+////////////////////////////////////////////////////////////////////////////////
+struct HamAnimDelta
+{
+	u32 bytes = 0;
+	u32 words = 0;
+	u32 cycles = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HamAnim_Deadband(const std::vector<const Image*>& images, const HamAnimOptions& options, std::vector<Image>& filtered);
+void HamAnim_Stabilize(const HamAnimOptions& options, std::vector<HamImage>& hams);
+bool HamAnim_Write(const std::vector<HamImage>& hams, const HamAnimOptions& options, std::vector<u8>& anim, std::vector<HamAnimDelta>& deltas);
+bool HamAnim_Verify(const std::vector<u8>& anim, const std::vector<HamImage>& hams);
+u32 HamAnim_Model(const u8* delta, u32 rowBytes);
+
+////////////////////////////////////////////////////////////////////////////////
+// Encodes images as the frames of one animation with a shared palette, both
+// as they come from the encoder and stabilized (after the deadband, if any),
+// checks both through the reference player over two loops and writes the
+// stabilized one to path. Prints bytes and modelled cycles per delta for the
+// two side by side.
+////////////////////////////////////////////////////////////////////////////////
+bool HamAnim_Run(const std::vector<const Image*>& images, const HamEncOptions& encOptions, const HamAnimOptions& options, const std::string& path, bool quiet);
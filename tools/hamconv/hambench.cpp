@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+// hambench.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hambench.h"
+#include <stdio.h>
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const double kMinSeconds = 0.5;
+
+////////////////////////////////////////////////////////////////////////////////
+// Encodes the whole image on one thread until kMinSeconds have passed,
+// returning pixels per second.
+////////////////////////////////////////////////////////////////////////////////
+static double Measure(const HamKernels& kernels, bool greedy, const Image& image, HamImage& ham)
+{
+	HamEncWork work;
+	int passes = 0;
+	double seconds = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+	do
+	{
+		for (int y = 0; y < image.height; y++)
+		{
+			if (greedy)
+			{
+				HamEnc_EncodeLineGreedy(kernels, image, y, ham);
+			}
+			else
+			{
+				HamEnc_EncodeLine(kernels, work, image, y, ham);
+			}
+		}
+
+		passes++;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	while (seconds < kMinSeconds);
+
+	return (double) image.width * image.height * passes / seconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Times every supported kernel set against the scalar one and checks that
+// they all pick exactly the same pixels.
+////////////////////////////////////////////////////////////////////////////////
+bool HamBench_Run(const Image& image, HamMode mode)
+{
+	HamImage ham;
+	ham.mode = mode;
+	ham.width = image.width;
+	ham.height = image.height;
+	ham.pixels.resize((size_t) image.width * image.height);
+	HamEnc_ChoosePalette(image, ham.palette, kHamPaletteSize);
+
+	HamImage reference[2] = {ham, ham};
+	bool identical = true;
+
+	printf("%-8s %16s %16s\n", "kernel", "search px/s", "greedy px/s");
+
+	for (int i = HamKernels_Count() - 1; i >= 0; i--)
+	{
+		const HamKernels& kernels = HamKernels_Get(i);
+		if (!kernels.supported())
+		{
+			printf("%-8s %16s %16s\n", kernels.name, "-", "-");
+			continue;
+		}
+
+		double rate[2];
+		bool same = true;
+		for (int greedy = 0; greedy < 2; greedy++)
+		{
+			HamImage& out = (&kernels == &kHamKernelsScalar) ? reference[greedy] : ham;
+			rate[greedy] = Measure(kernels, greedy != 0, image, out);
+			same = same && (out.pixels == reference[greedy].pixels);
+		}
+
+		printf("%-8s %16.0f %16.0f%s\n", kernels.name, rate[0], rate[1], same ? "" : "  MISMATCH");
+		identical = identical && same;
+	}
+
+	return identical;
+}
@@ -0,0 +1,12 @@
+////////////////////////////////////////////////////////////////////////////////
+// hambench.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "hamenc.h"
+#include "image.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool HamBench_Run(const Image& image, HamMode mode);
@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamconv.cpp
+//
+// Converts 24-bit PPM images to HAM6/HAM5 planar data plus a 16 colour base
+// palette. For every input.ppm it writes:
+//
+//   input.bpl  planes back to back, kScreenPlaneSize apart, as in sScreenBpl
+//   input.pal  16 big endian 0x0rgb words, as in kPalette
+//   input.slc  with -sliced, the colour MOVEs for each line's CopList::Slice
+//
+// With -anim the inputs are the frames of one animation instead, written as
+// the first input's name with .anm for anim.cpp (see animref.h).
+//
+// Both can be pulled straight into chip RAM on the target:
+//
+//   INCBIN_CHIP(sImageBpl, "input.bpl")
+//   INCBIN(sImagePal, "input.pal")
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "denise.h"
+#include "hamanim.h"
+#include "hambench.h"
+#include "hamenc.h"
+#include "hamrtcmp.h"
+#include "image.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void PrintUsage()
+{
+	printf("usage: hamconv [options] input.ppm...\n");
+	printf("  -ham6       6 planes, set/modify R/G/B (default)\n");
+	printf("  -ham5       5 planes, set/modify B only\n");
+	printf("  -j <n>      worker threads (default: all cores)\n");
+	printf("  -greedy     per-pixel greedy choice instead of the full search\n");
+	printf("  -sliced <n> reload up to n of colours 1-15 per line from the copper\n");
+	printf("  -kernel <k> colour error kernels: avx2, sse4 or scalar (default: best)\n");
+	printf("  -bench      time every kernel on the first input instead of converting\n");
+	printf("  -rt         PSNR of the real-time conversion (hamrt_a.s) on the first input\n");
+	printf("  -anim       the inputs are frames; write one delta animation\n");
+	printf("  -interleave <n> screen buffers the player draws into in turn (default 3)\n");
+	printf("  -deadband <n>   keep pixels that change by up to n in every channel (default 0)\n");
+	printf("  -preview    also write input.ham.ppm as the display model renders it\n");
+	printf("  -q          quiet\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+	HamEncOptions options;
+	HamAnimOptions animOptions;
+	bool anim = false;
+	bool bench = false;
+	bool rt = false;
+	bool preview = false;
+	bool quiet = false;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-ham6"))
+		{
+			options.mode = kHamModeHam6;
+		}
+		else if (!strcmp(argv[i], "-ham5"))
+		{
+			options.mode = kHamModeHam5;
+		}
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+		{
+			options.threads = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-greedy"))
+		{
+			options.greedy = true;
+		}
+		else if (!strcmp(argv[i], "-sliced") && i + 1 < argc)
+		{
+			options.sliceColors = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-kernel") && i + 1 < argc)
+		{
+			options.kernels = HamKernels_Find(argv[++i]);
+			if (options.kernels == nullptr)
+			{
+				fprintf(stderr, "Kernel %s is unknown or not supported by this CPU\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "-bench"))
+		{
+			bench = true;
+		}
+		else if (!strcmp(argv[i], "-rt"))
+		{
+			rt = true;
+		}
+		else if (!strcmp(argv[i], "-anim"))
+		{
+			anim = true;
+		}
+		else if (!strcmp(argv[i], "-interleave") && i + 1 < argc)
+		{
+			animOptions.interleave = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-deadband") && i + 1 < argc)
+		{
+			animOptions.deadband = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-preview"))
+		{
+			preview = true;
+		}
+		else if (!strcmp(argv[i], "-q"))
+		{
+			quiet = true;
+		}
+		else if (argv[i][0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else
+		{
+			inputs.push_back(argv[i]);
+		}
+	}
+
+	if (inputs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<Image> images(inputs.size());
+	std::vector<const Image*> imagePtrs;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		if (!Image_LoadPpm(inputs[i], images[i]))
+		{
+			return 1;
+		}
+		imagePtrs.push_back(&images[i]);
+	}
+
+	if (bench)
+	{
+		return HamBench_Run(images[0], options.mode) ? 0 : 1;
+	}
+
+	if (rt)
+	{
+		return HamRtCmp_Run(images[0], options) ? 0 : 1;
+	}
+
+	if (anim)
+	{
+		return HamAnim_Run(imagePtrs, options, animOptions, Path_StripExtension(inputs[0]) + ".anm", quiet) ? 0 : 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<HamImage> hams;
+	if (!HamEnc_Encode(imagePtrs, options, hams))
+	{
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		std::string base = Path_StripExtension(inputs[i]);
+
+		std::vector<u8> planes, palette;
+		HamEnc_ToPlanar(hams[i], planes);
+		HamEnc_PaletteToBytes(hams[i].palette, kHamPaletteSize, palette);
+
+		if (!File_Save(base + ".bpl", planes.data(), planes.size()) ||
+			!File_Save(base + ".pal", palette.data(), palette.size()))
+		{
+			return 1;
+		}
+
+		if (hams[i].sliceColors > 0)
+		{
+			std::vector<u8> slices;
+			HamSlice_ToCopper(hams[i], slices);
+
+			if (!File_Save(base + ".slc", slices.data(), slices.size()))
+			{
+				return 1;
+			}
+		}
+
+		Image decoded;
+		HamEnc_Decode(hams[i], decoded);
+
+		if (preview)
+		{
+			// Run the written files through the display model, so the preview
+			// is what the copper and Denise make of them.
+			DeniseScreen screen;
+			screen.width = hams[i].width;
+			screen.height = hams[i].height;
+			screen.planes = HamEnc_Planes(options.mode);
+			screen.planeData = planes.data();
+			screen.palette = hams[i].palette;
+			screen.paletteSize = kHamPaletteSize;
+
+			std::vector<u8> slices;
+			if (hams[i].sliceColors > 0)
+			{
+				HamSlice_ToCopper(hams[i], slices);
+				screen.slices = slices.data();
+				screen.sliceColors = hams[i].sliceColors;
+			}
+
+			Denise denise;
+			DeniseFrame frame;
+			Denise_SetupScreen(denise, screen);
+
+			if (!Denise_RunFrame(denise, frame, screen.width, screen.height))
+			{
+				return 1;
+			}
+
+			if (frame.image.rgb != decoded.rgb)
+			{
+				fprintf(stderr, "%s: warning: display model output differs from the encoder's decode\n", inputs[i].c_str());
+			}
+
+			if (!Image_SavePpm(base + ".ham.ppm", frame.image))
+			{
+				return 1;
+			}
+		}
+
+		if (!quiet)
+		{
+			printf("%s: %dx%d, %d planes, PSNR %.2f dB\n", inputs[i].c_str(), hams[i].width, hams[i].height, HamEnc_Planes(options.mode), HamEnc_Psnr(images[i], decoded));
+		}
+	}
+
+	if (!quiet)
+	{
+		printf("%d image(s) in %.3f s (%.3f s per image)\n", (int) inputs.size(), seconds, seconds / inputs.size());
+	}
+
+	return 0;
+}
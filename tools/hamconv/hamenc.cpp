@@ -0,0 +1,539 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamenc.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hamenc.h"
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "c2pref.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u32 kInfinity	 = 0x40000000;
+static const int kKMeansIterations = 8;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct PaletteBin
+{
+	u32 count;
+	u32 sum[3];
+	int key[3];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u16 BinMean(const PaletteBin* bins, int count, int* mean8)
+{
+	u64 sum[3] = {};
+	u64 total = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		sum[0] += bins[i].sum[0];
+		sum[1] += bins[i].sum[1];
+		sum[2] += bins[i].sum[2];
+		total += bins[i].count;
+	}
+
+	u16 c = 0;
+	for (int k = 0; k < 3; k++)
+	{
+		int m = (int) ((sum[k] + total / 2) / total);
+		if (mean8 != nullptr)
+		{
+			mean8[k] = m;
+		}
+		c = (u16) ((c << 4) | ((m + 8) / 17));
+	}
+
+	return c;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Median cut over the 12-bit histogram, refined with k-means in 8-bit space.
+////////////////////////////////////////////////////////////////////////////////
+void HamEnc_ChoosePalette(const Image& image, u16* palette, int count)
+{
+	std::vector<PaletteBin> histogram(kHamStates);
+	for (int i = 0; i < kHamStates; i++)
+	{
+		histogram[i] = {0, {0, 0, 0}, {i >> 8, (i >> 4) & 15, i & 15}};
+	}
+
+	for (size_t i = 0; i < image.rgb.size(); i += 3)
+	{
+		const u8* p = &image.rgb[i];
+		PaletteBin& bin = histogram[(((p[0] + 8) / 17) << 8) | (((p[1] + 8) / 17) << 4) | ((p[2] + 8) / 17)];
+		bin.count++;
+		bin.sum[0] += p[0];
+		bin.sum[1] += p[1];
+		bin.sum[2] += p[2];
+	}
+
+	std::vector<PaletteBin> bins;
+	for (const PaletteBin& bin : histogram)
+	{
+		if (bin.count != 0)
+		{
+			bins.push_back(bin);
+		}
+	}
+
+	struct Box { int begin, end; };
+	std::vector<Box> boxes = {{0, (int) bins.size()}};
+
+	while ((int) boxes.size() < count)
+	{
+		// Split the box with the widest weighted channel range.
+		int split = -1;
+		int splitAxis = 0;
+		u64 splitScore = 0;
+
+		for (int i = 0; i < (int) boxes.size(); i++)
+		{
+			const Box& box = boxes[i];
+			if (box.end - box.begin < 2)
+			{
+				continue;
+			}
+
+			int lo[3] = {15, 15, 15};
+			int hi[3] = {0, 0, 0};
+			u64 pixels = 0;
+			for (int j = box.begin; j < box.end; j++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					lo[k] = std::min(lo[k], bins[j].key[k]);
+					hi[k] = std::max(hi[k], bins[j].key[k]);
+				}
+				pixels += bins[j].count;
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				u64 score = (u64) (hi[k] - lo[k]) * pixels;
+				if (score > splitScore)
+				{
+					split = i;
+					splitAxis = k;
+					splitScore = score;
+				}
+			}
+		}
+
+		if (split < 0)
+		{
+			break;
+		}
+
+		Box box = boxes[split];
+		std::sort(bins.begin() + box.begin, bins.begin() + box.end, [splitAxis](const PaletteBin& a, const PaletteBin& b) { return a.key[splitAxis] < b.key[splitAxis]; });
+
+		u64 total = 0;
+		for (int j = box.begin; j < box.end; j++)
+		{
+			total += bins[j].count;
+		}
+
+		int median = box.begin + 1;
+		u64 acc = bins[box.begin].count;
+		while (median < box.end - 1 && acc * 2 < total)
+		{
+			acc += bins[median++].count;
+		}
+
+		boxes[split] = {box.begin, median};
+		boxes.push_back({median, box.end});
+	}
+
+	std::vector<int> centres(count * 3, 0);
+	for (int i = 0; i < (int) boxes.size(); i++)
+	{
+		palette[i] = BinMean(&bins[boxes[i].begin], boxes[i].end - boxes[i].begin, &centres[i * 3]);
+	}
+	for (int i = (int) boxes.size(); i < count; i++)
+	{
+		palette[i] = 0x000;
+	}
+
+	// K-means refinement, keeping unused entries where median cut left them.
+	int used = (int) boxes.size();
+	std::vector<int> nearest(bins.size());
+	for (int iteration = 0; iteration < kKMeansIterations && used > 0; iteration++)
+	{
+		for (size_t j = 0; j < bins.size(); j++)
+		{
+			int mean[3] = {(int) (bins[j].sum[0] / bins[j].count), (int) (bins[j].sum[1] / bins[j].count), (int) (bins[j].sum[2] / bins[j].count)};
+
+			u32 best = ~0u;
+			for (int i = 0; i < used; i++)
+			{
+				int dr = mean[0] - centres[i * 3 + 0];
+				int dg = mean[1] - centres[i * 3 + 1];
+				int db = mean[2] - centres[i * 3 + 2];
+				u32 e = (u32) (kHamWeightR * dr * dr + kHamWeightG * dg * dg + kHamWeightB * db * db);
+				if (e < best)
+				{
+					best = e;
+					nearest[j] = i;
+				}
+			}
+		}
+
+		std::vector<PaletteBin> members;
+		for (int i = 0; i < used; i++)
+		{
+			members.clear();
+			for (size_t j = 0; j < bins.size(); j++)
+			{
+				if (nearest[j] == i)
+				{
+					members.push_back(bins[j]);
+				}
+			}
+
+			if (!members.empty())
+			{
+				palette[i] = BinMean(members.data(), (int) members.size(), &centres[i * 3]);
+			}
+		}
+	}
+
+	// Darkest first, so the border colour at the start of each line is black-ish.
+	std::sort(palette, palette + used, [](u16 a, u16 b)
+	{
+		int la = ((a >> 8) & 15) * 3 + ((a >> 4) & 15) * 4 + (a & 15) * 2;
+		int lb = ((b >> 8) & 15) * 3 + ((b >> 4) & 15) * 4 + (b & 15) * 2;
+		return (la != lb) ? (la < lb) : (a < b);
+	});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Viterbi search over all 4096 hold colours. Each pixel either sets a palette
+// entry (reachable from the best previous state) or modifies one channel
+// (reachable from the best previous state sharing the other two channels).
+// Returns the total weighted squared error of the line.
+//
+// Path costs stay below 2^31 for lines up to kHamMaxWidth pixels, which the
+// vector kernels rely on.
+////////////////////////////////////////////////////////////////////////////////
+u32 HamEnc_EncodeLine(const HamKernels& kernels, HamEncWork& work, const Image& image, int y, HamImage& ham)
+{
+	const int width = image.width;
+	const bool ham6 = (ham.mode == kHamModeHam6);
+	const u16* palette = ham.Palette(y);
+
+	work.cost[0].resize(kHamStates);
+	work.cost[1].resize(kHamStates);
+	work.choice.resize((size_t) width * kHamStates);
+	work.back.resize((size_t) width * kHamBackStride);
+
+	s8 palIndex[kHamStates];
+	std::fill(palIndex, palIndex + kHamStates, -1);
+	for (int i = kHamPaletteSize - 1; i >= 0; i--)
+	{
+		palIndex[palette[i]] = (s8) i;
+	}
+
+	int setStates[kHamPaletteSize];
+	int setCount = 0;
+	for (int i = 0; i < kHamPaletteSize; i++)
+	{
+		if (palIndex[palette[i]] == i)
+		{
+			setStates[setCount++] = palette[i];
+		}
+	}
+
+	// The hold register starts each line at the border colour.
+	u32* prev = work.cost[0].data();
+	u32* next = work.cost[1].data();
+	std::fill(prev, prev + kHamStates, kInfinity);
+	prev[palette[0]] = 0;
+
+	const u8* row = image.Row(y);
+	for (int x = 0; x < width; x++)
+	{
+		u32 err[48];
+		for (int c = 0; c < 16; c++)
+		{
+			err[c] = HamEnc_ChannelError(c, row[x * 3 + 0], kHamWeightR);
+			err[c + 16] = HamEnc_ChannelError(c, row[x * 3 + 1], kHamWeightG);
+			err[c + 32] = HamEnc_ChannelError(c, row[x * 3 + 2], kHamWeightB);
+		}
+
+		u8* choice = &work.choice[(size_t) x * kHamStates];
+		u32 best = kernels.step(prev, next, choice, &work.back[(size_t) x * kHamBackStride], err, ham6);
+
+		// Setting a palette entry wins ties against modifying.
+		for (int i = 0; i < setCount; i++)
+		{
+			int s = setStates[i];
+			u32 c = best + err[s >> 8] + err[16 + ((s >> 4) & 15)] + err[32 + (s & 15)];
+			if (c <= next[s])
+			{
+				next[s] = c;
+				choice[s] = (u8) (kHamSet | palIndex[s]);
+			}
+		}
+
+		std::swap(prev, next);
+	}
+
+	// Trace the cheapest path back from the end of the line.
+	int state = 0;
+	for (int s = 1; s < kHamStates; s++)
+	{
+		if (prev[s] < prev[state])
+		{
+			state = s;
+		}
+	}
+	u32 total = prev[state];
+
+	u8* out = ham.Row(y);
+	for (int x = width - 1; x >= 0; x--)
+	{
+		u8 v = work.choice[(size_t) x * kHamStates + state];
+		const u16* back = &work.back[(size_t) x * kHamBackStride];
+		out[x] = v;
+
+		switch (v & 0x30)
+		{
+			case kHamSet:	  state = back[0]; break;
+			case kHamModifyB: state = back[1 + (state >> 4)]; break;
+			case kHamModifyR: state = back[1 + 256 + (state & 0xff)]; break;
+			case kHamModifyG: state = back[1 + 512 + (((state >> 4) & 0xf0) | (state & 15))]; break;
+		}
+	}
+
+	return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Picks the cheapest candidate pixel by pixel. Much faster than the search,
+// for drafts and as the reference for converting at run time.
+////////////////////////////////////////////////////////////////////////////////
+u32 HamEnc_EncodeLineGreedy(const HamKernels& kernels, const Image& image, int y, HamImage& ham)
+{
+	const bool ham6 = (ham.mode == kHamModeHam6);
+
+	HamScorePalette palette;
+	HamKernels_PreparePalette(ham.Palette(y), palette);
+
+	const u8* row = image.Row(y);
+	u8* out = ham.Row(y);
+	u16 hold = ham.palette[0];
+	u32 total = 0;
+	const u16* colors = ham.Palette(y);
+
+	for (int x = 0; x < image.width; x++)
+	{
+		const u8* target = &row[x * 3];
+
+		u32 scores[kHamCandidates];
+		int best = kernels.score(hold, target, palette, ham6, scores);
+		total += scores[best];
+
+		out[x] = HamEnc_CandidateCode(best, target);
+		hold = HamEnc_Hold(hold, out[x], colors);
+	}
+
+	return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs palette selection across images, then the scanline searches across
+// every line of every image, on a shared pool of threads.
+////////////////////////////////////////////////////////////////////////////////
+bool HamEnc_Encode(const std::vector<const Image*>& images, const HamEncOptions& options, std::vector<HamImage>& hams)
+{
+	if (options.sliceColors > 0 && options.sliceColors > HamSlice_MaxColors(options.mode, images[0]->width))
+	{
+		fprintf(stderr, "Only %d colours per line fit in the copper slots\n", HamSlice_MaxColors(options.mode, images[0]->width));
+		return false;
+	}
+
+	for (const Image* image : images)
+	{
+		if ((image->width % 16) != 0 || image->width > kHamMaxWidth)
+		{
+			fprintf(stderr, "Image width %d is not a multiple of 16 up to %d\n", image->width, kHamMaxWidth);
+			return false;
+		}
+	}
+
+	hams.clear();
+	hams.resize(images.size());
+
+	std::vector<std::pair<int, int>> jobs;
+	for (int i = 0; i < (int) images.size(); i++)
+	{
+		hams[i].mode = options.mode;
+		hams[i].width = images[i]->width;
+		hams[i].height = images[i]->height;
+		hams[i].pixels.resize((size_t) images[i]->width * images[i]->height);
+
+		for (int y = 0; y < images[i]->height; y++)
+		{
+			jobs.push_back({i, y});
+		}
+	}
+
+	const HamKernels& kernels = (options.kernels != nullptr) ? *options.kernels : HamKernels_Best();
+
+	int threads = options.threads;
+	if (threads <= 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	auto run = [&](auto&& func, int count)
+	{
+		std::atomic<int> nextJob(0);
+		auto worker = [&]()
+		{
+			HamEncWork work;
+			for (int job = nextJob++; job < count; job = nextJob++)
+			{
+				func(work, job);
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (int t = 1; t < std::min(threads, count); t++)
+		{
+			pool.emplace_back(worker);
+		}
+		worker();
+		for (std::thread& thread : pool)
+		{
+			thread.join();
+		}
+	};
+
+	if (options.sharedPalette)
+	{
+		// All the images stacked up as one.
+		Image all;
+		all.width = images[0]->width;
+		for (const Image* image : images)
+		{
+			if (image->width != all.width)
+			{
+				fprintf(stderr, "Images sharing a palette must all be %d pixels wide\n", all.width);
+				return false;
+			}
+
+			all.height += image->height;
+			all.rgb.insert(all.rgb.end(), image->rgb.begin(), image->rgb.end());
+		}
+
+		HamEnc_ChoosePalette(all, hams[0].palette, kHamPaletteSize);
+		for (HamImage& ham : hams)
+		{
+			std::copy(hams[0].palette, hams[0].palette + kHamPaletteSize, ham.palette);
+		}
+	}
+	else
+	{
+		run([&](HamEncWork&, int i)
+		{
+			HamEnc_ChoosePalette(*images[i], hams[i].palette, kHamPaletteSize);
+			if (options.sliceColors > 0)
+			{
+				HamSlice_ChoosePalettes(*images[i], hams[i], options.sliceColors);
+			}
+		}, (int) images.size());
+	}
+	run([&](HamEncWork& work, int j)
+	{
+		const Image& image = *images[jobs[j].first];
+		HamImage& ham = hams[jobs[j].first];
+
+		if (options.greedy)
+		{
+			HamEnc_EncodeLineGreedy(kernels, image, jobs[j].second, ham);
+		}
+		else
+		{
+			HamEnc_EncodeLine(kernels, work, image, jobs[j].second, ham);
+		}
+	}, (int) jobs.size());
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HamEnc_Decode(const HamImage& ham, Image& image)
+{
+	image.width = ham.width;
+	image.height = ham.height;
+	image.rgb.resize((size_t) ham.width * ham.height * 3);
+
+	for (int y = 0; y < ham.height; y++)
+	{
+		const u8* in = ham.Row(y);
+		u8* out = image.Row(y);
+		const u16* palette = ham.Palette(y);
+		u16 c = palette[0];
+
+		for (int x = 0; x < ham.width; x++)
+		{
+			c = HamEnc_Hold(c, in[x], palette);
+			Rgb12To24(c, &out[x * 3]);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Same layout as sScreenBpl: whole planes back to back, rows of big endian
+// words, plane 0 holding bit 0 of every pixel code.
+////////////////////////////////////////////////////////////////////////////////
+void HamEnc_ToPlanar(const HamImage& ham, std::vector<u8>& planes)
+{
+	const int planeCount = HamEnc_Planes(ham.mode);
+	const int planeSize = ham.width / 8 * ham.height;
+
+	planes.assign((size_t) planeSize * planeCount, 0);
+
+	// The same conversion the target does with c2p_a.s.
+	C2p_Reference(ham.pixels.data(), planes.data(), planeSize, planeCount, ham.width * ham.height);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HamEnc_PaletteToBytes(const u16* palette, int count, std::vector<u8>& bytes)
+{
+	bytes.resize(count * 2);
+	for (int i = 0; i < count; i++)
+	{
+		PutBE16(&bytes[i * 2], palette[i]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+double HamEnc_Psnr(const Image& a, const Image& b)
+{
+	u64 sum = 0;
+	for (size_t i = 0; i < a.rgb.size(); i++)
+	{
+		int d = a.rgb[i] - b.rgb[i];
+		sum += (u64) (d * d);
+	}
+
+	if (sum == 0)
+	{
+		return 99.0;
+	}
+
+	double mse = (double) sum / (double) a.rgb.size();
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
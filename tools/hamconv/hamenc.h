@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamenc.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include "hamkernels.h"
+#include "image.h"
+#include "types.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+enum HamMode
+{
+	kHamModeHam6,
+	kHamModeHam5,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kHamPaletteSize = 16;
+static const int kHamStates		 = 4096;
+static const int kHamMaxWidth	 = 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+// HAM pixel codes as fetched from the bitplanes: bits 5-4 are the control
+// bits (set, modify blue, modify red, modify green), bits 3-0 the data.
+////////////////////////////////////////////////////////////////////////////////
+static const u8 kHamSet		= 0x00;
+static const u8 kHamModifyB = 0x10;
+static const u8 kHamModifyR = 0x20;
+static const u8 kHamModifyG = 0x30;
+
+////////////////////////////////////////////////////////////////////////////////
+// Squared colour error weights, applied in 8-bit space.
+////////////////////////////////////////////////////////////////////////////////
+static const int kHamWeightR = 3;
+static const int kHamWeightG = 4;
+static const int kHamWeightB = 2;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct HamImage
+{
+	HamMode mode = kHamModeHam6;
+	int width = 0;
+	int height = 0;
+	u16 palette[kHamPaletteSize] = {};
+	std::vector<u8> pixels;
+
+	// Sliced images: the palette in effect on each line, after the copper
+	// has reloaded up to sliceColors of colours 1-15 ahead of it.
+	int sliceColors = 0;
+	std::vector<u16> linePalettes;
+
+	const u8* Row(int y) const { return &pixels[(size_t) y * width]; }
+	u8* Row(int y) { return &pixels[(size_t) y * width]; }
+	const u16* Palette(int y) const { return (sliceColors > 0) ? &linePalettes[(size_t) y * kHamPaletteSize] : palette; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct HamEncOptions
+{
+	HamMode mode = kHamModeHam6;
+	int threads = 0;
+	bool greedy = false;
+	int sliceColors = 0;
+	bool sharedPalette = false;		// One palette for all images, as for animations.
+	const HamKernels* kernels = nullptr;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Per-thread scratch memory for the scanline search.
+////////////////////////////////////////////////////////////////////////////////
+struct HamEncWork
+{
+	std::vector<u32> cost[2];
+	std::vector<u8> choice;
+	std::vector<u16> back;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+inline int HamEnc_Planes(HamMode mode) { return ((mode == kHamModeHam5) ? 5 : 6); }
+inline u32 HamEnc_ChannelError(int c4, int t8, int weight) { int d = c4 * 17 - t8; return (u32) (weight * d * d); }
+
+////////////////////////////////////////////////////////////////////////////////
+// The hold colour after a pixel code, and the code for a scoring candidate
+// (see HamScoreFunc) with the target it was scored against.
+////////////////////////////////////////////////////////////////////////////////
+inline u16 HamEnc_Hold(u16 hold, u8 code, const u16* palette)
+{
+	switch (code & 0x30)
+	{
+		case kHamSet:	  return palette[code & 15];
+		case kHamModifyB: return (u16) ((hold & 0xff0) | (code & 15));
+		case kHamModifyR: return (u16) ((hold & 0x0ff) | ((code & 15) << 8));
+		default:		  return (u16) ((hold & 0xf0f) | ((code & 15) << 4));
+	}
+}
+
+inline u8 HamEnc_CandidateCode(int candidate, const u8* target)
+{
+	switch (candidate)
+	{
+		case 16: return (u8) (kHamModifyB | ((target[2] + 8) / 17));
+		case 17: return (u8) (kHamModifyR | ((target[0] + 8) / 17));
+		case 18: return (u8) (kHamModifyG | ((target[1] + 8) / 17));
+		default: return (u8) (kHamSet | candidate);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HamEnc_ChoosePalette(const Image& image, u16* palette, int count);
+u32 HamEnc_EncodeLine(const HamKernels& kernels, HamEncWork& work, const Image& image, int y, HamImage& ham);
+u32 HamEnc_EncodeLineGreedy(const HamKernels& kernels, const Image& image, int y, HamImage& ham);
+bool HamEnc_Encode(const std::vector<const Image*>& images, const HamEncOptions& options, std::vector<HamImage>& hams);
+
+////////////////////////////////////////////////////////////////////////////////
+// Sliced HAM, see hamslice.cpp.
+////////////////////////////////////////////////////////////////////////////////
+int HamSlice_MaxColors(HamMode mode, int width);
+void HamSlice_ChoosePalettes(const Image& image, HamImage& ham, int sliceColors);
+void HamSlice_ToCopper(const HamImage& ham, std::vector<u8>& bytes);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HamEnc_Decode(const HamImage& ham, Image& image);
+inline u32 HamEnc_ColorError(u16 a, u16 b) { int dr = (a >> 8) - (b >> 8); int dg = ((a >> 4) & 15) - ((b >> 4) & 15); int db = (a & 15) - (b & 15); return (u32) (289 * (kHamWeightR * dr * dr + kHamWeightG * dg * dg + kHamWeightB * db * db)); }
+void HamEnc_ToPlanar(const HamImage& ham, std::vector<u8>& planes);
+void HamEnc_PaletteToBytes(const u16* palette, int count, std::vector<u8>& bytes);
+double HamEnc_Psnr(const Image& a, const Image& b);
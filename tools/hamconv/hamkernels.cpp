@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamkernels.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hamkernels.h"
+#include <string.h>
+#include "hamenc.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool Scalar_Supported()
+{
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Scalar_Step(const u32* prev, u32* next, u8* choice, u16* back, const u32* err, bool ham6)
+{
+	const u32* errR = err;
+	const u32* errG = err + 16;
+	const u32* errB = err + 32;
+
+	u16* backB = back + 1;
+	u16* backR = back + 1 + 256;
+	u16* backG = back + 1 + 512;
+
+	// Cheapest state for each channel pair, i.e. the best predecessor of
+	// every modify.
+	u32 minB[256], minR[256], minG[256];
+	for (int rg = 0; rg < 256; rg++)
+	{
+		const u32* p = &prev[rg << 4];
+		u32 m = p[0];
+		int a = 0;
+		for (int b = 1; b < 16; b++)
+		{
+			if (p[b] < m)
+			{
+				m = p[b];
+				a = b;
+			}
+		}
+		minB[rg] = m;
+		backB[rg] = (u16) ((rg << 4) | a);
+	}
+
+	// The overall best state is the best of the per-pair minima.
+	u32 best = minB[0];
+	back[0] = backB[0];
+	for (int rg = 1; rg < 256; rg++)
+	{
+		if (minB[rg] < best)
+		{
+			best = minB[rg];
+			back[0] = backB[rg];
+		}
+	}
+
+	if (ham6)
+	{
+		for (int gb = 0; gb < 256; gb++)
+		{
+			minR[gb] = prev[gb];
+			backR[gb] = (u16) gb;
+		}
+		for (int r = 1; r < 16; r++)
+		{
+			const u32* p = &prev[r << 8];
+			for (int gb = 0; gb < 256; gb++)
+			{
+				if (p[gb] < minR[gb])
+				{
+					minR[gb] = p[gb];
+					backR[gb] = (u16) ((r << 8) | gb);
+				}
+			}
+		}
+
+		for (int r = 0; r < 16; r++)
+		{
+			u32* m = &minG[r << 4];
+			u16* a = &backG[r << 4];
+			for (int b = 0; b < 16; b++)
+			{
+				m[b] = prev[(r << 8) | b];
+				a[b] = (u16) ((r << 8) | b);
+			}
+			for (int g = 1; g < 16; g++)
+			{
+				const u32* p = &prev[(r << 8) | (g << 4)];
+				for (int b = 0; b < 16; b++)
+				{
+					if (p[b] < m[b])
+					{
+						m[b] = p[b];
+						a[b] = (u16) ((r << 8) | (g << 4) | b);
+					}
+				}
+			}
+		}
+	}
+
+	for (int rg = 0; rg < 256; rg++)
+	{
+		int r = rg >> 4;
+		int g = rg & 15;
+		u32 errRG = errR[r] + errG[g];
+		const u32* mR = &minR[g << 4];
+		const u32* mG = &minG[r << 4];
+
+		for (int b = 0; b < 16; b++)
+		{
+			u32 c = minB[rg];
+			u8 v = (u8) (kHamModifyB | b);
+
+			if (ham6)
+			{
+				if (mR[b] < c)
+				{
+					c = mR[b];
+					v = (u8) (kHamModifyR | r);
+				}
+				if (mG[b] < c)
+				{
+					c = mG[b];
+					v = (u8) (kHamModifyG | g);
+				}
+			}
+
+			next[(rg << 4) | b] = c + errRG + errB[b];
+			choice[(rg << 4) | b] = v;
+		}
+	}
+
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static int Scalar_Score(u16 hold, const u8* target, const HamScorePalette& palette, bool ham6, u32* scores)
+{
+	const int tr = target[0];
+	const int tg = target[1];
+	const int tb = target[2];
+
+	for (int i = 0; i < 16; i++)
+	{
+		int dr = palette.r[i] - tr;
+		int dg = palette.g[i] - tg;
+		int db = palette.b[i] - tb;
+		scores[i] = (u32) (kHamWeightR * dr * dr + kHamWeightG * dg * dg + kHamWeightB * db * db);
+	}
+
+	u32 holdR = HamEnc_ChannelError((hold >> 8) & 15, tr, kHamWeightR);
+	u32 holdG = HamEnc_ChannelError((hold >> 4) & 15, tg, kHamWeightG);
+	u32 holdB = HamEnc_ChannelError(hold & 15, tb, kHamWeightB);
+
+	scores[16] = holdR + holdG + HamEnc_ChannelError((tb + 8) / 17, tb, kHamWeightB);
+	scores[17] = ham6 ? (HamEnc_ChannelError((tr + 8) / 17, tr, kHamWeightR) + holdG + holdB) : kHamNoCandidate;
+	scores[18] = ham6 ? (holdR + HamEnc_ChannelError((tg + 8) / 17, tg, kHamWeightG) + holdB) : kHamNoCandidate;
+
+	int best = 0;
+	for (int i = 1; i < kHamCandidates; i++)
+	{
+		if (scores[i] < scores[best])
+		{
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+const HamKernels kHamKernelsScalar = {"scalar", Scalar_Supported, Scalar_Step, Scalar_Score};
+
+////////////////////////////////////////////////////////////////////////////////
+// Fastest first.
+////////////////////////////////////////////////////////////////////////////////
+static const HamKernels* const kKernels[] = {&kHamKernelsAvx2, &kHamKernelsSse4, &kHamKernelsScalar};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int HamKernels_Count()
+{
+	return countof(kKernels);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+const HamKernels& HamKernels_Get(int index)
+{
+	return *kKernels[index];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+const HamKernels* HamKernels_Find(const char* name)
+{
+	for (const HamKernels* kernels : kKernels)
+	{
+		if (!strcmp(kernels->name, name) && kernels->supported())
+		{
+			return kernels;
+		}
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+const HamKernels& HamKernels_Best()
+{
+	for (const HamKernels* kernels : kKernels)
+	{
+		if (kernels->supported())
+		{
+			return *kernels;
+		}
+	}
+
+	return kHamKernelsScalar;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HamKernels_PreparePalette(const u16* palette, HamScorePalette& out)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		out.r[i] = ((palette[i] >> 8) & 15) * 17;
+		out.g[i] = ((palette[i] >> 4) & 15) * 17;
+		out.b[i] = (palette[i] & 15) * 17;
+	}
+}
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamkernels.h
+//
+// Colour error kernels used by the HAM encoder. Every instruction set variant
+// is pure integer arithmetic with the same tie-breaking (first minimum wins),
+// so all of them produce bit-identical results to the scalar reference.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "types.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kHamBackStride	= 1 + 3 * 256;
+static const int kHamCandidates	= 16 + 3;
+static const u32 kHamNoCandidate = 0xffffffff;
+
+////////////////////////////////////////////////////////////////////////////////
+// Base palette expanded to 8-bit channels for the candidate scoring kernel.
+////////////////////////////////////////////////////////////////////////////////
+struct alignas(32) HamScorePalette
+{
+	s32 r[16];
+	s32 g[16];
+	s32 b[16];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// One Viterbi step over all 4096 hold colours.
+//
+// prev/next: path cost per state, indexed 0xrgb.
+// choice:	  per state, the HAM pixel code of the cheapest modify into it.
+// back:	  kHamBackStride entries; [0] best state overall, then the best
+//			  predecessor per GB, RB and RG pair for modify R, G and B.
+// err:		  weighted channel errors against the target, R[16] G[16] B[16].
+//
+// Returns the cost of the best previous state. Setting a palette entry is
+// left to the caller, as only 16 states can be reached that way.
+////////////////////////////////////////////////////////////////////////////////
+typedef u32 (HamStepFunc)(const u32* prev, u32* next, u8* choice, u16* back, const u32* err, bool ham6);
+
+////////////////////////////////////////////////////////////////////////////////
+// Scores every candidate for one pixel given the current hold colour: the 16
+// base colours, then modify B, R and G to the nearest 4-bit channel value.
+// Modify R/G score kHamNoCandidate in HAM5. Returns the best candidate.
+////////////////////////////////////////////////////////////////////////////////
+typedef int (HamScoreFunc)(u16 hold, const u8* target, const HamScorePalette& palette, bool ham6, u32* scores);
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct HamKernels
+{
+	const char* name;
+	bool (*supported)();
+	HamStepFunc* step;
+	HamScoreFunc* score;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+extern const HamKernels kHamKernelsScalar;
+extern const HamKernels kHamKernelsSse4;
+extern const HamKernels kHamKernelsAvx2;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int HamKernels_Count();
+const HamKernels& HamKernels_Get(int index);
+const HamKernels* HamKernels_Find(const char* name);
+const HamKernels& HamKernels_Best();
+void HamKernels_PreparePalette(const u16* palette, HamScorePalette& out);
@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamkernels_avx2.cpp
+//
+// Built with -mavx2; only called when the CPU reports AVX2. Path costs stay
+// below 2^31, so signed compares are safe for the unsigned costs.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hamkernels.h"
+#include <immintrin.h>
+#include "hamenc.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool Avx2_Supported()
+{
+	return __builtin_cpu_supports("avx2");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Eight u32 lanes to eight u16s.
+////////////////////////////////////////////////////////////////////////////////
+static inline void Store8x16(u16* out, __m256i v)
+{
+	__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0x08);
+	_mm_storeu_si128((__m128i*) out, _mm256_castsi256_si128(packed));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Two sets of eight u32 lanes to sixteen bytes, in order.
+////////////////////////////////////////////////////////////////////////////////
+static inline void Store16x8(u8* out, __m256i lo, __m256i hi)
+{
+	__m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8);
+	__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+	_mm_storeu_si128((__m128i*) out, _mm256_castsi256_si128(bytes));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Running minimum per lane, tagging lanes where v is strictly smaller so the
+// first minimum wins ties.
+////////////////////////////////////////////////////////////////////////////////
+static inline void MinStep(__m256i& m, __m256i& tag, __m256i v, __m256i vtag)
+{
+	__m256i lt = _mm256_cmpgt_epi32(m, v);
+	m = _mm256_blendv_epi8(m, v, lt);
+	tag = _mm256_blendv_epi8(tag, vtag, lt);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Avx2_Step(const u32* prev, u32* next, u8* choice, u16* back, const u32* err, bool ham6)
+{
+	const u32* errR = err;
+	const u32* errG = err + 16;
+	const u32* errB = err + 32;
+
+	u16* backB = back + 1;
+	u16* backR = back + 1 + 256;
+	u16* backG = back + 1 + 512;
+
+	alignas(32) u32 minB[256], minR[256], minG[256];
+
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	for (int rg = 0; rg < 256; rg++)
+	{
+		__m256i lo = _mm256_loadu_si256((const __m256i*) &prev[rg << 4]);
+		__m256i hi = _mm256_loadu_si256((const __m256i*) &prev[(rg << 4) + 8]);
+
+		__m256i m = _mm256_min_epu32(lo, hi);
+		m = _mm256_min_epu32(m, _mm256_permute2x128_si256(m, m, 1));
+		m = _mm256_min_epu32(m, _mm256_shuffle_epi32(m, 0x4e));
+		m = _mm256_min_epu32(m, _mm256_shuffle_epi32(m, 0xb1));
+
+		int eqLo = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lo, m)));
+		int eqHi = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hi, m)));
+
+		minB[rg] = (u32) _mm256_cvtsi256_si32(m);
+		backB[rg] = (u16) ((rg << 4) | __builtin_ctz(eqLo | (eqHi << 8)));
+	}
+
+	u32 best = minB[0];
+	back[0] = backB[0];
+	for (int rg = 1; rg < 256; rg++)
+	{
+		if (minB[rg] < best)
+		{
+			best = minB[rg];
+			back[0] = backB[rg];
+		}
+	}
+
+	if (ham6)
+	{
+		for (int gb = 0; gb < 256; gb += 8)
+		{
+			__m256i m = _mm256_loadu_si256((const __m256i*) &prev[gb]);
+			__m256i a = _mm256_setzero_si256();
+			for (int r = 1; r < 16; r++)
+			{
+				MinStep(m, a, _mm256_loadu_si256((const __m256i*) &prev[(r << 8) | gb]), _mm256_set1_epi32(r));
+			}
+
+			_mm256_store_si256((__m256i*) &minR[gb], m);
+			Store8x16(&backR[gb], _mm256_or_si256(_mm256_slli_epi32(a, 8), _mm256_add_epi32(lanes, _mm256_set1_epi32(gb))));
+		}
+
+		for (int r = 0; r < 16; r++)
+		{
+			for (int h = 0; h < 16; h += 8)
+			{
+				__m256i m = _mm256_loadu_si256((const __m256i*) &prev[(r << 8) | h]);
+				__m256i a = _mm256_setzero_si256();
+				for (int g = 1; g < 16; g++)
+				{
+					MinStep(m, a, _mm256_loadu_si256((const __m256i*) &prev[(r << 8) | (g << 4) | h]), _mm256_set1_epi32(g));
+				}
+
+				_mm256_store_si256((__m256i*) &minG[(r << 4) | h], m);
+				Store8x16(&backG[(r << 4) | h], _mm256_or_si256(_mm256_slli_epi32(a, 4), _mm256_add_epi32(lanes, _mm256_set1_epi32((r << 8) | h))));
+			}
+		}
+	}
+
+	const __m256i errBLo = _mm256_loadu_si256((const __m256i*) &errB[0]);
+	const __m256i errBHi = _mm256_loadu_si256((const __m256i*) &errB[8]);
+	const __m256i modBLo = _mm256_add_epi32(lanes, _mm256_set1_epi32(kHamModifyB));
+	const __m256i modBHi = _mm256_add_epi32(lanes, _mm256_set1_epi32(kHamModifyB | 8));
+
+	for (int rg = 0; rg < 256; rg++)
+	{
+		int r = rg >> 4;
+		int g = rg & 15;
+
+		__m256i cLo = _mm256_set1_epi32((int) minB[rg]);
+		__m256i cHi = cLo;
+		__m256i vLo = modBLo;
+		__m256i vHi = modBHi;
+
+		if (ham6)
+		{
+			__m256i modR = _mm256_set1_epi32(kHamModifyR | r);
+			__m256i modG = _mm256_set1_epi32(kHamModifyG | g);
+
+			MinStep(cLo, vLo, _mm256_load_si256((const __m256i*) &minR[g << 4]), modR);
+			MinStep(cHi, vHi, _mm256_load_si256((const __m256i*) &minR[(g << 4) + 8]), modR);
+			MinStep(cLo, vLo, _mm256_load_si256((const __m256i*) &minG[r << 4]), modG);
+			MinStep(cHi, vHi, _mm256_load_si256((const __m256i*) &minG[(r << 4) + 8]), modG);
+		}
+
+		__m256i errRG = _mm256_set1_epi32((int) (errR[r] + errG[g]));
+		_mm256_storeu_si256((__m256i*) &next[rg << 4], _mm256_add_epi32(cLo, _mm256_add_epi32(errRG, errBLo)));
+		_mm256_storeu_si256((__m256i*) &next[(rg << 4) + 8], _mm256_add_epi32(cHi, _mm256_add_epi32(errRG, errBHi)));
+		Store16x8(&choice[rg << 4], vLo, vHi);
+	}
+
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static int Avx2_Score(u16 hold, const u8* target, const HamScorePalette& palette, bool ham6, u32* scores)
+{
+	const int tr = target[0];
+	const int tg = target[1];
+	const int tb = target[2];
+
+	const __m256i r = _mm256_set1_epi32(tr);
+	const __m256i g = _mm256_set1_epi32(tg);
+	const __m256i b = _mm256_set1_epi32(tb);
+	const __m256i wr = _mm256_set1_epi32(kHamWeightR);
+	const __m256i wg = _mm256_set1_epi32(kHamWeightG);
+	const __m256i wb = _mm256_set1_epi32(kHamWeightB);
+
+	__m256i m = _mm256_set1_epi32(-1);
+	for (int i = 0; i < 16; i += 8)
+	{
+		__m256i dr = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*) &palette.r[i]), r);
+		__m256i dg = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*) &palette.g[i]), g);
+		__m256i db = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*) &palette.b[i]), b);
+
+		__m256i e = _mm256_mullo_epi32(wr, _mm256_mullo_epi32(dr, dr));
+		e = _mm256_add_epi32(e, _mm256_mullo_epi32(wg, _mm256_mullo_epi32(dg, dg)));
+		e = _mm256_add_epi32(e, _mm256_mullo_epi32(wb, _mm256_mullo_epi32(db, db)));
+
+		_mm256_storeu_si256((__m256i*) &scores[i], e);
+		m = _mm256_min_epu32(m, e);
+	}
+
+	m = _mm256_min_epu32(m, _mm256_permute2x128_si256(m, m, 1));
+	m = _mm256_min_epu32(m, _mm256_shuffle_epi32(m, 0x4e));
+	m = _mm256_min_epu32(m, _mm256_shuffle_epi32(m, 0xb1));
+
+	int eqLo = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) &scores[0]), m)));
+	int eqHi = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) &scores[8]), m)));
+	int best = __builtin_ctz(eqLo | (eqHi << 8));
+
+	u32 holdR = HamEnc_ChannelError((hold >> 8) & 15, tr, kHamWeightR);
+	u32 holdG = HamEnc_ChannelError((hold >> 4) & 15, tg, kHamWeightG);
+	u32 holdB = HamEnc_ChannelError(hold & 15, tb, kHamWeightB);
+
+	scores[16] = holdR + holdG + HamEnc_ChannelError((tb + 8) / 17, tb, kHamWeightB);
+	scores[17] = ham6 ? (HamEnc_ChannelError((tr + 8) / 17, tr, kHamWeightR) + holdG + holdB) : kHamNoCandidate;
+	scores[18] = ham6 ? (holdR + HamEnc_ChannelError((tg + 8) / 17, tg, kHamWeightG) + holdB) : kHamNoCandidate;
+
+	for (int i = 16; i < kHamCandidates; i++)
+	{
+		if (scores[i] < scores[best])
+		{
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+const HamKernels kHamKernelsAvx2 = {"avx2", Avx2_Supported, Avx2_Step, Avx2_Score};
@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamkernels_sse4.cpp
+//
+// Built with -msse4.1; only called when the CPU reports SSE4.1. Path costs
+// stay below 2^31, so signed compares are safe for the unsigned costs.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hamkernels.h"
+#include <smmintrin.h>
+#include "hamenc.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool Sse4_Supported()
+{
+	return __builtin_cpu_supports("sse4.1");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Running minimum per lane, tagging lanes where v is strictly smaller so the
+// first minimum wins ties.
+////////////////////////////////////////////////////////////////////////////////
+static inline void MinStep(__m128i& m, __m128i& tag, __m128i v, __m128i vtag)
+{
+	__m128i lt = _mm_cmpgt_epi32(m, v);
+	m = _mm_blendv_epi8(m, v, lt);
+	tag = _mm_blendv_epi8(tag, vtag, lt);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static inline __m128i HorizontalMin(__m128i m)
+{
+	m = _mm_min_epu32(m, _mm_shuffle_epi32(m, 0x4e));
+	return _mm_min_epu32(m, _mm_shuffle_epi32(m, 0xb1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static inline int FirstEqual(const __m128i* v, int count, __m128i m)
+{
+	int mask = 0;
+	for (int i = 0; i < count; i++)
+	{
+		mask |= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v[i], m))) << (i * 4);
+	}
+	return __builtin_ctz(mask);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Sse4_Step(const u32* prev, u32* next, u8* choice, u16* back, const u32* err, bool ham6)
+{
+	const u32* errR = err;
+	const u32* errG = err + 16;
+	const u32* errB = err + 32;
+
+	u16* backB = back + 1;
+	u16* backR = back + 1 + 256;
+	u16* backG = back + 1 + 512;
+
+	alignas(16) u32 minB[256], minR[256], minG[256];
+
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+
+	for (int rg = 0; rg < 256; rg++)
+	{
+		__m128i v[4];
+		for (int i = 0; i < 4; i++)
+		{
+			v[i] = _mm_loadu_si128((const __m128i*) &prev[(rg << 4) + i * 4]);
+		}
+
+		__m128i m = HorizontalMin(_mm_min_epu32(_mm_min_epu32(v[0], v[1]), _mm_min_epu32(v[2], v[3])));
+
+		minB[rg] = (u32) _mm_cvtsi128_si32(m);
+		backB[rg] = (u16) ((rg << 4) | FirstEqual(v, 4, m));
+	}
+
+	u32 best = minB[0];
+	back[0] = backB[0];
+	for (int rg = 1; rg < 256; rg++)
+	{
+		if (minB[rg] < best)
+		{
+			best = minB[rg];
+			back[0] = backB[rg];
+		}
+	}
+
+	if (ham6)
+	{
+		for (int gb = 0; gb < 256; gb += 4)
+		{
+			__m128i m = _mm_loadu_si128((const __m128i*) &prev[gb]);
+			__m128i a = _mm_setzero_si128();
+			for (int r = 1; r < 16; r++)
+			{
+				MinStep(m, a, _mm_loadu_si128((const __m128i*) &prev[(r << 8) | gb]), _mm_set1_epi32(r));
+			}
+
+			_mm_store_si128((__m128i*) &minR[gb], m);
+			__m128i ids = _mm_or_si128(_mm_slli_epi32(a, 8), _mm_add_epi32(lanes, _mm_set1_epi32(gb)));
+			_mm_storel_epi64((__m128i*) &backR[gb], _mm_packus_epi32(ids, ids));
+		}
+
+		for (int r = 0; r < 16; r++)
+		{
+			for (int h = 0; h < 16; h += 4)
+			{
+				__m128i m = _mm_loadu_si128((const __m128i*) &prev[(r << 8) | h]);
+				__m128i a = _mm_setzero_si128();
+				for (int g = 1; g < 16; g++)
+				{
+					MinStep(m, a, _mm_loadu_si128((const __m128i*) &prev[(r << 8) | (g << 4) | h]), _mm_set1_epi32(g));
+				}
+
+				_mm_store_si128((__m128i*) &minG[(r << 4) | h], m);
+				__m128i ids = _mm_or_si128(_mm_slli_epi32(a, 4), _mm_add_epi32(lanes, _mm_set1_epi32((r << 8) | h)));
+				_mm_storel_epi64((__m128i*) &backG[(r << 4) | h], _mm_packus_epi32(ids, ids));
+			}
+		}
+	}
+
+	for (int rg = 0; rg < 256; rg++)
+	{
+		int r = rg >> 4;
+		int g = rg & 15;
+
+		const __m128i errRG = _mm_set1_epi32((int) (errR[r] + errG[g]));
+		const __m128i modR = _mm_set1_epi32(kHamModifyR | r);
+		const __m128i modG = _mm_set1_epi32(kHamModifyG | g);
+
+		__m128i v[4];
+		for (int i = 0; i < 4; i++)
+		{
+			__m128i c = _mm_set1_epi32((int) minB[rg]);
+			v[i] = _mm_add_epi32(lanes, _mm_set1_epi32(kHamModifyB | (i * 4)));
+
+			if (ham6)
+			{
+				MinStep(c, v[i], _mm_load_si128((const __m128i*) &minR[(g << 4) + i * 4]), modR);
+				MinStep(c, v[i], _mm_load_si128((const __m128i*) &minG[(r << 4) + i * 4]), modG);
+			}
+
+			__m128i e = _mm_add_epi32(errRG, _mm_loadu_si128((const __m128i*) &errB[i * 4]));
+			_mm_storeu_si128((__m128i*) &next[(rg << 4) + i * 4], _mm_add_epi32(c, e));
+		}
+
+		__m128i words = _mm_packus_epi16(_mm_packus_epi32(v[0], v[1]), _mm_packus_epi32(v[2], v[3]));
+		_mm_storeu_si128((__m128i*) &choice[rg << 4], words);
+	}
+
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static int Sse4_Score(u16 hold, const u8* target, const HamScorePalette& palette, bool ham6, u32* scores)
+{
+	const int tr = target[0];
+	const int tg = target[1];
+	const int tb = target[2];
+
+	const __m128i r = _mm_set1_epi32(tr);
+	const __m128i g = _mm_set1_epi32(tg);
+	const __m128i b = _mm_set1_epi32(tb);
+	const __m128i wr = _mm_set1_epi32(kHamWeightR);
+	const __m128i wg = _mm_set1_epi32(kHamWeightG);
+	const __m128i wb = _mm_set1_epi32(kHamWeightB);
+
+	__m128i e[4];
+	__m128i m = _mm_set1_epi32(-1);
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i dr = _mm_sub_epi32(_mm_loadu_si128((const __m128i*) &palette.r[i * 4]), r);
+		__m128i dg = _mm_sub_epi32(_mm_loadu_si128((const __m128i*) &palette.g[i * 4]), g);
+		__m128i db = _mm_sub_epi32(_mm_loadu_si128((const __m128i*) &palette.b[i * 4]), b);
+
+		e[i] = _mm_mullo_epi32(wr, _mm_mullo_epi32(dr, dr));
+		e[i] = _mm_add_epi32(e[i], _mm_mullo_epi32(wg, _mm_mullo_epi32(dg, dg)));
+		e[i] = _mm_add_epi32(e[i], _mm_mullo_epi32(wb, _mm_mullo_epi32(db, db)));
+
+		_mm_storeu_si128((__m128i*) &scores[i * 4], e[i]);
+		m = _mm_min_epu32(m, e[i]);
+	}
+
+	int best = FirstEqual(e, 4, HorizontalMin(m));
+
+	u32 holdR = HamEnc_ChannelError((hold >> 8) & 15, tr, kHamWeightR);
+	u32 holdG = HamEnc_ChannelError((hold >> 4) & 15, tg, kHamWeightG);
+	u32 holdB = HamEnc_ChannelError(hold & 15, tb, kHamWeightB);
+
+	scores[16] = holdR + holdG + HamEnc_ChannelError((tb + 8) / 17, tb, kHamWeightB);
+	scores[17] = ham6 ? (HamEnc_ChannelError((tr + 8) / 17, tr, kHamWeightR) + holdG + holdB) : kHamNoCandidate;
+	scores[18] = ham6 ? (holdR + HamEnc_ChannelError((tg + 8) / 17, tg, kHamWeightG) + holdB) : kHamNoCandidate;
+
+	for (int i = 16; i < kHamCandidates; i++)
+	{
+		if (scores[i] < scores[best])
+		{
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+const HamKernels kHamKernelsSse4 = {"sse4", Sse4_Supported, Sse4_Step, Sse4_Score};
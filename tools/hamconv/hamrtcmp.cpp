@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamrtcmp.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hamrtcmp.h"
+#include <stdio.h>
+#include "hamrtref.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 8 to 4 bits the way the encoder rounds, c4 * 17 being nearest to c8.
+////////////////////////////////////////////////////////////////////////////////
+static int Nibble(int c8)
+{
+	return (c8 + 8) / 17;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The image averaged over pixelWidth x pixelHeight blocks, as the 12 bit
+// pixels a real-time effect would draw.
+////////////////////////////////////////////////////////////////////////////////
+static void Reduce(const Image& image, int pixelWidth, int pixelHeight, std::vector<u16>& rgb)
+{
+	const int width = image.width / pixelWidth;
+	const int height = image.height / pixelHeight;
+	const int count = pixelWidth * pixelHeight;
+
+	rgb.resize((size_t) width * height);
+
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			int sum[3] = {};
+
+			for (int j = 0; j < pixelHeight; j++)
+			{
+				const u8* p = image.Row(y * pixelHeight + j) + x * pixelWidth * 3;
+
+				for (int i = 0; i < pixelWidth * 3; i++)
+				{
+					sum[i % 3] += p[i];
+				}
+			}
+
+			int r = Nibble((sum[0] + count / 2) / count);
+			int g = Nibble((sum[1] + count / 2) / count);
+			int b = Nibble((sum[2] + count / 2) / count);
+
+			rgb[(size_t) y * width + x] = (u16) ((r << 8) | (g << 4) | b);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static double Psnr(const Image& image, const HamImage& ham)
+{
+	Image decoded;
+	HamEnc_Decode(ham, decoded);
+
+	return HamEnc_Psnr(image, decoded);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Everything on the image cropped to even sizes, so that all rows cover the
+// same pixels.
+////////////////////////////////////////////////////////////////////////////////
+bool HamRtCmp_Run(const Image& image, const HamEncOptions& options)
+{
+	if (options.mode != kHamModeHam6 || options.sliceColors > 0)
+	{
+		fprintf(stderr, "-rt: real-time conversion is plain HAM6 only\n");
+		return false;
+	}
+
+	Image cropped;
+	cropped.width = image.width & ~1;
+	cropped.height = image.height & ~1;
+	for (int y = 0; y < cropped.height; y++)
+	{
+		cropped.rgb.insert(cropped.rgb.end(), image.Row(y), image.Row(y) + cropped.width * 3);
+	}
+
+	if (cropped.width == 0 || cropped.height == 0)
+	{
+		fprintf(stderr, "-rt: image too small\n");
+		return false;
+	}
+
+	HamEncOptions searchOptions = options;
+	std::vector<HamImage> hams;
+	searchOptions.greedy = false;
+
+	if (!HamEnc_Encode({&cropped}, searchOptions, hams))
+	{
+		return false;
+	}
+
+	HamImage& ham = hams[0];
+	double search = Psnr(cropped, ham);
+
+	const HamKernels& kernels = (options.kernels != nullptr) ? *options.kernels : HamKernels_Best();
+	for (int y = 0; y < ham.height; y++)
+	{
+		HamEnc_EncodeLineGreedy(kernels, cropped, y, ham);
+	}
+
+	double greedy = Psnr(cropped, ham);
+
+	static HamRtTables tables;
+	HamRt_ReferenceTables(tables, ham.palette);
+
+	printf("%-16s %8s %8s\n", "encoder", "PSNR", "change");
+	printf("%-16s %8.2f\n", "search", search);
+	printf("%-16s %8.2f %+8.2f\n", "greedy", greedy, greedy - search);
+
+	static const int kPixels[][2] = {{1, 1}, {2, 1}, {2, 2}};
+	for (const auto& pixel : kPixels)
+	{
+		std::vector<u16> rgb;
+		Reduce(cropped, pixel[0], pixel[1], rgb);
+		HamRt_Reference(tables, rgb.data(), ham.pixels.data(), cropped.width / pixel[0], cropped.height / pixel[1], pixel[0], pixel[1]);
+
+		double rt = Psnr(cropped, ham);
+		char name[32];
+		snprintf(name, sizeof(name), "real-time %dx%d", pixel[0], pixel[1]);
+		printf("%-16s %8.2f %+8.2f\n", name, rt, rt - search);
+	}
+
+	return true;
+}
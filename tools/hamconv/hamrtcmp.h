@@ -0,0 +1,15 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamrtcmp.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "hamenc.h"
+#include "image.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Prints the PSNR of the real-time conversion (hamrtref.h) of the image at
+// 1x1, 2x1 and 2x2 pixels, against the full search and the offline greedy
+// choice with the same palette.
+////////////////////////////////////////////////////////////////////////////////
+bool HamRtCmp_Run(const Image& image, const HamEncOptions& options);
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////
+// hamslice.cpp
+//
+// Sliced HAM: the copper reloads some of colours 1-15 between lines, in the
+// slots left over after the display window (see dmaslots.h). Colour 0 is
+// never reloaded, as it doubles as the border colour.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "dmaslots.h"
+#include "hamenc.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kSliceRegisters = kHamPaletteSize - 1;
+static const u16 kColorRegister	 = 0x180;
+
+////////////////////////////////////////////////////////////////////////////////
+// Same fetch window as PackDdfstrt/PackDdfstop on the target for a lowres
+// display starting at sx = 0.
+////////////////////////////////////////////////////////////////////////////////
+int HamSlice_MaxColors(HamMode mode, int width)
+{
+	const int ddfstrt = ((0x81 - 17) / 2) & 0xfc;
+	const int ddfstop = ddfstrt + 8 * (width / 16 - 1);
+
+	DmaConfig config = {HamEnc_Planes(mode), false, ddfstrt, ddfstop, 0, 0, 0};
+
+	return std::min(kSliceRegisters, Dma_SliceMoves(config, 0, width));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Walks down the image keeping the palette the copper has built up so far.
+// Each line gets its own 15 colour median cut; every line colour is paired
+// with the closest register still free, and the sliceColors pairs that
+// save the most error (weighted by how many pixels want that colour) are
+// reloaded.
+////////////////////////////////////////////////////////////////////////////////
+void HamSlice_ChoosePalettes(const Image& image, HamImage& ham, int sliceColors)
+{
+	ham.sliceColors = sliceColors;
+	ham.linePalettes.resize((size_t) image.height * kHamPaletteSize);
+
+	u16 current[kHamPaletteSize];
+	std::copy(ham.palette, ham.palette + kHamPaletteSize, current);
+
+	Image line;
+	line.width = image.width;
+	line.height = 1;
+
+	for (int y = 0; y < image.height; y++)
+	{
+		line.rgb.assign(image.Row(y), image.Row(y) + image.width * 3);
+
+		u16 wanted[kSliceRegisters];
+		HamEnc_ChoosePalette(line, wanted, kSliceRegisters);
+
+		int count[kSliceRegisters] = {};
+		for (int x = 0; x < image.width; x++)
+		{
+			const u8* p = &line.rgb[x * 3];
+			u16 c = (u16) ((((p[0] + 8) / 17) << 8) | (((p[1] + 8) / 17) << 4) | ((p[2] + 8) / 17));
+
+			int nearest = 0;
+			for (int j = 1; j < kSliceRegisters; j++)
+			{
+				if (HamEnc_ColorError(c, wanted[j]) < HamEnc_ColorError(c, wanted[nearest]))
+				{
+					nearest = j;
+				}
+			}
+			count[nearest]++;
+		}
+
+		int order[kSliceRegisters];
+		for (int j = 0; j < kSliceRegisters; j++)
+		{
+			order[j] = j;
+		}
+		std::stable_sort(order, order + kSliceRegisters, [&count](int a, int b) { return count[a] > count[b]; });
+
+		struct Reload { u64 gain; int reg; u16 color; };
+		Reload reloads[kSliceRegisters];
+		bool taken[kHamPaletteSize] = {true};
+
+		for (int k = 0; k < kSliceRegisters; k++)
+		{
+			int j = order[k];
+
+			int reg = -1;
+			for (int i = 1; i < kHamPaletteSize; i++)
+			{
+				if (!taken[i] && (reg < 0 || HamEnc_ColorError(current[i], wanted[j]) < HamEnc_ColorError(current[reg], wanted[j])))
+				{
+					reg = i;
+				}
+			}
+
+			taken[reg] = true;
+			reloads[k] = {(u64) count[j] * HamEnc_ColorError(current[reg], wanted[j]), reg, wanted[j]};
+		}
+
+		std::stable_sort(reloads, reloads + kSliceRegisters, [](const Reload& a, const Reload& b) { return a.gain > b.gain; });
+
+		for (int k = 0; k < sliceColors && reloads[k].gain > 0; k++)
+		{
+			current[reloads[k].reg] = reloads[k].color;
+		}
+
+		std::copy(current, current + kHamPaletteSize, &ham.linePalettes[(size_t) y * kHamPaletteSize]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// sliceColors big endian copper MOVEs per line, in the CopList::Slice layout
+// minus the WAIT. Lines with fewer reloads are padded with moves that write
+// a register's current value again.
+////////////////////////////////////////////////////////////////////////////////
+void HamSlice_ToCopper(const HamImage& ham, std::vector<u8>& bytes)
+{
+	bytes.assign((size_t) ham.height * ham.sliceColors * 4, 0);
+
+	const u16* before = ham.palette;
+	for (int y = 0; y < ham.height; y++)
+	{
+		const u16* after = ham.Palette(y);
+		u8* out = &bytes[(size_t) y * ham.sliceColors * 4];
+
+		int moves = 0;
+		for (int i = 1; i < kHamPaletteSize; i++)
+		{
+			if (after[i] != before[i])
+			{
+				PutBE16(&out[moves * 4 + 0], (u16) (kColorRegister + i * 2));
+				PutBE16(&out[moves * 4 + 2], after[i]);
+				moves++;
+			}
+		}
+
+		for (int i = 1; moves < ham.sliceColors; i++)
+		{
+			PutBE16(&out[moves * 4 + 0], (u16) (kColorRegister + i * 2));
+			PutBE16(&out[moves * 4 + 2], after[i]);
+			moves++;
+		}
+
+		before = after;
+	}
+}
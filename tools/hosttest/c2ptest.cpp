@@ -0,0 +1,395 @@
+////////////////////////////////////////////////////////////////////////////////
+// c2ptest.cpp
+//
+// Both chunky to planar conversions of c2p.cpp against C2p_Reference, bit for
+// bit, at 5 and 6 planes. C2p_Convert is C2p_Cpu6/C2p_Cpu5; C2p_ConvertBlit
+// is C2p_Blit32 followed by the blits of kC2pBlits. The 68000 routines are
+// modelled here merge for merge, and run in the interpreter too when there
+// is an executable, which must agree with the models. The blits run in a
+// model of the blitter, set up the way C2p_ConvertBlit sets them up.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hosttest.h"
+#include <string.h>
+#include "c2pref.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Pixel patterns, sizes in pixels, and the bytes after each plane that must
+// stay untouched.
+////////////////////////////////////////////////////////////////////////////////
+enum C2pPattern
+{
+	kC2pRandom,
+	kC2pZero,
+	kC2pFull,
+	kC2pRamp,
+	kC2pPlanes,		// Every pixel one plane, plane number from the block.
+	kC2pPatterns
+};
+
+struct C2pSize
+{
+	int width;
+	int height;
+};
+
+static const C2pSize kC2pCpuSizes[] = {{16, 1}, {32, 1}, {80, 1}, {320, 64}};
+static const C2pSize kC2pBlitSizes[] = {{32, 1}, {64, 3}, {320, 64}, {1024, 2}, {32, 1024}};
+static const int kC2pGuard = 6;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void C2pTest_Fill(HostTest& test, C2pPattern pattern, int depth, std::vector<u8>& chunky)
+{
+	const u8 mask = (u8) ((1 << depth) - 1);
+
+	for (size_t i = 0; i < chunky.size(); i++)
+	{
+		switch (pattern)
+		{
+			case kC2pZero:	 chunky[i] = 0; break;
+			case kC2pFull:	 chunky[i] = mask; break;
+			case kC2pRamp:	 chunky[i] = (u8) (i & mask); break;
+			case kC2pPlanes: chunky[i] = (u8) (1 << ((i / 16) % depth)); break;
+			default:		 chunky[i] = (u8) (HostTest_Random(test) & mask); break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The MERGE and MERGE16 macros of c2p_a.s. MERGE16 leaves its results swapped.
+////////////////////////////////////////////////////////////////////////////////
+static void C2pTest_Merge(u32& a, u32& b, int shift, u32 mask)
+{
+	u32 t = ((a >> shift) ^ b) & mask;
+
+	b ^= t;
+	a ^= t << shift;
+}
+
+static void C2pTest_Merge16(u32& a, u32& b)
+{
+	u32 t = a;
+
+	a = (b & 0xffff0000) | (t >> 16);
+	b = (b << 16) | (t & 0xffff);
+}
+
+static void C2pTest_PutPlane(std::vector<u8>& planes, int planeSize, int plane, int block, u32 word)
+{
+	PutBE16(&planes[plane * planeSize + block * 2], (u16) word);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// C2P_CPU, 16 pixels a block.
+////////////////////////////////////////////////////////////////////////////////
+static void C2pTest_Cpu(const std::vector<u8>& chunky, std::vector<u8>& planes, int planeSize, int depth)
+{
+	for (int block = 0; block < (int) chunky.size() / 16; block++)
+	{
+		const u8* p = &chunky[block * 16];
+		u32 d0 = GetBE32(p);
+		u32 d1 = GetBE32(p + 4);
+		u32 d2 = GetBE32(p + 8);
+		u32 d3 = GetBE32(p + 12);
+
+		C2pTest_Merge(d3, d2, 4, 0x0f0f0f0f);
+		C2pTest_Merge(d1, d0, 4, 0x0f0f0f0f);
+		C2pTest_Merge(d3, d1, 8, 0x00ff00ff);
+		C2pTest_Merge(d2, d0, 8, 0x00ff00ff);
+
+		if (depth == 6)
+		{
+			C2pTest_Merge(d2, d0, 1, 0x55555555);
+		}
+		else
+		{
+			d2 |= d0 << 1;
+		}
+
+		C2pTest_Merge(d3, d1, 1, 0x55555555);
+		C2pTest_Merge16(d3, d1);
+		C2pTest_Merge(d1, d3, 2, 0x33333333);
+
+		C2pTest_PutPlane(planes, planeSize, 0, block, d1);
+		C2pTest_PutPlane(planes, planeSize, 1, block, d1 >> 16);
+		C2pTest_PutPlane(planes, planeSize, 2, block, d3);
+		C2pTest_PutPlane(planes, planeSize, 3, block, d3 >> 16);
+
+		if (depth == 6)
+		{
+			C2pTest_Merge16(d2, d0);
+			d0 |= d2 << 2;
+
+			C2pTest_PutPlane(planes, planeSize, 4, block, d0);
+			C2pTest_PutPlane(planes, planeSize, 5, block, d0 >> 16);
+		}
+		else
+		{
+			C2pTest_PutPlane(planes, planeSize, 4, block, d2 | (d2 >> 16 << 2));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// C2p_Blit32, 32 pixels a block: R0..R7 to streams 0..7, the even ones from
+// the first run over the pixels and the odd ones from the second.
+////////////////////////////////////////////////////////////////////////////////
+static void C2pTest_Blit32(const std::vector<u8>& chunky, std::vector<u8>& streams, int streamSize)
+{
+	static const int kOffsets[2][4] = {{28, 20, 12, 4}, {24, 16, 8, 0}};
+
+	for (int run = 0; run < 2; run++)
+	{
+		for (int block = 0; block < (int) chunky.size() / 32; block++)
+		{
+			const u8* p = &chunky[block * 32];
+			u32 d0 = GetBE32(p + kOffsets[run][0]);
+			u32 d1 = GetBE32(p + kOffsets[run][1]);
+			u32 d2 = GetBE32(p + kOffsets[run][2]);
+			u32 d3 = GetBE32(p + kOffsets[run][3]);
+
+			C2pTest_Merge16(d0, d2);
+			C2pTest_Merge16(d1, d3);
+			C2pTest_Merge(d2, d3, 8, 0x00ff00ff);
+			C2pTest_Merge(d0, d1, 8, 0x00ff00ff);
+
+			PutBE32(&streams[(run + 0) * streamSize + block * 4], d2);
+			PutBE32(&streams[(run + 2) * streamSize + block * 4], d3);
+			PutBE32(&streams[(run + 4) * streamSize + block * 4], d0);
+			PutBE32(&streams[(run + 6) * streamSize + block * 4], d1);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The blitter, for jobs with A, C and D on and B from bltbdat: word by word,
+// A masked by the first and last word masks and shifted with the bits of the
+// previous A word, then the minterm. Pointers are offsets into memory. The
+// previous A word at the start is carry, which the hardware does not clear.
+////////////////////////////////////////////////////////////////////////////////
+static const u16 kC2pBltUseA	= 0x0800;
+static const u16 kC2pBltUseC	= 0x0200;
+static const u16 kC2pBltUseD	= 0x0100;
+static const u16 kC2pBltDesc	= 0x0002;
+
+struct C2pJob
+{
+	u16 bltcon0;
+	u16 bltcon1;
+	u16 bltafwm;
+	u16 bltalwm;
+	u16 bltbdat;
+	u32 bltapt;
+	u32 bltcpt;
+	u32 bltdpt;
+	u16 bltsize;
+};
+
+static u16 C2pTest_Minterm(u8 minterm, u16 a, u16 b, u16 c)
+{
+	u16 value = 0;
+
+	for (int term = 0; term < 8; term++)
+	{
+		if (minterm & (1 << term))
+		{
+			value |= (u16) (((term & 4) ? a : ~a) & ((term & 2) ? b : ~b) & ((term & 1) ? c : ~c));
+		}
+	}
+
+	return value;
+}
+
+static void C2pTest_Blit(std::vector<u8>& memory, const C2pJob& job, u16 carry)
+{
+	const bool descending = (job.bltcon1 & kC2pBltDesc) != 0;
+	const int shift = job.bltcon0 >> 12;
+	const int step = descending ? -2 : 2;
+	const int words = (job.bltsize & 0x3f) ? (job.bltsize & 0x3f) : 64;
+	const int lines = (job.bltsize >> 6) ? (job.bltsize >> 6) : 1024;
+
+	u32 a = job.bltapt;
+	u32 c = job.bltcpt;
+	u32 d = job.bltdpt;
+	u16 previous = carry;
+
+	for (int y = 0; y < lines; y++)
+	{
+		for (int x = 0; x < words; x++)
+		{
+			u16 wordA = GetBE16(&memory[a]);
+			wordA &= (x == 0) ? job.bltafwm : 0xffff;
+			wordA &= (x == words - 1) ? job.bltalwm : 0xffff;
+
+			u16 shifted = descending ? (u16) ((wordA << shift) | (previous >> (16 - shift))) : (u16) ((wordA >> shift) | (previous << (16 - shift)));
+			previous = wordA;
+
+			PutBE16(&memory[d], C2pTest_Minterm((u8) job.bltcon0, shifted, job.bltbdat, GetBE16(&memory[c])));
+
+			a += step;
+			c += step;
+			d += step;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The merges of C2p_ConvertBlit on streams left by C2p_Blit32. memory holds
+// the 16 streams, then the planes.
+////////////////////////////////////////////////////////////////////////////////
+static void C2pTest_Merges(HostTest& test, std::vector<u8>& memory, int planeSize, int depth, int width, int height)
+{
+	const int streamSize = width * height / 8;
+	const u32 planes = 16 * streamSize;
+
+	for (const C2pBlit& blit : kC2pBlits)
+	{
+		if (blit.depth != 0 && blit.depth != depth)
+		{
+			continue;
+		}
+
+		HostTest_Check(test, blit.d != blit.a && blit.d != blit.c, "a blit writes one of its sources");
+
+		bool descending = (blit.minterm != kC2pMergeHigh);
+		int last = descending ? streamSize - 2 : 0;
+		u32 d = (blit.d >= kC2pPlane) ? planes + (blit.d - kC2pPlane) * planeSize : blit.d * streamSize;
+
+		C2pJob job = {};
+		job.bltcon0 = (u16) ((blit.shift << 12) | kC2pBltUseA | kC2pBltUseC | kC2pBltUseD | blit.minterm);
+		job.bltcon1 = descending ? kC2pBltDesc : 0;
+		job.bltafwm = 0xffff;
+		job.bltalwm = 0xffff;
+		job.bltbdat = blit.mask;
+		job.bltapt = blit.a * streamSize + last;
+		job.bltcpt = blit.c * streamSize + last;
+		job.bltdpt = d + last;
+		job.bltsize = (u16) ((height << 6) | ((width / 16) & 0x3f));
+
+		C2pTest_Blit(memory, job, (u16) HostTest_Random(test));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// depth planes of pixels / 8 bytes, planeSize apart, against the reference,
+// and the guard bytes after each still at fill.
+////////////////////////////////////////////////////////////////////////////////
+static void C2pTest_Compare(HostTest& test, const char* what, const u8* planes, int planeSize, int depth, const std::vector<u8>& chunky, int width, int height, u8 fill)
+{
+	const int size = (int) chunky.size() / 8;
+	std::vector<u8> expected(size * depth);
+	C2p_Reference(chunky.data(), expected.data(), size, depth, (int) chunky.size());
+
+	for (int p = 0; p < depth; p++)
+	{
+		bool same = !memcmp(planes + p * planeSize, &expected[p * size], size);
+		bool guarded = true;
+
+		for (int i = size; i < planeSize; i++)
+		{
+			guarded = guarded && (planes[p * planeSize + i] == fill);
+		}
+
+		HostTest_Check(test, same && guarded, "%s, %d planes, %dx%d: plane %d %s", what, depth, width, height, p, !same ? "differs" : "written past its end");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void C2pTest_CpuRun(HostTest& test, int depth, u32 entry)
+{
+	for (const C2pSize& size : kC2pCpuSizes)
+	{
+		for (int pattern = 0; pattern < kC2pPatterns; pattern++)
+		{
+			const int pixels = size.width * size.height;
+			const int planeSize = pixels / 8 + kC2pGuard;
+
+			std::vector<u8> chunky(pixels);
+			C2pTest_Fill(test, (C2pPattern) pattern, depth, chunky);
+
+			std::vector<u8> planes(planeSize * depth, 0xa5);
+			C2pTest_Cpu(chunky, planes, planeSize, depth);
+			C2pTest_Compare(test, "cpu model", planes.data(), planeSize, depth, chunky, size.width, size.height, 0xa5);
+
+			if (entry == 0)
+			{
+				continue;
+			}
+
+			HostTest_Free(test);
+			u32 source = HostTest_Alloc(test, true, pixels);
+			u32 target = HostTest_Alloc(test, false, planeSize * depth);
+			u8* hostTarget = HostTest_Memory(test, target, planeSize * depth);
+
+			memcpy(HostTest_Memory(test, source, pixels), chunky.data(), pixels);
+			memset(hostTarget, 0x5a, planeSize * depth);
+
+			u32 value = 0;
+			if (HostTest_Call(test, entry, {source, target, (u32) planeSize, (u32) pixels / 16}, value))
+			{
+				C2pTest_Compare(test, depth == 6 ? "C2p_Cpu6" : "C2p_Cpu5", hostTarget, planeSize, depth, chunky, size.width, size.height, 0x5a);
+			}
+		}
+	}
+}
+
+static void C2pTest_BlitRun(HostTest& test, int depth, u32 entry)
+{
+	for (const C2pSize& size : kC2pBlitSizes)
+	{
+		for (int pattern = 0; pattern < kC2pPatterns; pattern++)
+		{
+			const int pixels = size.width * size.height;
+			const int streamSize = pixels / 8;
+			const int planeSize = streamSize + kC2pGuard;
+
+			std::vector<u8> chunky(pixels);
+			C2pTest_Fill(test, (C2pPattern) pattern, depth, chunky);
+
+			// The scratch streams start out as garbage, as they would.
+			std::vector<u8> memory(16 * streamSize + depth * planeSize, 0xa5);
+			for (int i = 0; i < 16 * streamSize; i++)
+			{
+				memory[i] = (u8) HostTest_Random(test);
+			}
+
+			C2pTest_Blit32(chunky, memory, streamSize);
+
+			if (entry != 0)
+			{
+				HostTest_Free(test);
+				u32 source = HostTest_Alloc(test, true, pixels);
+				u32 streams = HostTest_Alloc(test, false, 8 * streamSize);
+
+				memcpy(HostTest_Memory(test, source, pixels), chunky.data(), pixels);
+
+				u32 value = 0;
+				if (HostTest_Call(test, entry, {source, streams, (u32) streamSize, (u32) pixels / 32}, value))
+				{
+					bool same = !memcmp(HostTest_Memory(test, streams, 8 * streamSize), memory.data(), 8 * streamSize);
+					HostTest_Check(test, same, "C2p_Blit32, %dx%d: streams differ from the model", size.width, size.height);
+				}
+			}
+
+			C2pTest_Merges(test, memory, planeSize, depth, size.width, size.height);
+			C2pTest_Compare(test, "blitter", &memory[16 * streamSize], planeSize, depth, chunky, size.width, size.height, 0xa5);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void C2pTest_Run(HostTest& test)
+{
+	u32 cpu6 = HostTest_Function(test, "C2p_Cpu6");
+	u32 cpu5 = HostTest_Function(test, "C2p_Cpu5");
+	u32 blit32 = HostTest_Function(test, "C2p_Blit32");
+
+	for (int depth = 5; depth <= 6; depth++)
+	{
+		C2pTest_CpuRun(test, depth, (depth == 6) ? cpu6 : cpu5);
+		C2pTest_BlitRun(test, depth, blit32);
+	}
+}
@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////////
+// fixedtest.cpp
+//
+// fixedmath.h against double: every entry of the sine, reciprocal and square
+// root tables within half a unit of its exact value, the Fix8 and Fix16
+// operators bit for bit against 64 bit arithmetic (products round down,
+// quotients toward zero) and so within a unit of the exact value, and
+// Fix_Sqrt within the 0.2% plus a unit it promises.
+//
+// With the executable, also the 32 bit multiply and divide of
+// gcc8_a_support.s against the host's, at the edges of their fast paths:
+// high words zero, 16 bit divisors and quotients that just do or do not fit
+// in 16 bits, divisors from 2^24 on, and every sign combination.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hosttest.h"
+#include <assert.h>
+#include <math.h>
+#include "fixedmath.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kFixedTestRandom	= 200000;
+static const double kFixedTestHalf	= 0.5 + 1e-9;	// Rounded to nearest.
+static const double kFixedTestSqrt	= 0.002;		// Fix_Sqrt, relative.
+
+static const s32 kFixedTestEdges[] = {
+	0, 1, 2, 0xff, 0x100, 0x7fff, 0x8000, 0xffff, 0x10000, 0x10001, 0x12345, 0xffffff, 0x1000000, 0x1000001, 0x7fffffff,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Random 32 bit values of any magnitude, so that small ones come up as often
+// as large ones.
+////////////////////////////////////////////////////////////////////////////////
+static u32 FixedTest_Random(HostTest& test)
+{
+	return HostTest_Random(test) >> (HostTest_Random(test) & 31);
+}
+
+static s32 FixedTest_RandomSigned(HostTest& test)
+{
+	s32 value = (s32) FixedTest_Random(test);
+	return (HostTest_Random(test) & 1) ? -value : value;
+}
+
+static std::vector<s32> FixedTest_Edges()
+{
+	std::vector<s32> values;
+
+	for (s32 edge : kFixedTestEdges)
+	{
+		values.push_back(edge);
+		values.push_back((s32) (0u - (u32) edge));
+	}
+	values.push_back((s32) 0x80000000);
+
+	return values;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void FixedTest_Tables(HostTest& test)
+{
+	for (int i = 0; i < kFixAngles; i++)
+	{
+		double exact = sin(2 * M_PI * i / kFixAngles) * (1 << kFixSinShift);
+
+		HostTest_Check(test, fabs(Fix_Sin(i) - exact) <= kFixedTestHalf, "sine %d is %d, not %.3f", i, Fix_Sin(i), exact);
+		HostTest_Check(test, Fix_Sin(i) == Fix_Sin(kFixAngles / 2 - i) && Fix_Sin(i) == -Fix_Sin(i + kFixAngles / 2), "sine %d not symmetric", i);
+		HostTest_Check(test, Fix_Cos(i) == Fix_Sin(i + kFixAngles / 4) && Fix_Sin(i) == Fix_Sin(i - kFixAngles) && Fix_Sin16(i).raw == Fix_Sin(i) * 4
+			&& Fix_Cos16(i).raw == Fix_Cos(i) * 4, "cosine or 16.16 sine %d wrong", i);
+	}
+
+	for (int i = 1; i < kFixRecips; i++)
+	{
+		double exact = 65536.0 / i;
+
+		HostTest_Check(test, fabs(Fix_Recip(i).raw - exact) <= kFixedTestHalf, "1/%d is %d, not %.3f", i, Fix_Recip(i).raw, exact);
+	}
+
+	for (int i = 0; i < 3 * kFixSqrtMin; i++)
+	{
+		double exact = sqrt(kFixSqrtMin + i) * 256;
+		int entry = FixTables<0>::kSqrt.value[i];
+
+		HostTest_Check(test, fabs(entry - exact) <= kFixedTestHalf, "sqrt table %d is %d, not %.3f", kFixSqrtMin + i, entry, exact);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// x in 16.16, every raw value up to 2^20 and then random ones.
+////////////////////////////////////////////////////////////////////////////////
+static void FixedTest_CheckSqrt(HostTest& test, s32 raw)
+{
+	double exact = sqrt(raw / 65536.0) * 65536;
+	s32 root = Fix_Sqrt(Fix16::FromRaw(raw)).raw;
+
+	HostTest_Check(test, fabs(root - exact) <= exact * kFixedTestSqrt + 1, "sqrt of raw %d is raw %d, not %.3f", raw, root, exact);
+}
+
+static void FixedTest_Sqrt(HostTest& test)
+{
+	for (s32 raw = 0; raw <= (1 << 20); raw++)
+	{
+		FixedTest_CheckSqrt(test, raw);
+	}
+
+	for (int i = 0; i < kFixedTestRandom; i++)
+	{
+		FixedTest_CheckSqrt(test, (s32) (FixedTest_Random(test) >> 1));
+	}
+
+	FixedTest_CheckSqrt(test, 0x7fffffff);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Fix8 pairs: every combination of the edges and random ones. A quotient
+// must fit in 16 bits, as the operator says.
+////////////////////////////////////////////////////////////////////////////////
+static void FixedTest_CheckFix8(HostTest& test, s16 a, s16 b)
+{
+	const double exact = (a / 256.0) * (b / 256.0);
+	const s16 product = (Fix8::FromRaw(a) * Fix8::FromRaw(b)).raw;
+	const s16 expected = (s16) (((s64) a * b) >> 8);
+
+	HostTest_Check(test, product == expected && (fabs(exact) >= 128 || fabs(product / 256.0 - exact) < 1 / 256.0),
+		"Fix8 raw %d * %d is %d, not %d", a, b, product, expected);
+
+	if (b == 0 || (s64) a * 256 / b != (s16) ((s64) a * 256 / b))
+	{
+		return;
+	}
+
+	const s16 quotient = (Fix8::FromRaw(a) / Fix8::FromRaw(b)).raw;
+	const s16 truncated = (s16) ((s64) a * 256 / b);
+
+	HostTest_Check(test, quotient == truncated && fabs(quotient / 256.0 - (double) a / b) < 1 / 256.0,
+		"Fix8 raw %d / %d is %d, not %d", a, b, quotient, truncated);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Fix16 products modulo 2^32 like the raw values, so bit for bit against the
+// 64 bit product; a quotient by s16 toward zero.
+////////////////////////////////////////////////////////////////////////////////
+static void FixedTest_CheckFix16(HostTest& test, s32 a, s32 b)
+{
+	const s32 product = (Fix16::FromRaw(a) * Fix16::FromRaw(b)).raw;
+	const s32 expected = (s32) (u32) ((u64) ((s64) a * b) >> 16);
+	const double exact = (a / 65536.0) * (b / 65536.0);
+
+	// The shift of a negative 64 bit product must round down too.
+	const s32 floored = (s32) (u32) (u64) (s64) floor((double) a * b / 65536);
+
+	HostTest_Check(test, product == expected && (fabs(exact) >= 32768 || (product == floored && fabs(product / 65536.0 - exact) < 1 / 65536.0)),
+		"Fix16 raw %d * %d is %d, not %d", a, b, product, expected);
+
+	const s16 s = (s16) b;
+	const s32 scaled = (Fix16::FromRaw(a) * s).raw;
+
+	HostTest_Check(test, scaled == (s32) (u32) ((s64) a * s), "Fix16 raw %d * s16 %d is %d", a, s, scaled);
+
+	if (s != 0 && !(a == (s32) 0x80000000 && s == -1))
+	{
+		const s32 quotient = (Fix16::FromRaw(a) / s).raw;
+
+		HostTest_Check(test, quotient == (s32) ((s64) a / s) && fabs(quotient - (double) a / s) < 1, "Fix16 raw %d / s16 %d is %d", a, s, quotient);
+	}
+}
+
+static void FixedTest_Operators(HostTest& test)
+{
+	const std::vector<s32> edges = FixedTest_Edges();
+
+	for (s32 a : edges)
+	{
+		for (s32 b : edges)
+		{
+			FixedTest_CheckFix8(test, (s16) a, (s16) b);
+			FixedTest_CheckFix8(test, (s16) (a >> 8), (s16) b);
+			FixedTest_CheckFix16(test, a, b);
+		}
+	}
+
+	for (int i = 0; i < kFixedTestRandom; i++)
+	{
+		u32 a = HostTest_Random(test);
+		u32 b = HostTest_Random(test);
+
+		FixedTest_CheckFix8(test, (s16) a, (s16) b);
+		FixedTest_CheckFix8(test, (s16) a, (s16) ((s16) b >> (a >> 28)));
+		FixedTest_CheckFix16(test, (s32) a, (s32) b);
+		FixedTest_CheckFix16(test, FixedTest_RandomSigned(test), FixedTest_RandomSigned(test));
+	}
+
+	for (int i = -300; i <= 300; i++)
+	{
+		Fix16 x = Fix16::FromRaw(i * 0x1234);
+
+		HostTest_Check(test, x.Floor() == (int) floor(x.raw / 65536.0) && x.Round() == (int) floor(x.raw / 65536.0 + 0.5) && Fix16::FromInt(i).raw == i * 65536
+			&& Fix8::FromInt(i / 3).raw == (i / 3) * 256, "Floor, Round or FromInt of raw %d wrong", x.raw);
+	}
+
+	HostTest_Check(test, Fix16::FromFloat(0.5).raw == 0x8000 && Fix16::FromFloat(-1.25).raw == -0x14000 && Fix8::FromFloat(3.999).raw == 0x400,
+		"FromFloat wrong");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The gcc support routines, called as gcc calls them: (a, b) on the stack,
+// the result in d0. A quotient of the most negative long by -1 overflows and
+// is left out.
+////////////////////////////////////////////////////////////////////////////////
+struct FixedTestRoutine
+{
+	const char* name;
+	u32 entry;
+};
+
+static void FixedTest_CheckSupport(HostTest& test, const FixedTestRoutine* routines, u32 a, u32 b)
+{
+	const s32 sa = (s32) a;
+	const s32 sb = (s32) b;
+	const bool overflow = (sa == (s32) 0x80000000 && sb == -1);
+
+	const u32 expected[] = {
+		(u32) ((u64) a * b),
+		(b != 0) ? a / b : 0,
+		(b != 0) ? a % b : 0,
+		(b != 0 && !overflow) ? (u32) (sa / sb) : 0,
+		(b != 0 && !overflow) ? (u32) (sa % sb) : 0,
+	};
+
+	for (int i = 0; i < (int) countof(expected); i++)
+	{
+		if (i != 0 && (b == 0 || (i >= 3 && overflow)))
+		{
+			continue;
+		}
+
+		u32 result = 0;
+
+		if (HostTest_Call(test, routines[i].entry, {a, b}, result))
+		{
+			HostTest_Check(test, result == expected[i], "%s(0x%08x, 0x%08x) is 0x%08x, not 0x%08x", routines[i].name, a, b, result, expected[i]);
+		}
+	}
+}
+
+static void FixedTest_Support(HostTest& test)
+{
+	FixedTestRoutine routines[] = {
+		{"__mulsi3", 0}, {"__udivsi3", 0}, {"__umodsi3", 0}, {"__divsi3", 0}, {"__modsi3", 0},
+	};
+
+	for (FixedTestRoutine& routine : routines)
+	{
+		routine.entry = HostTest_Function(test, routine.name);
+
+		if (routine.entry == 0)
+		{
+			return;
+		}
+	}
+
+	// Each edge divisor against dividends just around it, around it times
+	// 0xffff and 0x10000 (the largest quotient one divu takes and the
+	// smallest it does not), and the edges themselves, with both signs.
+	const std::vector<s32> edges = FixedTest_Edges();
+
+	for (s32 b : edges)
+	{
+		std::vector<u32> dividends(edges.begin(), edges.end());
+
+		for (u32 quotient : {1u, 0xffffu, 0x10000u, 0x10001u})
+		{
+			u32 base = (u32) b * quotient;
+
+			for (u32 delta : {0u, 1u, 0xffffffffu})
+			{
+				dividends.push_back(base + delta);
+				dividends.push_back(0u - (base + delta));
+			}
+		}
+
+		for (u32 a : dividends)
+		{
+			FixedTest_CheckSupport(test, routines, a, (u32) b);
+		}
+	}
+
+	for (int i = 0; i < kFixedTestRandom / 10; i++)
+	{
+		FixedTest_CheckSupport(test, routines, (u32) FixedTest_RandomSigned(test), (u32) FixedTest_RandomSigned(test));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void FixedTest_Run(HostTest& test)
+{
+	FixedTest_Tables(test);
+	FixedTest_Sqrt(test);
+	FixedTest_Operators(test);
+	FixedTest_Support(test);
+}
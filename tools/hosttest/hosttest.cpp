@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////
+// hosttest.cpp
+//
+// Runs every suite of hosttest.h:
+//
+//   make -C tools
+//   tools/bin/hosttest a.mingw.elf
+//
+// and exits with 1 if any check failed. Without the executable only the
+// portable code is tested.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hosttest.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u64 kHostTestMaxCycles	= 1000000000;
+static const u32 kHostTestAlign		= 8;
+static const int kHostTestReports	= 8;	// Failures printed per suite.
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void PrintUsage()
+{
+	printf("usage: hosttest [executable.elf]\n");
+	printf("  checks the portable code, and with the executable its 68000 routines\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void HostTest_Begin(HostTest& test, const char* suite)
+{
+	test.suite = suite;
+	test.seed = 1;
+	test.reports = 0;
+
+	HostTest_Free(test);
+}
+
+bool HostTest_Check(HostTest& test, bool ok, const char* format, ...)
+{
+	test.checks++;
+
+	if (ok)
+	{
+		return true;
+	}
+
+	test.failures++;
+
+	if (test.reports++ < kHostTestReports)
+	{
+		va_list args;
+		va_start(args, format);
+		fprintf(stderr, "%s: ", test.suite.c_str());
+		vfprintf(stderr, format, args);
+		fprintf(stderr, "\n");
+		va_end(args);
+	}
+
+	return false;
+}
+
+u32 HostTest_Random(HostTest& test)
+{
+	test.seed = test.seed * 1664525 + 1013904223;
+
+	return test.seed ^ (test.seed >> 16);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+u32 HostTest_Function(HostTest& test, const char* name)
+{
+	if (!test.haveImage)
+	{
+		printf("%s: %s skipped, no executable\n", test.suite.c_str(), name);
+		test.skipped++;
+		return 0;
+	}
+
+	const M68kSymbol* symbol = M68kElf_Find(test.image, name);
+	HostTest_Check(test, symbol != nullptr, "no %s in the executable", name);
+
+	return (symbol != nullptr) ? symbol->address : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+u32 HostTest_Alloc(HostTest& test, bool fast, u32 size)
+{
+	u32& next = fast ? test.fast : test.chip;
+	u32 address = (next + kHostTestAlign - 1) & ~(kHostTestAlign - 1);
+
+	next = address + size;
+
+	return address;
+}
+
+void HostTest_Free(HostTest& test)
+{
+	test.chip = test.image.chipEnd;
+	test.fast = test.image.fastEnd;
+}
+
+u8* HostTest_Memory(HostTest& test, u32 address, u32 size)
+{
+	return M68k_Memory(test.cpu, address, size);
+}
+
+bool HostTest_Call(HostTest& test, u32 entry, const std::vector<u32>& args, u32& result)
+{
+	test.cpu.error.clear();
+
+	bool ok = M68k_Call(test.cpu, entry, args, kHostTestMaxCycles, result);
+
+	return HostTest_Check(test, ok, "crashed: %s", test.cpu.error.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+	HostTest test;
+
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-'))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	M68k_Reset(test.cpu);
+
+	if (argc == 2)
+	{
+		std::string error;
+
+		if (!M68kElf_Load(argv[1], false, test.cpu, test.image, error))
+		{
+			fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+			return 1;
+		}
+
+		test.haveImage = true;
+	}
+
+	struct Suite
+	{
+		const char* name;
+		void (*run)(HostTest& test);
+	};
+
+	static const Suite kSuites[] =
+	{
+		{"c2p", C2pTest_Run},
+		{"mem", MemTest_Run},
+		{"fixed", FixedTest_Run},
+	};
+
+	for (const Suite& suite : kSuites)
+	{
+		int checks = test.checks;
+		int failures = test.failures;
+
+		HostTest_Begin(test, suite.name);
+		suite.run(test);
+
+		printf("%-8s %8d checks, %d failed\n", suite.name, test.checks - checks, test.failures - failures);
+	}
+
+	if (test.skipped != 0)
+	{
+		printf("%d group(s) of checks skipped for want of an executable\n", test.skipped);
+	}
+
+	return (test.failures == 0) ? 0 : 1;
+}
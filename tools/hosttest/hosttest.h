@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+// hosttest.h
+//
+// Correctness tests of the target code that run on the host. The portable
+// headers shared with the target (the *ref.h ones and the like) are tested
+// directly, the 68000 routines of the linked executable in the interpreter
+// of tools/m68kbench. Each suite checks against a host-side reference and
+// counts what it checked; hosttest fails if any check did.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "m68kelf.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// The executable is optional. Without it the checks that run 68000 code are
+// skipped, and reported as such; with it, a routine that is missing fails.
+////////////////////////////////////////////////////////////////////////////////
+struct HostTest
+{
+	M68k cpu;
+	M68kImage image;
+	bool haveImage = false;
+
+	std::string suite;
+	u32 seed = 1;
+	u32 chip = 0;
+	u32 fast = 0;
+	int checks = 0;
+	int failures = 0;
+	int skipped = 0;
+	int reports = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// HostTest_Begin starts a suite: the random numbers start over and the
+// interpreter's RAM is all free again. HostTest_Check counts a check
+// and prints the first few that fail in a suite.
+////////////////////////////////////////////////////////////////////////////////
+void HostTest_Begin(HostTest& test, const char* suite);
+bool HostTest_Check(HostTest& test, bool ok, const char* format, ...) __attribute__((format(printf, 3, 4)));
+u32 HostTest_Random(HostTest& test);
+
+////////////////////////////////////////////////////////////////////////////////
+// The address of a function of the executable, or 0 if there is no
+// executable (the caller skips what needs it) or no such function (a failed
+// check).
+////////////////////////////////////////////////////////////////////////////////
+u32 HostTest_Function(HostTest& test, const char* name);
+
+////////////////////////////////////////////////////////////////////////////////
+// RAM in the interpreter, from the end of the executable on, and its host
+// address. HostTest_Free gives all of it back. HostTest_Call fails the check
+// if the routine crashes.
+////////////////////////////////////////////////////////////////////////////////
+u32 HostTest_Alloc(HostTest& test, bool fast, u32 size);
+void HostTest_Free(HostTest& test);
+u8* HostTest_Memory(HostTest& test, u32 address, u32 size);
+bool HostTest_Call(HostTest& test, u32 entry, const std::vector<u32>& args, u32& result);
+
+////////////////////////////////////////////////////////////////////////////////
+// The suites.
+////////////////////////////////////////////////////////////////////////////////
+void C2pTest_Run(HostTest& test);
+void MemTest_Run(HostTest& test);
+void FixedTest_Run(HostTest& test);
@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////////////////
+// memtest.cpp
+//
+// memset, memcpy and memmove of gcc8_a_support.s against the host's, byte
+// for byte: every size up to kMemTestSizes at every alignment of source and
+// destination mod 4, memmove overlapping both ways, and a few sizes large
+// enough for the 32 bit loop counts. Before and after the area, kMemTestGuard
+// bytes must stay as they were. Needs the executable.
+//
+// The split of Mem_ClearChip and Mem_CopyChip (memsplit.h) does not: it is
+// run here the way mem.cpp runs it, with blits that clear or copy whole
+// lines, and has to come out as memset and memcpy do.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "hosttest.h"
+#include <string.h>
+#include <algorithm>
+#include "memsplit.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u32 kMemTestSizes	= 1100;
+static const u32 kMemTestGuard	= 16;
+
+// Past 16 * 0xffff bytes a dbra alone no longer counts the longs of memmove
+// or the 8 byte runs of the unaligned copies.
+static const u32 kMemTestLarge[] = {0x80000 + 13, 0x100000 + 21};
+
+static const int kMemTestOverlaps[] = {-33, -17, -9, -4, -3, -2, -1, 1, 2, 3, 4, 9, 17, 33};
+static const int kMemTestValues[] = {0x00, 0xa5, 0xff, 0x12345a};
+
+static const u32 kMemSplitSizes	= 3000;
+static const u32 kMemSplitLarge[] = {
+	kMemBlitWords * 2 * kMemBlitLines - 2, kMemBlitWords * 2 * kMemBlitLines - 1, kMemBlitWords * 2 * kMemBlitLines,
+	kMemBlitWords * 2 * kMemBlitLines + 1, kMemBlitWords * 2 * kMemBlitLines + 2, kMemBlitWords * 2 * kMemBlitLines + 129,
+	2 * kMemBlitWords * 2 * kMemBlitLines + 127, 3 * kMemBlitWords * 2 * kMemBlitLines + kMemBlitWords * 2 - 1, 400000,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// One call in the interpreter: the area around dst (and src) gets random
+// bytes, the host does the same call on a copy of it, and the two must match
+// afterwards. Offsets are from the start of a buffer of size bytes.
+////////////////////////////////////////////////////////////////////////////////
+enum MemTestKind
+{
+	kMemTestSet,
+	kMemTestCopy,
+	kMemTestMove,
+};
+
+struct MemTestBuffer
+{
+	u32 address;
+	u32 size;
+};
+
+static void MemTest_Call(HostTest& test, MemTestKind kind, u32 entry, const MemTestBuffer& buffer, u32 dst, u32 src, u32 size, int value)
+{
+	static const char* const kNames[] = {"memset", "memcpy", "memmove"};
+
+	u8* host = HostTest_Memory(test, buffer.address, buffer.size);
+	for (u32 i = 0; i < buffer.size; i++)
+	{
+		host[i] = (u8) HostTest_Random(test);
+	}
+
+	std::vector<u8> expected(host, host + buffer.size);
+	switch (kind)
+	{
+		case kMemTestSet:  memset(&expected[dst], value, size); break;
+		case kMemTestCopy: memcpy(&expected[dst], &expected[src], size); break;
+		case kMemTestMove: memmove(&expected[dst], &expected[src], size); break;
+	}
+
+	std::vector<u32> args = {buffer.address + dst, (kind == kMemTestSet) ? (u32) value : buffer.address + src, size};
+	u32 result = 0;
+
+	if (!HostTest_Call(test, entry, args, result))
+	{
+		return;
+	}
+
+	bool same = !memcmp(host, expected.data(), buffer.size);
+	u32 first = (u32) (std::mismatch(host, host + buffer.size, expected.begin()).first - host);
+
+	HostTest_Check(test, same && result == buffer.address + dst, "%s of %u bytes, dst+%u src+%u: %s", kNames[kind], size, dst % 4, src % 4,
+		!same ? ("byte " + std::to_string((int) first - (int) dst) + " from dst differs").c_str() : "wrong return value");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void MemTest_Routines(HostTest& test)
+{
+	u32 set = HostTest_Function(test, "memset");
+	u32 copy = HostTest_Function(test, "memcpy");
+	u32 move = HostTest_Function(test, "memmove");
+
+	if (set == 0 || copy == 0 || move == 0)
+	{
+		return;
+	}
+
+	// Destination first, then the source, each with guards and room to
+	// shift by up to 3 and by the overlaps.
+	const u32 span = kMemTestSizes + 2 * kMemTestGuard + 2 * 33 + 4;
+	MemTestBuffer buffer = {HostTest_Alloc(test, true, 2 * span), 2 * span};
+
+	for (u32 size = 0; size <= kMemTestSizes; size++)
+	{
+		for (u32 dstAlign = 0; dstAlign < 4; dstAlign++)
+		{
+			u32 dst = kMemTestGuard + 33 + dstAlign;
+
+			MemTest_Call(test, kMemTestSet, set, buffer, dst, 0, size, kMemTestValues[(size + dstAlign) % countof(kMemTestValues)]);
+
+			for (u32 srcAlign = 0; srcAlign < 4; srcAlign++)
+			{
+				u32 src = span + kMemTestGuard + 33 + srcAlign;
+
+				MemTest_Call(test, kMemTestCopy, copy, buffer, dst, src, size, 0);
+				MemTest_Call(test, kMemTestMove, move, buffer, dst, src, size, 0);
+				MemTest_Call(test, kMemTestMove, move, buffer, src, dst, size, 0);
+			}
+		}
+
+		for (u32 srcAlign = 0; srcAlign < 4; srcAlign++)
+		{
+			for (int overlap : kMemTestOverlaps)
+			{
+				u32 src = kMemTestGuard + 33 + srcAlign;
+
+				MemTest_Call(test, kMemTestMove, move, buffer, src + overlap, src, size, 0);
+			}
+		}
+	}
+
+	for (u32 size : kMemTestLarge)
+	{
+		HostTest_Free(test);
+		MemTestBuffer large = {HostTest_Alloc(test, true, 2 * size + 4 * kMemTestGuard), 2 * size + 4 * kMemTestGuard};
+		u32 dst = kMemTestGuard;
+		u32 src = size + 3 * kMemTestGuard + 1;
+
+		MemTest_Call(test, kMemTestSet, set, large, dst + 1, 0, size, 0x5a);
+		MemTest_Call(test, kMemTestCopy, copy, large, dst, src, size, 0);
+		MemTest_Call(test, kMemTestMove, move, large, dst + 20, dst, size, 0);
+		MemTest_Call(test, kMemTestMove, move, large, dst, dst + 21, size, 0);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Mem_ClearChip and Mem_CopyChip on a host buffer, with addresses as on the
+// target so that their parity is what counts. A blit must have 1-64 words
+// and 1-1024 lines, as bltsize holds them, and start on even addresses; every
+// byte of the area must be done exactly once.
+////////////////////////////////////////////////////////////////////////////////
+static void MemTest_Blit(HostTest& test, std::vector<u8>& memory, std::vector<u8>& count, u32 dst, u32 src, bool copy, u32 words)
+{
+	while (words != 0)
+	{
+		const MemBlit blit = Mem_NextBlit(words);
+		const u32 bytes = blit.words * blit.lines * 2;
+
+		HostTest_Check(test, blit.words >= 1 && blit.words <= 64 && blit.lines >= 1 && blit.lines <= 1024 && (dst & 1) == 0 && (src & 1) == 0,
+			"blit of %d words by %d lines from %u to %u", blit.words, blit.lines, src, dst);
+
+		for (u32 i = 0; i < bytes; i++)
+		{
+			memory[dst + i] = copy ? memory[src + i] : 0;
+			count[dst + i]++;
+		}
+
+		dst += bytes;
+		src += bytes;
+		words -= blit.words * blit.lines;
+	}
+}
+
+static void MemTest_Chip(HostTest& test, std::vector<u8>& memory, u32 dst, u32 src, u32 size, bool copy)
+{
+	std::vector<u8> count(memory.size(), 0);
+	std::vector<u8> expected = memory;
+
+	if (copy)
+	{
+		memcpy(&expected[dst], &expected[src], size);
+	}
+	else
+	{
+		memset(&expected[dst], 0, size);
+	}
+
+	// A clear has no source; its blits only check the destination.
+	if (!copy)
+	{
+		src = dst;
+	}
+
+	const MemSplit split = Mem_Split(dst, src, size);
+	const bool blits = (split.words != 0);
+
+	HostTest_Check(test, split.head + 2 * split.words + split.tail == size && (!blits || (split.head <= 1 && split.tail <= 1)),
+		"split of %u bytes is %u + 2 * %u + %u", size, split.head, split.words, split.tail);
+	HostTest_Check(test, blits == (size >= kMemBlitMin && ((dst ^ src) & 1) == 0),
+		"%u bytes from %u to %u %s the blitter", size, src, dst, blits ? "use" : "do not use");
+
+	for (u32 i = 0; i < split.head; i++)
+	{
+		memory[dst + i] = copy ? memory[src + i] : 0;
+		count[dst + i]++;
+	}
+
+	for (u32 i = size - split.tail; i < size; i++)
+	{
+		memory[dst + i] = copy ? memory[src + i] : 0;
+		count[dst + i]++;
+	}
+
+	MemTest_Blit(test, memory, count, dst + split.head, src + split.head, copy, split.words);
+
+	bool once = std::all_of(count.begin() + dst, count.begin() + dst + size, [](u8 n) { return n == 1; });
+	HostTest_Check(test, once && memory == expected, "%s of %u bytes, dst+%u src+%u: %s", copy ? "Mem_CopyChip" : "Mem_ClearChip", size, dst % 4, src % 4,
+		!once ? "bytes not done exactly once" : "wrong bytes");
+}
+
+static void MemTest_Split(HostTest& test)
+{
+	std::vector<u32> sizes;
+	for (u32 size = 0; size <= kMemSplitSizes; size++)
+	{
+		sizes.push_back(size);
+	}
+	sizes.insert(sizes.end(), kMemSplitLarge, kMemSplitLarge + countof(kMemSplitLarge));
+
+	for (u32 size : sizes)
+	{
+		// Large sizes at fewer alignments, or the test takes a while.
+		const u32 step = (size > kMemSplitSizes) ? 3 : 1;
+		std::vector<u8> memory(2 * size + 16);
+
+		for (u8& byte : memory)
+		{
+			byte = (u8) HostTest_Random(test);
+		}
+
+		for (u32 dstAlign = 0; dstAlign < 4; dstAlign += step)
+		{
+			MemTest_Chip(test, memory, 4 + dstAlign, 0, size, false);
+
+			for (u32 srcAlign = 0; srcAlign < 4; srcAlign += step)
+			{
+				MemTest_Chip(test, memory, 4 + dstAlign, size + 8 + srcAlign, size, true);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void MemTest_Run(HostTest& test)
+{
+	MemTest_Split(test);
+	MemTest_Routines(test);
+}
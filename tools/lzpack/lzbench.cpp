@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzbench.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lzbench.h"
+#include <stdio.h>
+#include <algorithm>
+#include "image.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// PAL 68000 cycles per 50 Hz frame.
+////////////////////////////////////////////////////////////////////////////////
+static const double kFrameCycles = 7093790.0 / 50.0;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct LzResult
+{
+	u64 packed = 0;
+	LzModel model;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Packs, checks the round trip through Lz_Reference and models the depack.
+////////////////////////////////////////////////////////////////////////////////
+static bool Measure(const std::string& name, const std::vector<u8>& data, const LzEncOptions& options, LzResult& result)
+{
+	std::vector<u8> packed;
+	LzEnc_Pack(data, options, packed);
+
+	std::vector<u8> unpacked(data.size());
+	if (Lz_Reference(packed.data(), unpacked.data()) != packed.size() || unpacked != data)
+	{
+		fprintf(stderr, "%s: round trip failed\n", name.c_str());
+		return false;
+	}
+
+	if (!LzEnc_Model(packed, 0, 0, result.model))
+	{
+		fprintf(stderr, "%s: model failed\n", name.c_str());
+		return false;
+	}
+
+	result.packed = packed.size();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Print(const char* name, u64 size, const LzResult (&results)[2])
+{
+	printf("%-24s %8llu", name, (unsigned long long) size);
+
+	for (const LzResult& result : results)
+	{
+		printf(" | %8llu %5.1f%% %6.2f %6.2f", (unsigned long long) result.packed, size ? 100.0 * result.packed / size : 0.0,
+			size ? (double) result.model.cycles / size : 0.0, result.model.cycles / kFrameCycles);
+	}
+
+	printf(" | %6u\n", results[1].model.maxSequenceCycles);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Every input packed for size (any match from kLzMinMatch, nearest offset)
+// and with options, which default to the depack speed tuning. Sizes, ratio,
+// modelled cycles per unpacked byte and frames without DMA contention, and
+// the most cycles a single sequence takes, which is what Lz_Depack can run
+// over its budget by.
+////////////////////////////////////////////////////////////////////////////////
+bool LzBench_Run(const std::vector<std::string>& inputs, const LzEncOptions& options)
+{
+	LzEncOptions small = options;
+	small.minMatch = kLzMinMatch;
+	small.fastOffsets = false;
+
+	printf("%-24s %8s | %-29s | %-29s | %6s\n", "", "", "size tuned", "speed tuned", "");
+	printf("%-24s %8s | %8s %6s %6s %6s | %8s %6s %6s %6s | %6s\n", "file", "bytes",
+		"packed", "ratio", "cyc/b", "frames", "packed", "ratio", "cyc/b", "frames", "max");
+
+	u64 totalSize = 0;
+	LzResult totals[2];
+
+	for (const std::string& input : inputs)
+	{
+		std::vector<u8> data;
+		if (!File_Load(input, data))
+		{
+			return false;
+		}
+
+		LzResult results[2];
+		if (!Measure(input, data, small, results[0]) || !Measure(input, data, options, results[1]))
+		{
+			return false;
+		}
+
+		Print(input.c_str(), data.size(), results);
+
+		totalSize += data.size();
+		for (int i = 0; i < 2; i++)
+		{
+			totals[i].packed += results[i].packed;
+			totals[i].model.cycles += results[i].model.cycles;
+			totals[i].model.maxSequenceCycles = std::max(totals[i].model.maxSequenceCycles, results[i].model.maxSequenceCycles);
+		}
+	}
+
+	Print("total", totalSize, totals);
+	return true;
+}
@@ -0,0 +1,13 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzbench.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "lzenc.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool LzBench_Run(const std::vector<std::string>& inputs, const LzEncOptions& options);
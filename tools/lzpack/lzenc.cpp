@@ -0,0 +1,314 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzenc.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lzenc.h"
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const int kHashBits = 16;
+
+struct LzMatch
+{
+	int length = 0;
+	int offset = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Hash chains over every position so far, keyed on kLzMinMatch bytes.
+////////////////////////////////////////////////////////////////////////////////
+struct LzFinder
+{
+	const u8* data = nullptr;
+	int size = 0;
+	int inserted = 0;
+	std::vector<int> head;
+	std::vector<int> prev;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Hash(const u8* p)
+{
+	return (GetBE32(p) * 2654435761u) >> (32 - kHashBits);
+}
+
+static void InsertUpTo(LzFinder& finder, int pos)
+{
+	for (; finder.inserted < pos; finder.inserted++)
+	{
+		if (finder.inserted + kLzMinMatch <= finder.size)
+		{
+			u32 hash = Hash(finder.data + finder.inserted);
+			finder.prev[finder.inserted] = finder.head[hash];
+			finder.head[hash] = finder.inserted;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Longest match for pos, nearest first. A later one of the same length only
+// wins if it turns a byte copy into a long copy.
+////////////////////////////////////////////////////////////////////////////////
+static LzMatch Find(LzFinder& finder, const LzEncOptions& options, int pos)
+{
+	LzMatch best;
+
+	InsertUpTo(finder, pos);
+
+	if (pos + kLzMinMatch > finder.size)
+	{
+		return best;
+	}
+
+	const u8* data = finder.data;
+	int maxLength = std::min(kLzMaxMatch, finder.size - pos);
+	int candidate = finder.head[Hash(data + pos)];
+
+	for (int n = 0; candidate >= 0 && n < options.chain; n++, candidate = finder.prev[candidate])
+	{
+		int offset = pos - candidate;
+		if (offset > kLzMaxOffset)
+		{
+			break;
+		}
+
+		int length = 0;
+		while (length < maxLength && data[candidate + length] == data[pos + length])
+		{
+			length++;
+		}
+
+		bool faster = options.fastOffsets && LzEnc_IsFastOffset(offset) && !LzEnc_IsFastOffset(best.offset);
+		if (length >= kLzMinMatch && (length > best.length || (length == best.length && faster)))
+		{
+			best.length = length;
+			best.offset = offset;
+		}
+	}
+
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// One or more sequences: literal runs too long for one go a sequence without
+// a match each.
+////////////////////////////////////////////////////////////////////////////////
+static void Emit(std::vector<u8>& packed, const u8* literals, int count, LzMatch match)
+{
+	for (;;)
+	{
+		int run = std::min(count, kLzMaxLiterals);
+		bool last = (run == count);
+		int length = (last && match.length != 0) ? match.length - kLzMinMatch : 0;
+
+		packed.push_back((u8) ((std::min(run, 15) << 4) | std::min(length, 15)));
+		if (run >= 15)
+		{
+			packed.push_back((u8) (run - 15));
+		}
+
+		packed.insert(packed.end(), literals, literals + run);
+		literals += run;
+		count -= run;
+
+		int offset = last ? match.offset : 0;
+		packed.push_back((u8) (offset >> 8));
+		packed.push_back((u8) offset);
+
+		if (offset != 0 && length >= 15)
+		{
+			packed.push_back((u8) (length - 15));
+		}
+
+		if (last)
+		{
+			return;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Greedy with one step of lazy matching.
+////////////////////////////////////////////////////////////////////////////////
+void LzEnc_Pack(const std::vector<u8>& data, const LzEncOptions& options, std::vector<u8>& packed)
+{
+	LzFinder finder;
+	finder.data = data.data();
+	finder.size = (int) data.size();
+	finder.head.assign((size_t) 1 << kHashBits, -1);
+	finder.prev.assign(data.size(), -1);
+
+	packed.assign(kLzHeaderSize, 0);
+	PutBE32(packed.data(), (u32) data.size());
+
+	int minMatch = std::max(options.minMatch, kLzMinMatch);
+	int pos = 0;
+	int literal = 0;
+
+	while (pos < finder.size)
+	{
+		LzMatch match = Find(finder, options, pos);
+
+		if (match.length < minMatch || Find(finder, options, pos + 1).length > match.length)
+		{
+			pos++;
+			continue;
+		}
+
+		Emit(packed, finder.data + literal, pos - literal, match);
+		pos += match.length;
+		literal = pos;
+	}
+
+	if (literal < finder.size)
+	{
+		Emit(packed, finder.data + literal, finder.size - literal, LzMatch());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Cycles for the COPY macro in lz_a.s.
+////////////////////////////////////////////////////////////////////////////////
+static u32 CopyCycles(u32 src, u32 dst, u32 length)
+{
+	if (length < 8)
+	{
+		return 42 + 22 * length;
+	}
+
+	u32 cycles = 36;
+
+	if ((src ^ dst) & 1)
+	{
+		cycles += 10 + 24 + 58 * (length >> 2) + 14;
+	}
+	else
+	{
+		cycles += 8 + 8;
+
+		if (dst & 1)
+		{
+			cycles += 8 + 12 + 4;
+			length--;
+		}
+		else
+		{
+			cycles += 10;
+		}
+
+		cycles += 24 + 30 * (length >> 2) + 14;
+	}
+
+	// The two btst of the tail.
+	cycles += 10 + ((length & 2) ? (((src ^ dst) & 1) ? 8 + 24 + 10 : 8 + 12 + 10) : 10);
+	return cycles + 10 + ((length & 1) ? 8 + 12 : 10);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Follows Lz_Decode instruction by instruction; see lz_a.s.
+////////////////////////////////////////////////////////////////////////////////
+bool LzEnc_Model(const std::vector<u8>& packed, u32 srcAddress, u32 dstAddress, LzModel& model)
+{
+	model = LzModel();
+
+	if (packed.size() < (size_t) kLzHeaderSize)
+	{
+		return false;
+	}
+
+	u32 size = Lz_ReferenceSize(packed.data());
+	size_t src = kLzHeaderSize;
+	u32 dst = 0;
+
+	// Saving registers and loading the stream, then restoring them.
+	model.cycles = 118 + 18 + 96;
+
+	while (dst < size)
+	{
+		if (src + 3 > packed.size())
+		{
+			return false;
+		}
+
+		u32 token = packed[src++];
+		u32 literals = token >> 4;
+		u32 cycles = 16 + 38;
+
+		if (literals == 15)
+		{
+			literals += packed[src++];
+			cycles += 24;
+		}
+		else
+		{
+			cycles += 10;
+		}
+
+		if (src + literals + 2 > packed.size() || dst + literals > size)
+		{
+			return false;
+		}
+
+		cycles += CopyCycles(srcAddress + (u32) src, dstAddress + dst, literals);
+		src += literals;
+		dst += literals;
+		model.literals += literals;
+
+		u32 offset = GetBE16(&packed[src]);
+		src += 2;
+		cycles += 46;
+
+		if (offset == 0)
+		{
+			cycles += 10;
+		}
+		else
+		{
+			u32 length = token & 15;
+			cycles += 12 + 28;
+
+			if (length == 15)
+			{
+				if (src >= packed.size())
+				{
+					return false;
+				}
+
+				length += packed[src++];
+				cycles += 24;
+			}
+			else
+			{
+				cycles += 10;
+			}
+
+			length += kLzMinMatch;
+			cycles += 12;
+
+			if (offset > dst || dst + length > size)
+			{
+				return false;
+			}
+
+			if (offset < 4)
+			{
+				cycles += 10 + 4 + 22 * length + 4;
+			}
+			else
+			{
+				cycles += 8 + CopyCycles(dstAddress + dst - offset, dstAddress + dst, length) + 10;
+			}
+
+			dst += length;
+			model.matches += length;
+		}
+
+		model.cycles += cycles;
+		model.sequences++;
+		model.maxSequenceCycles = std::max(model.maxSequenceCycles, cycles);
+	}
+
+	return src == packed.size();
+}
@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzenc.h
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include "lzref.h"
+#include "types.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// The parse is tuned for the depacker rather than for size: a match has to be
+// minMatch bytes to be worth a sequence, and of two equally long matches the
+// one lz_a.s can copy a long at a time wins (see LzEnc_IsFastOffset).
+////////////////////////////////////////////////////////////////////////////////
+struct LzEncOptions
+{
+	int minMatch = 6;
+	int chain = 256;		// Hash chain entries tried per position.
+	bool fastOffsets = true;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// 68000 cycles for Lz_Decode to unpack a stream in one call, counted per
+// instruction along the path lz_a.s takes, without DMA contention. The
+// addresses only matter for their parity; INCBIN data is word aligned.
+////////////////////////////////////////////////////////////////////////////////
+struct LzModel
+{
+	u64 cycles = 0;
+	u32 sequences = 0;
+	u32 literals = 0;
+	u32 matches = 0;
+	u32 maxSequenceCycles = 0;	// What a time budget can be overrun by.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void LzEnc_Pack(const std::vector<u8>& data, const LzEncOptions& options, std::vector<u8>& packed);
+bool LzEnc_Model(const std::vector<u8>& packed, u32 srcAddress, u32 dstAddress, LzModel& model);
+
+inline bool LzEnc_IsFastOffset(int offset) { return offset >= 4 && (offset & 1) == 0; }
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzpack.cpp
+//
+// Packs assets for Lz_Depack (lz.h). For every input it writes input.lz,
+// which goes into the executable as it is:
+//
+//   INCBIN(sImageLz, "image.bpl.lz")
+//
+// and unpacks straight into its chip RAM buffer, a slice per frame if need
+// be. Every packed file is checked against the reference depacker.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "image.h"
+#include "lzbench.h"
+#include "lzenc.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const double kFrameCycles = 7093790.0 / 50.0;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void PrintUsage()
+{
+	printf("usage: lzpack [options] input...\n");
+	printf("  -min <n>    shortest match worth a sequence (default 6, at least 4)\n");
+	printf("  -chain <n>  matches tried per position (default 256)\n");
+	printf("  -small      tune for size instead of depack speed: -min 4, nearest offsets\n");
+	printf("  -bench      compare size and speed tuning on all inputs instead of packing\n");
+	printf("  -q          quiet\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+	LzEncOptions options;
+	bool bench = false;
+	bool quiet = false;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-min") && i + 1 < argc)
+		{
+			options.minMatch = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-chain") && i + 1 < argc)
+		{
+			options.chain = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-small"))
+		{
+			options.minMatch = kLzMinMatch;
+			options.fastOffsets = false;
+		}
+		else if (!strcmp(argv[i], "-bench"))
+		{
+			bench = true;
+		}
+		else if (!strcmp(argv[i], "-q"))
+		{
+			quiet = true;
+		}
+		else if (argv[i][0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else
+		{
+			inputs.push_back(argv[i]);
+		}
+	}
+
+	if (inputs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (bench)
+	{
+		return LzBench_Run(inputs, options) ? 0 : 1;
+	}
+
+	for (const std::string& input : inputs)
+	{
+		std::vector<u8> data, packed;
+		if (!File_Load(input, data))
+		{
+			return 1;
+		}
+
+		LzEnc_Pack(data, options, packed);
+
+		std::vector<u8> unpacked(data.size());
+		LzModel model;
+		if (Lz_Reference(packed.data(), unpacked.data()) != packed.size() || unpacked != data || !LzEnc_Model(packed, 0, 0, model))
+		{
+			fprintf(stderr, "%s: round trip failed\n", input.c_str());
+			return 1;
+		}
+
+		if (!File_Save(input + ".lz", packed.data(), packed.size()))
+		{
+			return 1;
+		}
+
+		if (!quiet)
+		{
+			printf("%s: %zu -> %zu bytes (%.1f%%), %llu cycles to unpack (%.2f per byte, %.2f frames)\n", input.c_str(), data.size(), packed.size(),
+				data.empty() ? 0.0 : 100.0 * packed.size() / data.size(), (unsigned long long) model.cycles,
+				data.empty() ? 0.0 : (double) model.cycles / data.size(), model.cycles / kFrameCycles);
+		}
+	}
+
+	return 0;
+}
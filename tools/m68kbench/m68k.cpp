@@ -0,0 +1,1556 @@
+////////////////////////////////////////////////////////////////////////////////
+// m68k.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "m68k.h"
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u8 kCcrC = 0x01;
+static const u8 kCcrV = 0x02;
+static const u8 kCcrZ = 0x04;
+static const u8 kCcrN = 0x08;
+static const u8 kCcrX = 0x10;
+
+////////////////////////////////////////////////////////////////////////////////
+// Effective address calculation times from the manual, byte/word and long,
+// for Dn, An, (An), (An)+, -(An), d16(An), d8(An,Xn), abs.W, abs.L, d16(PC),
+// d8(PC,Xn) and #imm. A MOVE destination costs the same except -(An), which
+// costs what (An) does.
+////////////////////////////////////////////////////////////////////////////////
+static const int kEaTimes[12][2] =
+{
+	{0, 0}, {0, 0}, {4, 8}, {4, 8}, {6, 10}, {8, 12}, {10, 14}, {8, 12}, {12, 16}, {8, 12}, {10, 14}, {4, 8},
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// LEA, PEA, JMP and JSR for (An), d16(An), d8(An,Xn), abs.W, abs.L, d16(PC)
+// and d8(PC,Xn), and the MOVEM base times for the same modes.
+////////////////////////////////////////////////////////////////////////////////
+static const int kLeaTimes[7]		 = {4, 8, 12, 8, 12, 8, 12};
+static const int kPeaTimes[7]		 = {12, 16, 20, 16, 20, 16, 20};
+static const int kJmpTimes[7]		 = {8, 10, 14, 10, 12, 10, 14};
+static const int kJsrTimes[7]		 = {16, 18, 22, 18, 20, 18, 22};
+static const int kMovemToRegTimes[7] = {12, 16, 18, 16, 20, 16, 18};
+static const int kMovemToMemTimes[7] = {8, 12, 14, 12, 16, 0, 0};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+enum M68kEaKind
+{
+	kEaData,
+	kEaAddress,
+	kEaMemory,
+	kEaImmediate,
+};
+
+struct M68kEa
+{
+	M68kEaKind kind;
+	int reg;
+	u32 address;
+	u32 value;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Mask(int size) { return ((size == 1) ? 0xff : ((size == 2) ? 0xffff : 0xffffffff)); }
+static u32 Msb(int size) { return (1u << (size * 8 - 1)); }
+static u32 SignExtend(u32 v, int size) { return ((size == 1) ? (u32) (s32) (s8) v : ((size == 2) ? (u32) (s32) (s16) v : v)); }
+static int EaIndex(int mode, int reg) { return ((mode < 7) ? mode : 7 + reg); }
+static int EaTime(int mode, int reg, int size) { return kEaTimes[EaIndex(mode, reg)][size == 4]; }
+static int MoveDstTime(int mode, int reg, int size) { return ((mode == 4) ? EaTime(2, 0, size) : EaTime(mode, reg, size)); }
+static bool IsRegisterOrImmediate(int mode, int reg) { return (mode <= 1 || (mode == 7 && reg == 4)); }
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void M68k_Fault(M68k& cpu, const char* what, u32 address)
+{
+	if (cpu.error.empty())
+	{
+		char text[128];
+		snprintf(text, sizeof(text), "%s at $%06x, pc $%06x", what, address & 0xffffff, cpu.opPc);
+		cpu.error = text;
+	}
+}
+
+static int M68k_Unsupported(M68k& cpu, u16 op)
+{
+	char text[64];
+	snprintf(text, sizeof(text), "unsupported instruction $%04x", op);
+	M68k_Fault(cpu, text, cpu.opPc);
+
+	return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool M68k_IsChip(u32 address)
+{
+	return ((address & 0xffffff) < kM68kChipBase + kM68kChipSize);
+}
+
+u8* M68k_Memory(M68k& cpu, u32 address, u32 size)
+{
+	address &= 0xffffff;
+
+	if (address >= kM68kChipBase && address - kM68kChipBase + size <= cpu.chip.size())
+	{
+		return &cpu.chip[address - kM68kChipBase];
+	}
+
+	if (address >= kM68kFastBase && address - kM68kFastBase + size <= cpu.fast.size())
+	{
+		return &cpu.fast[address - kM68kFastBase];
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// One bus cycle. Chip RAM waits for an even colour clock without bitplane
+// DMA, fast RAM never waits.
+////////////////////////////////////////////////////////////////////////////////
+static void M68k_Bus(M68k& cpu, u32 address)
+{
+	cpu.opAccesses++;
+
+	if (!M68k_IsChip(address))
+	{
+		cpu.cycles += 4;
+		return;
+	}
+
+	const M68kDisplay& display = cpu.display;
+	u64 clock = (cpu.cycles + 1) / 2;
+
+	for (;;)
+	{
+		int hpos = (int) (clock % kDmaLineCycles);
+		int line = (int) (clock / kDmaLineCycles % kM68kFrameLines);
+		bool fetch = line >= display.top && line < display.top + display.lines && Dma_IsBitplaneCycle(display.dma, hpos);
+
+		if ((hpos & 1) == 0 && !fetch)
+		{
+			break;
+		}
+
+		clock++;
+	}
+
+	cpu.waits += clock * 2 - cpu.cycles;
+	cpu.cycles = clock * 2 + 4;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 M68k_Read(M68k& cpu, u32 address, int size)
+{
+	address &= 0xffffff;
+
+	if (size > 1 && (address & 1))
+	{
+		M68k_Fault(cpu, "address error reading", address);
+		return 0;
+	}
+
+	const u8* p = M68k_Memory(cpu, address, size);
+	if (p == nullptr)
+	{
+		M68k_Fault(cpu, "bus error reading", address);
+		return 0;
+	}
+
+	M68k_Bus(cpu, address);
+
+	if (size == 4)
+	{
+		M68k_Bus(cpu, address + 2);
+		return GetBE32(p);
+	}
+
+	return ((size == 2) ? GetBE16(p) : p[0]);
+}
+
+static void M68k_Write(M68k& cpu, u32 address, int size, u32 value)
+{
+	address &= 0xffffff;
+
+	if (size > 1 && (address & 1))
+	{
+		M68k_Fault(cpu, "address error writing", address);
+		return;
+	}
+
+	u8* p = M68k_Memory(cpu, address, size);
+	if (p == nullptr)
+	{
+		M68k_Fault(cpu, "bus error writing", address);
+		return;
+	}
+
+	M68k_Bus(cpu, address);
+
+	if (size == 4)
+	{
+		M68k_Bus(cpu, address + 2);
+		PutBE32(p, value);
+	}
+	else if (size == 2)
+	{
+		PutBE16(p, (u16) value);
+	}
+	else
+	{
+		p[0] = (u8) value;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u16 M68k_Fetch16(M68k& cpu)
+{
+	u16 value = (u16) M68k_Read(cpu, cpu.pc, 2);
+	cpu.pc += 2;
+
+	return value;
+}
+
+static u32 M68k_Fetch32(M68k& cpu)
+{
+	u32 high = M68k_Fetch16(cpu);
+
+	return (high << 16) | M68k_Fetch16(cpu);
+}
+
+static void M68k_Push(M68k& cpu, u32 value)
+{
+	cpu.a[7] -= 4;
+	M68k_Write(cpu, cpu.a[7], 4, value);
+}
+
+static u32 M68k_Pop(M68k& cpu, int size)
+{
+	u32 value = M68k_Read(cpu, cpu.a[7], size);
+	cpu.a[7] += size;
+
+	return value;
+}
+
+static void M68k_SetD(M68k& cpu, int reg, u32 value, int size)
+{
+	u32 mask = Mask(size);
+	cpu.d[reg] = (cpu.d[reg] & ~mask) | (value & mask);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Effective addresses. Decoding fetches the extension words and does the
+// increment or decrement, so it must happen exactly once per operand.
+////////////////////////////////////////////////////////////////////////////////
+static u32 M68k_Index(M68k& cpu, u32 base)
+{
+	u16 ext = M68k_Fetch16(cpu);
+	int reg = (ext >> 12) & 7;
+	u32 index = (ext & 0x8000) ? cpu.a[reg] : cpu.d[reg];
+
+	if ((ext & 0x0800) == 0)
+	{
+		index = SignExtend(index, 2);
+	}
+
+	return base + index + SignExtend(ext, 1);
+}
+
+static bool M68k_DecodeEa(M68k& cpu, int mode, int reg, int size, M68kEa& ea)
+{
+	u32 step = (size == 1 && reg == 7) ? 2 : size;
+
+	ea.reg = reg;
+	ea.kind = kEaMemory;
+
+	switch (mode)
+	{
+		case 0: ea.kind = kEaData; return true;
+		case 1: ea.kind = kEaAddress; return true;
+		case 2: ea.address = cpu.a[reg]; return true;
+		case 3: ea.address = cpu.a[reg]; cpu.a[reg] += step; return true;
+		case 4: cpu.a[reg] -= step; ea.address = cpu.a[reg]; return true;
+		case 5: ea.address = cpu.a[reg] + SignExtend(M68k_Fetch16(cpu), 2); return true;
+		case 6: ea.address = M68k_Index(cpu, cpu.a[reg]); return true;
+	}
+
+	switch (reg)
+	{
+		case 0: ea.address = SignExtend(M68k_Fetch16(cpu), 2); return true;
+		case 1: ea.address = M68k_Fetch32(cpu); return true;
+		case 2: { u32 base = cpu.pc; ea.address = base + SignExtend(M68k_Fetch16(cpu), 2); return true; }
+		case 3: ea.address = M68k_Index(cpu, cpu.pc); return true;
+		case 4:
+			ea.kind = kEaImmediate;
+			ea.value = (size == 4) ? M68k_Fetch32(cpu) : (M68k_Fetch16(cpu) & Mask(size));
+			return true;
+	}
+
+	M68k_Fault(cpu, "bad addressing mode", cpu.opPc);
+	return false;
+}
+
+static u32 M68k_ReadEa(M68k& cpu, const M68kEa& ea, int size)
+{
+	switch (ea.kind)
+	{
+		case kEaData:	   return cpu.d[ea.reg] & Mask(size);
+		case kEaAddress:   return cpu.a[ea.reg] & Mask(size);
+		case kEaMemory:	   return M68k_Read(cpu, ea.address, size);
+		case kEaImmediate: return ea.value;
+	}
+
+	return 0;
+}
+
+static void M68k_WriteEa(M68k& cpu, const M68kEa& ea, int size, u32 value)
+{
+	switch (ea.kind)
+	{
+		case kEaData:	   M68k_SetD(cpu, ea.reg, value, size); break;
+		case kEaAddress:   cpu.a[ea.reg] = SignExtend(value, size); break;
+		case kEaMemory:	   M68k_Write(cpu, ea.address, size, value); break;
+		case kEaImmediate: M68k_Fault(cpu, "write to an immediate", cpu.opPc); break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Condition codes.
+////////////////////////////////////////////////////////////////////////////////
+static bool M68k_Condition(u8 ccr, int cc)
+{
+	bool c = (ccr & kCcrC) != 0;
+	bool v = (ccr & kCcrV) != 0;
+	bool z = (ccr & kCcrZ) != 0;
+	bool n = (ccr & kCcrN) != 0;
+
+	switch (cc)
+	{
+		case 0:  return true;
+		case 1:  return false;
+		case 2:  return !c && !z;
+		case 3:  return c || z;
+		case 4:  return !c;
+		case 5:  return c;
+		case 6:  return !z;
+		case 7:  return z;
+		case 8:  return !v;
+		case 9:  return v;
+		case 10: return !n;
+		case 11: return n;
+		case 12: return n == v;
+		case 13: return n != v;
+		case 14: return !z && n == v;
+		default: return z || n != v;
+	}
+}
+
+static void M68k_Logic(M68k& cpu, u32 r, int size)
+{
+	cpu.ccr = (u8) ((cpu.ccr & kCcrX) | (((r & Mask(size)) == 0) ? kCcrZ : 0) | ((r & Msb(size)) ? kCcrN : 0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// d + s + carry, and d - s - borrow. With extend (ADDX, SUBX, NEGX) Z is only
+// ever cleared; compare leaves X alone.
+////////////////////////////////////////////////////////////////////////////////
+static u32 M68k_Add(M68k& cpu, u32 s, u32 d, int size, u32 carry, bool extend)
+{
+	u32 mask = Mask(size);
+	u32 msb = Msb(size);
+	s &= mask;
+	d &= mask;
+
+	u64 wide = (u64) s + d + carry;
+	u32 r = (u32) wide & mask;
+	bool c = ((wide >> (size * 8)) & 1) != 0;
+	bool v = ((s ^ r) & (d ^ r) & msb) != 0;
+	bool z = extend ? (r == 0 && (cpu.ccr & kCcrZ)) : (r == 0);
+
+	cpu.ccr = (u8) ((c ? kCcrX | kCcrC : 0) | (v ? kCcrV : 0) | (z ? kCcrZ : 0) | ((r & msb) ? kCcrN : 0));
+
+	return r;
+}
+
+static u32 M68k_Sub(M68k& cpu, u32 s, u32 d, int size, u32 borrow, bool extend, bool compare)
+{
+	u32 mask = Mask(size);
+	u32 msb = Msb(size);
+	s &= mask;
+	d &= mask;
+
+	u32 r = (d - s - borrow) & mask;
+	bool c = (u64) s + borrow > d;
+	bool v = ((s ^ d) & (r ^ d) & msb) != 0;
+	bool z = extend ? (r == 0 && (cpu.ccr & kCcrZ)) : (r == 0);
+	u8 x = compare ? (cpu.ccr & kCcrX) : (c ? kCcrX : 0);
+
+	cpu.ccr = (u8) (x | (c ? kCcrC : 0) | (v ? kCcrV : 0) | (z ? kCcrZ : 0) | ((r & msb) ? kCcrN : 0));
+
+	return r;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ASx, LSx, ROXx and ROx by count, one bit at a time.
+////////////////////////////////////////////////////////////////////////////////
+static u32 M68k_Shift(M68k& cpu, int type, bool left, u32 value, int count, int size)
+{
+	u32 mask = Mask(size);
+	u32 msb = Msb(size);
+	bool x = (cpu.ccr & kCcrX) != 0;
+	bool c = (type == 2) ? x : false;
+	bool v = false;
+
+	value &= mask;
+
+	for (int i = 0; i < count; i++)
+	{
+		bool out = left ? (value & msb) != 0 : (value & 1) != 0;
+
+		if (left)
+		{
+			u32 shifted = (value << 1) & mask;
+
+			switch (type)
+			{
+				case 0: v = v || ((shifted ^ value) & msb) != 0; break;
+				case 2: shifted |= x ? 1 : 0; break;
+				case 3: shifted |= out ? 1 : 0; break;
+			}
+
+			value = shifted;
+		}
+		else
+		{
+			switch (type)
+			{
+				case 0: value = (value >> 1) | (value & msb); break;
+				case 1: value >>= 1; break;
+				case 2: value = (value >> 1) | (x ? msb : 0); break;
+				case 3: value = (value >> 1) | (out ? msb : 0); break;
+			}
+		}
+
+		c = out;
+		if (type != 3)
+		{
+			x = out;
+		}
+	}
+
+	cpu.ccr = (u8) ((x ? kCcrX : 0) | (c ? kCcrC : 0) | (v ? kCcrV : 0) | ((value == 0) ? kCcrZ : 0) | ((value & msb) ? kCcrN : 0));
+
+	return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Division times by the microcode, after Jorge Cwik's analysis; the manual
+// only gives the worst case.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_DivuTime(u32 dividend, u16 divisor)
+{
+	if ((dividend >> 16) >= divisor)
+	{
+		return 10;
+	}
+
+	int mcycles = 38;
+	u32 hdivisor = (u32) divisor << 16;
+
+	for (int i = 0; i < 15; i++)
+	{
+		u32 temp = dividend;
+		dividend <<= 1;
+
+		if ((s32) temp < 0)
+		{
+			dividend -= hdivisor;
+		}
+		else
+		{
+			mcycles += 2;
+
+			if (dividend >= hdivisor)
+			{
+				dividend -= hdivisor;
+				mcycles--;
+			}
+		}
+	}
+
+	return mcycles * 2;
+}
+
+static int M68k_DivsTime(s32 dividend, s16 divisor)
+{
+	int mcycles = (dividend < 0) ? 7 : 6;
+	u32 absDividend = (dividend < 0) ? 0u - (u32) dividend : (u32) dividend;
+	u32 absDivisor = (divisor < 0) ? (u32) -divisor : (u32) divisor;
+
+	if ((absDividend >> 16) >= absDivisor)
+	{
+		return (mcycles + 2) * 2;
+	}
+
+	u32 quotient = absDividend / absDivisor;
+	mcycles += 55;
+
+	if (divisor >= 0)
+	{
+		mcycles += (dividend >= 0) ? -1 : 1;
+	}
+
+	for (int i = 0; i < 15; i++)
+	{
+		if ((s16) quotient >= 0)
+		{
+			mcycles++;
+		}
+		quotient <<= 1;
+	}
+
+	return mcycles * 2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BTST, BCHG, BCLR and BSET: long on a data register, byte in memory.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Bit(M68k& cpu, u16 op, u32 bit, bool isStatic)
+{
+	int type = (op >> 6) & 3;
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+
+	if (mode == 0)
+	{
+		bit &= 31;
+		u32 value = cpu.d[reg];
+		cpu.ccr = (u8) ((cpu.ccr & ~kCcrZ) | (((value >> bit) & 1) ? 0 : kCcrZ));
+
+		switch (type)
+		{
+			case 1: cpu.d[reg] = value ^ (1u << bit); break;
+			case 2: cpu.d[reg] = value & ~(1u << bit); break;
+			case 3: cpu.d[reg] = value | (1u << bit); break;
+		}
+
+		int high = (bit >= 16) ? 2 : 0;
+		switch (type)
+		{
+			case 0:  return isStatic ? 10 : 6;
+			case 2:  return (isStatic ? 12 : 8) + high;
+			default: return (isStatic ? 10 : 6) + high;
+		}
+	}
+
+	M68kEa ea;
+	if (!M68k_DecodeEa(cpu, mode, reg, 1, ea))
+	{
+		return -1;
+	}
+
+	bit &= 7;
+	u32 value = M68k_ReadEa(cpu, ea, 1);
+	cpu.ccr = (u8) ((cpu.ccr & ~kCcrZ) | (((value >> bit) & 1) ? 0 : kCcrZ));
+
+	switch (type)
+	{
+		case 1: M68k_WriteEa(cpu, ea, 1, value ^ (1u << bit)); break;
+		case 2: M68k_WriteEa(cpu, ea, 1, value & ~(1u << bit)); break;
+		case 3: M68k_WriteEa(cpu, ea, 1, value | (1u << bit)); break;
+	}
+
+	return ((type == 0) ? (isStatic ? 8 : 4) : (isStatic ? 12 : 8)) + EaTime(mode, reg, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bit operations, ORI, ANDI, SUBI, ADDI, EORI and CMPI.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Group0(M68k& cpu, u16 op)
+{
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+	int kind = (op >> 9) & 7;
+
+	if (op & 0x0100)
+	{
+		if (mode == 1)
+		{
+			return M68k_Unsupported(cpu, op);	// MOVEP
+		}
+
+		return M68k_Bit(cpu, op, cpu.d[kind], false);
+	}
+
+	if (kind == 4)
+	{
+		u32 bit = M68k_Fetch16(cpu);
+		return M68k_Bit(cpu, op, bit, true);
+	}
+
+	int sizeBits = (op >> 6) & 3;
+	if (sizeBits == 3 || kind == 7 || kind == 4)
+	{
+		return M68k_Unsupported(cpu, op);
+	}
+
+	int size = 1 << sizeBits;
+	u32 imm = (size == 4) ? M68k_Fetch32(cpu) : (M68k_Fetch16(cpu) & Mask(size));
+
+	if (mode == 7 && reg == 4)
+	{
+		if (size != 1)
+		{
+			return M68k_Unsupported(cpu, op);	// To SR, supervisor only.
+		}
+
+		switch (kind)
+		{
+			case 0:  cpu.ccr |= (u8) imm; break;
+			case 1:  cpu.ccr &= (u8) imm; break;
+			case 5:  cpu.ccr ^= (u8) imm; break;
+			default: return M68k_Unsupported(cpu, op);
+		}
+
+		cpu.ccr &= 0x1f;
+		return 20;
+	}
+
+	M68kEa ea;
+	if (!M68k_DecodeEa(cpu, mode, reg, size, ea))
+	{
+		return -1;
+	}
+
+	u32 d = M68k_ReadEa(cpu, ea, size);
+	u32 r = 0;
+
+	switch (kind)
+	{
+		case 0: r = d | imm; M68k_Logic(cpu, r, size); break;
+		case 1: r = d & imm; M68k_Logic(cpu, r, size); break;
+		case 2: r = M68k_Sub(cpu, imm, d, size, 0, false, false); break;
+		case 3: r = M68k_Add(cpu, imm, d, size, 0, false); break;
+		case 5: r = d ^ imm; M68k_Logic(cpu, r, size); break;
+		case 6: M68k_Sub(cpu, imm, d, size, 0, false, true); break;
+	}
+
+	if (kind == 6)
+	{
+		return (mode == 0) ? ((size == 4) ? 14 : 8) : ((size == 4) ? 12 : 8) + EaTime(mode, reg, size);
+	}
+
+	M68k_WriteEa(cpu, ea, size, r);
+
+	if (mode == 0)
+	{
+		return (size == 4) ? ((kind == 1) ? 14 : 16) : 8;
+	}
+
+	return ((size == 4) ? 20 : 12) + EaTime(mode, reg, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// MOVE and MOVEA.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Move(M68k& cpu, u16 op)
+{
+	static const int kSizes[4] = {0, 1, 4, 2};
+
+	int size = kSizes[op >> 12];
+	int srcMode = (op >> 3) & 7;
+	int srcReg = op & 7;
+	int dstMode = (op >> 6) & 7;
+	int dstReg = (op >> 9) & 7;
+
+	M68kEa src;
+	if (!M68k_DecodeEa(cpu, srcMode, srcReg, size, src))
+	{
+		return -1;
+	}
+
+	u32 value = M68k_ReadEa(cpu, src, size);
+
+	if (dstMode == 1)
+	{
+		cpu.a[dstReg] = SignExtend(value, size);
+		return 4 + EaTime(srcMode, srcReg, size);
+	}
+
+	M68kEa dst;
+	if (!M68k_DecodeEa(cpu, dstMode, dstReg, size, dst))
+	{
+		return -1;
+	}
+
+	M68k_WriteEa(cpu, dst, size, value);
+	M68k_Logic(cpu, value, size);
+
+	return 4 + EaTime(srcMode, srcReg, size) + MoveDstTime(dstMode, dstReg, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Movem(M68k& cpu, u16 op)
+{
+	int size = (op & 0x0040) ? 4 : 2;
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+	u16 mask = M68k_Fetch16(cpu);
+	int count = __builtin_popcount(mask);
+	int perReg = (size == 4) ? 8 : 4;
+
+	auto regRef = [&](int i) -> u32& { return (i < 8) ? cpu.d[i] : cpu.a[i - 8]; };
+
+	if ((op & 0x0400) == 0)
+	{
+		if (mode == 4)
+		{
+			u32 address = cpu.a[reg];
+
+			for (int bit = 0; bit < 16; bit++)
+			{
+				if (mask & (1 << bit))
+				{
+					address -= size;
+					M68k_Write(cpu, address, size, regRef(15 - bit));
+				}
+			}
+
+			cpu.a[reg] = address;
+			return 8 + count * perReg;
+		}
+
+		if (mode < 2 || mode == 3 || (mode == 7 && reg > 1))
+		{
+			return M68k_Unsupported(cpu, op);
+		}
+
+		M68kEa ea;
+		if (!M68k_DecodeEa(cpu, mode, reg, size, ea))
+		{
+			return -1;
+		}
+
+		u32 address = ea.address;
+		for (int i = 0; i < 16; i++)
+		{
+			if (mask & (1 << i))
+			{
+				M68k_Write(cpu, address, size, regRef(i));
+				address += size;
+			}
+		}
+
+		return kMovemToMemTimes[EaIndex(mode, reg) - 2] + count * perReg;
+	}
+
+	if (mode < 2 || mode == 4 || (mode == 7 && reg > 3))
+	{
+		return M68k_Unsupported(cpu, op);
+	}
+
+	u32 address;
+	if (mode == 3)
+	{
+		address = cpu.a[reg];
+	}
+	else
+	{
+		M68kEa ea;
+		if (!M68k_DecodeEa(cpu, mode, reg, size, ea))
+		{
+			return -1;
+		}
+		address = ea.address;
+	}
+
+	for (int i = 0; i < 16; i++)
+	{
+		if (mask & (1 << i))
+		{
+			regRef(i) = SignExtend(M68k_Read(cpu, address, size), size);
+			address += size;
+		}
+	}
+
+	// The 68000 reads one word more than it needs.
+	M68k_Bus(cpu, address);
+
+	if (mode == 3)
+	{
+		cpu.a[reg] = address;
+	}
+
+	return kMovemToRegTimes[EaIndex(mode, reg) - 2] + count * perReg;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Control addressing modes, as an index into kLeaTimes and friends.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Control(int mode, int reg)
+{
+	int index = EaIndex(mode, reg);
+
+	return (mode == 2 || mode == 5 || mode == 6 || (mode == 7 && reg <= 3)) ? index - ((mode == 2) ? 2 : 4) : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// NEGX, CLR, NEG, NOT and TST.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Unary(M68k& cpu, u16 op, int kind)
+{
+	int size = 1 << ((op >> 6) & 3);
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+
+	M68kEa ea;
+	if (!M68k_DecodeEa(cpu, mode, reg, size, ea))
+	{
+		return -1;
+	}
+
+	u32 d = M68k_ReadEa(cpu, ea, size);
+	u32 r = 0;
+
+	switch (kind)
+	{
+		case 0: r = M68k_Sub(cpu, d, 0, size, (cpu.ccr & kCcrX) ? 1 : 0, true, false); break;
+		case 1: r = 0; M68k_Logic(cpu, r, size); break;
+		case 2: r = M68k_Sub(cpu, d, 0, size, 0, false, false); break;
+		case 3: r = ~d; M68k_Logic(cpu, r, size); break;
+		case 5: M68k_Logic(cpu, d, size); return 4 + EaTime(mode, reg, size);
+	}
+
+	M68k_WriteEa(cpu, ea, size, r);
+
+	if (mode == 0)
+	{
+		return (size == 4) ? 6 : 4;
+	}
+
+	return ((size == 4) ? 12 : 8) + EaTime(mode, reg, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Group4(M68k& cpu, u16 op)
+{
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+	int control = M68k_Control(mode, reg);
+
+	if ((op & 0xf1c0) == 0x41c0)
+	{
+		M68kEa ea;
+		if (control < 0 || !M68k_DecodeEa(cpu, mode, reg, 4, ea))
+		{
+			return M68k_Unsupported(cpu, op);
+		}
+
+		cpu.a[(op >> 9) & 7] = ea.address;
+		return kLeaTimes[control];
+	}
+
+	if ((op & 0xf1c0) == 0x4180)
+	{
+		return M68k_Unsupported(cpu, op);	// CHK
+	}
+
+	switch (op & 0xffc0)
+	{
+		case 0x40c0:
+		{
+			M68kEa ea;
+			if (!M68k_DecodeEa(cpu, mode, reg, 2, ea))
+			{
+				return -1;
+			}
+
+			if (mode != 0)
+			{
+				M68k_ReadEa(cpu, ea, 2);
+			}
+
+			M68k_WriteEa(cpu, ea, 2, cpu.ccr);
+			return (mode == 0) ? 6 : 8 + EaTime(mode, reg, 2);
+		}
+
+		case 0x44c0:
+		{
+			M68kEa ea;
+			if (!M68k_DecodeEa(cpu, mode, reg, 2, ea))
+			{
+				return -1;
+			}
+
+			cpu.ccr = (u8) (M68k_ReadEa(cpu, ea, 2) & 0x1f);
+			return 12 + EaTime(mode, reg, 2);
+		}
+
+		case 0x4840:
+		{
+			if (mode == 0)
+			{
+				cpu.d[reg] = (cpu.d[reg] >> 16) | (cpu.d[reg] << 16);
+				M68k_Logic(cpu, cpu.d[reg], 4);
+				return 4;
+			}
+
+			M68kEa ea;
+			if (control < 0 || !M68k_DecodeEa(cpu, mode, reg, 4, ea))
+			{
+				return M68k_Unsupported(cpu, op);
+			}
+
+			M68k_Push(cpu, ea.address);
+			return kPeaTimes[control];
+		}
+
+		case 0x4880:
+		case 0x48c0:
+			if (mode == 0)
+			{
+				if (op & 0x0040)
+				{
+					cpu.d[reg] = SignExtend(cpu.d[reg], 2);
+					M68k_Logic(cpu, cpu.d[reg], 4);
+				}
+				else
+				{
+					M68k_SetD(cpu, reg, SignExtend(cpu.d[reg], 1), 2);
+					M68k_Logic(cpu, cpu.d[reg], 2);
+				}
+				return 4;
+			}
+			return M68k_Movem(cpu, op);
+
+		case 0x4c80:
+		case 0x4cc0:
+			return M68k_Movem(cpu, op);
+
+		case 0x4e80:
+		case 0x4ec0:
+		{
+			M68kEa ea;
+			if (control < 0 || !M68k_DecodeEa(cpu, mode, reg, 4, ea))
+			{
+				return M68k_Unsupported(cpu, op);
+			}
+
+			if (op & 0x0040)
+			{
+				cpu.pc = ea.address;
+				return kJmpTimes[control];
+			}
+
+			M68k_Push(cpu, cpu.pc);
+			cpu.pc = ea.address;
+			return kJsrTimes[control];
+		}
+	}
+
+	if ((op & 0xff00) <= 0x4600 && (op & 0x00c0) != 0x00c0 && (op & 0x0100) == 0)
+	{
+		return M68k_Unary(cpu, op, (op >> 9) & 3);
+	}
+
+	if ((op & 0xff00) == 0x4a00 && (op & 0x00c0) != 0x00c0)
+	{
+		return M68k_Unary(cpu, op, 5);
+	}
+
+	switch (op)
+	{
+		case 0x4e71:
+			return 4;
+
+		case 0x4e75:
+			cpu.pc = M68k_Pop(cpu, 4);
+			return 16;
+
+		case 0x4e77:
+			cpu.ccr = (u8) (M68k_Pop(cpu, 2) & 0x1f);
+			cpu.pc = M68k_Pop(cpu, 4);
+			return 20;
+	}
+
+	if ((op & 0xfff8) == 0x4e50)
+	{
+		s16 displacement = (s16) M68k_Fetch16(cpu);
+		M68k_Push(cpu, cpu.a[reg]);
+		cpu.a[reg] = cpu.a[7];
+		cpu.a[7] += displacement;
+		return 16;
+	}
+
+	if ((op & 0xfff8) == 0x4e58)
+	{
+		cpu.a[7] = cpu.a[reg];
+		cpu.a[reg] = M68k_Pop(cpu, 4);
+		return 12;
+	}
+
+	return M68k_Unsupported(cpu, op);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ADDQ, SUBQ, Scc and DBcc.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Group5(M68k& cpu, u16 op)
+{
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+
+	if (((op >> 6) & 3) == 3)
+	{
+		int cc = (op >> 8) & 15;
+
+		if (mode == 1)
+		{
+			u32 base = cpu.pc;
+			u32 displacement = SignExtend(M68k_Fetch16(cpu), 2);
+
+			if (M68k_Condition(cpu.ccr, cc))
+			{
+				return 12;
+			}
+
+			u16 count = (u16) (cpu.d[reg] - 1);
+			M68k_SetD(cpu, reg, count, 2);
+
+			if (count == 0xffff)
+			{
+				return 14;
+			}
+
+			cpu.pc = base + displacement;
+			return 10;
+		}
+
+		M68kEa ea;
+		if (!M68k_DecodeEa(cpu, mode, reg, 1, ea))
+		{
+			return -1;
+		}
+
+		bool set = M68k_Condition(cpu.ccr, cc);
+
+		if (mode != 0)
+		{
+			M68k_ReadEa(cpu, ea, 1);
+		}
+
+		M68k_WriteEa(cpu, ea, 1, set ? 0xff : 0x00);
+		return (mode == 0) ? (set ? 6 : 4) : 8 + EaTime(mode, reg, 1);
+	}
+
+	int size = 1 << ((op >> 6) & 3);
+	u32 data = ((op >> 9) & 7) ? (op >> 9) & 7 : 8;
+	bool sub = (op & 0x0100) != 0;
+
+	if (mode == 1)
+	{
+		cpu.a[reg] += sub ? 0u - data : data;
+		return 8;
+	}
+
+	M68kEa ea;
+	if (!M68k_DecodeEa(cpu, mode, reg, size, ea))
+	{
+		return -1;
+	}
+
+	u32 d = M68k_ReadEa(cpu, ea, size);
+	u32 r = sub ? M68k_Sub(cpu, data, d, size, 0, false, false) : M68k_Add(cpu, data, d, size, 0, false);
+	M68k_WriteEa(cpu, ea, size, r);
+
+	if (mode == 0)
+	{
+		return (size == 4) ? 8 : 4;
+	}
+
+	return ((size == 4) ? 12 : 8) + EaTime(mode, reg, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bcc, BRA and BSR.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Branch(M68k& cpu, u16 op)
+{
+	int cc = (op >> 8) & 15;
+	u32 base = cpu.pc;
+	u32 displacement = SignExtend(op, 1);
+	bool word = (op & 0xff) == 0;
+
+	if ((op & 0xff) == 0xff)
+	{
+		return M68k_Unsupported(cpu, op);	// 68020 long branch.
+	}
+
+	if (word)
+	{
+		displacement = SignExtend(M68k_Fetch16(cpu), 2);
+	}
+
+	if (cc == 1)
+	{
+		M68k_Push(cpu, cpu.pc);
+		cpu.pc = base + displacement;
+		return 18;
+	}
+
+	if (M68k_Condition(cpu.ccr, cc))
+	{
+		cpu.pc = base + displacement;
+		return 10;
+	}
+
+	return word ? 12 : 8;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// OR, AND, SUB, ADD, CMP and EOR between a data register and an effective
+// address, both directions.
+////////////////////////////////////////////////////////////////////////////////
+enum M68kAlu
+{
+	kAluOr,
+	kAluAnd,
+	kAluSub,
+	kAluAdd,
+	kAluCmp,
+	kAluEor,
+};
+
+static int M68k_Alu(M68k& cpu, u16 op, M68kAlu alu)
+{
+	int dreg = (op >> 9) & 7;
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+	int size = 1 << ((op >> 6) & 3);
+	bool toEa = (op & 0x0100) != 0;
+
+	M68kEa ea;
+	if (!M68k_DecodeEa(cpu, mode, reg, size, ea))
+	{
+		return -1;
+	}
+
+	u32 e = M68k_ReadEa(cpu, ea, size);
+	u32 s = toEa ? cpu.d[dreg] : e;
+	u32 d = toEa ? e : cpu.d[dreg];
+	u32 r = 0;
+
+	switch (alu)
+	{
+		case kAluOr:  r = s | d; M68k_Logic(cpu, r, size); break;
+		case kAluAnd: r = s & d; M68k_Logic(cpu, r, size); break;
+		case kAluEor: r = s ^ d; M68k_Logic(cpu, r, size); break;
+		case kAluSub: r = M68k_Sub(cpu, s, d, size, 0, false, false); break;
+		case kAluAdd: r = M68k_Add(cpu, s, d, size, 0, false); break;
+		case kAluCmp: M68k_Sub(cpu, s, d, size, 0, false, true); break;
+	}
+
+	if (alu == kAluCmp)
+	{
+		return ((size == 4) ? 6 : 4) + EaTime(mode, reg, size);
+	}
+
+	if (!toEa)
+	{
+		M68k_SetD(cpu, dreg, r, size);
+		return ((size == 4) ? (IsRegisterOrImmediate(mode, reg) ? 8 : 6) : 4) + EaTime(mode, reg, size);
+	}
+
+	M68k_WriteEa(cpu, ea, size, r);
+
+	if (mode == 0)
+	{
+		return (size == 4) ? 8 : 4;
+	}
+
+	return ((size == 4) ? 12 : 8) + EaTime(mode, reg, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ADDA, SUBA and CMPA.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Address(M68k& cpu, u16 op, M68kAlu alu)
+{
+	int areg = (op >> 9) & 7;
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+	int size = (op & 0x0100) ? 4 : 2;
+
+	M68kEa ea;
+	if (!M68k_DecodeEa(cpu, mode, reg, size, ea))
+	{
+		return -1;
+	}
+
+	u32 s = SignExtend(M68k_ReadEa(cpu, ea, size), size);
+
+	switch (alu)
+	{
+		case kAluAdd: cpu.a[areg] += s; break;
+		case kAluSub: cpu.a[areg] -= s; break;
+		default:	  M68k_Sub(cpu, s, cpu.a[areg], 4, 0, false, true); return 6 + EaTime(mode, reg, size);
+	}
+
+	return ((size == 4) ? (IsRegisterOrImmediate(mode, reg) ? 8 : 6) : 8) + EaTime(mode, reg, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ADDX and SUBX, on data registers or predecremented memory.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Extend(M68k& cpu, u16 op, bool sub)
+{
+	int rx = (op >> 9) & 7;
+	int ry = op & 7;
+	int size = 1 << ((op >> 6) & 3);
+	u32 x = (cpu.ccr & kCcrX) ? 1 : 0;
+
+	if ((op & 0x0008) == 0)
+	{
+		u32 r = sub ? M68k_Sub(cpu, cpu.d[ry], cpu.d[rx], size, x, true, false) : M68k_Add(cpu, cpu.d[ry], cpu.d[rx], size, x, true);
+		M68k_SetD(cpu, rx, r, size);
+		return (size == 4) ? 8 : 4;
+	}
+
+	M68kEa src, dst;
+	M68k_DecodeEa(cpu, 4, ry, size, src);
+	u32 s = M68k_ReadEa(cpu, src, size);
+	M68k_DecodeEa(cpu, 4, rx, size, dst);
+	u32 d = M68k_ReadEa(cpu, dst, size);
+
+	u32 r = sub ? M68k_Sub(cpu, s, d, size, x, true, false) : M68k_Add(cpu, s, d, size, x, true);
+	M68k_WriteEa(cpu, dst, size, r);
+
+	return (size == 4) ? 30 : 18;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Groups 8 to D: OR, DIVx, SUB, CMP, EOR, AND, MULx, EXG and ADD.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Arithmetic(M68k& cpu, u16 op)
+{
+	int group = op >> 12;
+	int dreg = (op >> 9) & 7;
+	int opmode = (op >> 6) & 7;
+	int mode = (op >> 3) & 7;
+	int reg = op & 7;
+
+	if ((group == 0x8 || group == 0xc) && (opmode == 3 || opmode == 7))
+	{
+		M68kEa ea;
+		if (!M68k_DecodeEa(cpu, mode, reg, 2, ea))
+		{
+			return -1;
+		}
+
+		u32 s = M68k_ReadEa(cpu, ea, 2);
+		int eaTime = EaTime(mode, reg, 2);
+
+		if (group == 0xc)
+		{
+			u32 r;
+			int bits;
+
+			if (opmode == 3)
+			{
+				r = (cpu.d[dreg] & 0xffff) * s;
+				bits = __builtin_popcount(s);
+			}
+			else
+			{
+				r = (u32) ((s32) (s16) cpu.d[dreg] * (s32) (s16) s);
+				bits = __builtin_popcount(((s << 1) ^ s) & 0xffff);
+			}
+
+			cpu.d[dreg] = r;
+			M68k_Logic(cpu, r, 4);
+			return 38 + 2 * bits + eaTime;
+		}
+
+		if (s == 0)
+		{
+			M68k_Fault(cpu, "division by zero", cpu.opPc);
+			return -1;
+		}
+
+		u32 dividend = cpu.d[dreg];
+		int time;
+		int64_t quotient, remainder;
+
+		if (opmode == 3)
+		{
+			time = M68k_DivuTime(dividend, (u16) s);
+			quotient = dividend / s;
+			remainder = dividend % s;
+		}
+		else
+		{
+			time = M68k_DivsTime((s32) dividend, (s16) s);
+			quotient = (int64_t) (s32) dividend / (s16) s;
+			remainder = (int64_t) (s32) dividend % (s16) s;
+		}
+
+		bool overflow = (opmode == 3) ? quotient > 0xffff : (quotient < -32768 || quotient > 32767);
+
+		if (overflow)
+		{
+			cpu.ccr = (u8) ((cpu.ccr & (kCcrX | kCcrN | kCcrZ)) | kCcrV);
+		}
+		else
+		{
+			cpu.d[dreg] = ((u32) (u16) remainder << 16) | (u16) quotient;
+			M68k_Logic(cpu, (u32) quotient, 2);
+		}
+
+		return time + eaTime;
+	}
+
+	if (group == 0xc && (opmode == 5 || opmode == 6) && mode <= 1)
+	{
+		u32* x = ((op & 0x01f8) == 0x0148) ? &cpu.a[dreg] : &cpu.d[dreg];
+		u32* y = ((op & 0x01f8) == 0x0140) ? &cpu.d[reg] : &cpu.a[reg];
+		u32 t = *x;
+		*x = *y;
+		*y = t;
+		return 6;
+	}
+
+	if ((group == 0x8 || group == 0xc) && opmode == 4 && mode <= 1)
+	{
+		return M68k_Unsupported(cpu, op);	// SBCD, ABCD
+	}
+
+	if ((group == 0x9 || group == 0xd || group == 0xb) && (opmode == 3 || opmode == 7))
+	{
+		return M68k_Address(cpu, op, (group == 0x9) ? kAluSub : ((group == 0xd) ? kAluAdd : kAluCmp));
+	}
+
+	if ((group == 0x9 || group == 0xd) && opmode >= 4 && mode <= 1)
+	{
+		return M68k_Extend(cpu, op, group == 0x9);
+	}
+
+	if (group == 0xb)
+	{
+		if (opmode < 3)
+		{
+			return M68k_Alu(cpu, op, kAluCmp);
+		}
+
+		if (mode == 1)
+		{
+			int size = 1 << (opmode & 3);
+			M68kEa src, dst;
+			M68k_DecodeEa(cpu, 3, reg, size, src);
+			u32 s = M68k_ReadEa(cpu, src, size);
+			M68k_DecodeEa(cpu, 3, dreg, size, dst);
+			u32 d = M68k_ReadEa(cpu, dst, size);
+			M68k_Sub(cpu, s, d, size, 0, false, true);
+			return (size == 4) ? 20 : 12;
+		}
+
+		return M68k_Alu(cpu, op, kAluEor);
+	}
+
+	switch (group)
+	{
+		case 0x8: return M68k_Alu(cpu, op, kAluOr);
+		case 0x9: return M68k_Alu(cpu, op, kAluSub);
+		case 0xc: return M68k_Alu(cpu, op, kAluAnd);
+		default:  return M68k_Alu(cpu, op, kAluAdd);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Group14(M68k& cpu, u16 op)
+{
+	bool left = (op & 0x0100) != 0;
+
+	if (((op >> 6) & 3) == 3)
+	{
+		int mode = (op >> 3) & 7;
+		int reg = op & 7;
+
+		if ((op & 0x0800) != 0)
+		{
+			return M68k_Unsupported(cpu, op);
+		}
+
+		M68kEa ea;
+		if (!M68k_DecodeEa(cpu, mode, reg, 2, ea))
+		{
+			return -1;
+		}
+
+		u32 r = M68k_Shift(cpu, (op >> 9) & 3, left, M68k_ReadEa(cpu, ea, 2), 1, 2);
+		M68k_WriteEa(cpu, ea, 2, r);
+		return 8 + EaTime(mode, reg, 2);
+	}
+
+	int size = 1 << ((op >> 6) & 3);
+	int reg = op & 7;
+	int field = (op >> 9) & 7;
+	int count = (op & 0x0020) ? (int) (cpu.d[field] & 63) : (field ? field : 8);
+
+	u32 r = M68k_Shift(cpu, (op >> 3) & 3, left, cpu.d[reg], count, size);
+	M68k_SetD(cpu, reg, r, size);
+
+	return ((size == 4) ? 8 : 6) + 2 * count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Runs one instruction and returns its time from the tables.
+////////////////////////////////////////////////////////////////////////////////
+static int M68k_Execute(M68k& cpu, u16 op)
+{
+	switch (op >> 12)
+	{
+		case 0x0: return M68k_Group0(cpu, op);
+		case 0x1:
+		case 0x2:
+		case 0x3: return M68k_Move(cpu, op);
+		case 0x4: return M68k_Group4(cpu, op);
+		case 0x5: return M68k_Group5(cpu, op);
+		case 0x6: return M68k_Branch(cpu, op);
+
+		case 0x7:
+			if (op & 0x0100)
+			{
+				return M68k_Unsupported(cpu, op);
+			}
+			cpu.d[(op >> 9) & 7] = SignExtend(op, 1);
+			M68k_Logic(cpu, SignExtend(op, 1), 4);
+			return 4;
+
+		case 0xe: return M68k_Group14(cpu, op);
+		case 0xa:
+		case 0xf: return M68k_Unsupported(cpu, op);
+		default:  return M68k_Arithmetic(cpu, op);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void M68k_Reset(M68k& cpu)
+{
+	M68kDisplay display = cpu.display;
+
+	cpu = M68k();
+	cpu.display = display;
+	cpu.chip.assign(kM68kChipSize, 0);
+	cpu.fast.assign(kM68kFastSize, 0);
+	cpu.a[7] = kM68kFastBase + kM68kFastSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool M68k_Step(M68k& cpu)
+{
+	if (!cpu.error.empty())
+	{
+		return false;
+	}
+
+	cpu.opPc = cpu.pc;
+	cpu.opAccesses = 0;
+
+	u16 op = M68k_Fetch16(cpu);
+	int time = cpu.error.empty() ? M68k_Execute(cpu, op) : -1;
+
+	if (time < 0 || !cpu.error.empty())
+	{
+		return false;
+	}
+
+	u32 bus = cpu.opAccesses * 4;
+	if ((u32) time > bus)
+	{
+		cpu.cycles += (u32) time - bus;
+	}
+
+	cpu.instructions++;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool M68k_Call(M68k& cpu, u32 entry, const std::vector<u32>& args, u64 maxCycles, u32& result)
+{
+	u32 sp = cpu.a[7] - 4 * (u32) (args.size() + 1);
+	u8* stack = M68k_Memory(cpu, sp, 4 * (u32) (args.size() + 1));
+
+	if (stack == nullptr || (sp & 1))
+	{
+		cpu.error = "bad stack pointer";
+		return false;
+	}
+
+	PutBE32(stack, kM68kReturn);
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		PutBE32(stack + 4 + 4 * i, args[i]);
+	}
+
+	u32 saved[11];
+	for (int i = 0; i < 6; i++)
+	{
+		saved[i] = cpu.d[2 + i];
+	}
+	for (int i = 0; i < 5; i++)
+	{
+		saved[6 + i] = cpu.a[2 + i];
+	}
+
+	u32 caller = cpu.a[7];
+	cpu.a[7] = sp;
+	cpu.pc = entry;
+
+	u64 end = cpu.cycles + maxCycles;
+
+	while ((cpu.pc & 0xffffff) != kM68kReturn)
+	{
+		if (!M68k_Step(cpu))
+		{
+			return false;
+		}
+
+		if (cpu.cycles > end)
+		{
+			cpu.error = "no return within the cycle limit";
+			return false;
+		}
+	}
+
+	for (int i = 0; i < 11; i++)
+	{
+		if (saved[i] != ((i < 6) ? cpu.d[2 + i] : cpu.a[2 + i - 6]))
+		{
+			cpu.error = (i < 6) ? "d2-d7 not preserved" : "a2-a6 not preserved";
+			return false;
+		}
+	}
+
+	if (cpu.a[7] != sp + 4)
+	{
+		cpu.error = "stack pointer not restored";
+		return false;
+	}
+
+	cpu.a[7] = caller;
+	result = cpu.d[0];
+
+	return true;
+}
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// m68k.h
+//
+// 68000 interpreter for timing target code on the host. It runs user mode
+// code only: no interrupts, traps or supervisor state, and it stops with an
+// error on anything else, including an access outside RAM.
+//
+// Each instruction takes the time in the MC68000 user's manual tables, with
+// the data dependent MULU/MULS and DIVU/DIVS counts done exactly. On top of
+// that, every bus access to chip RAM waits for an even colour clock that the
+// bitplane DMA leaves free (see dmaslots.h). Accesses are taken to start
+// back to back from the start of the instruction, with its internal cycles
+// after them, so only the contention is approximate. The copper, blitter,
+// audio and sprites are not modelled.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "dmaslots.h"
+#include "types.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Memory map: 2 MB of chip RAM at 0, 8 MB of fast RAM above it and nothing
+// else. M68k_Call returns by jumping to kM68kReturn, in ROM space.
+////////////////////////////////////////////////////////////////////////////////
+static const u32 kM68kChipBase = 0x000000;
+static const u32 kM68kChipSize = 0x200000;
+static const u32 kM68kFastBase = 0x200000;
+static const u32 kM68kFastSize = 0x800000;
+static const u32 kM68kReturn   = 0xf80000;
+
+////////////////////////////////////////////////////////////////////////////////
+// CPU clocks per PAL line, two per colour clock, and lines per frame.
+////////////////////////////////////////////////////////////////////////////////
+static const int kM68kLineCycles  = kDmaLineCycles * 2;
+static const int kM68kFrameLines  = 313;
+
+////////////////////////////////////////////////////////////////////////////////
+// The display whose bitplanes take chip bus cycles: a lowres 320 pixel
+// window, ddfstrt/ddfstop as PackDdfstrt(0)/PackDdfstop(320), on lines
+// top to top + lines - 1. No planes, no contention.
+////////////////////////////////////////////////////////////////////////////////
+struct M68kDisplay
+{
+	DmaConfig dma = {0, false, 0x38, 0xd0, 0, 0, 0};
+	int top = 0x2c;
+	int lines = 256;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// a[7] is the stack pointer. cycles is the CPU clock since M68k_Reset, which
+// also places the beam: cycle 0 is the start of line 0. waits is the part of
+// it spent waiting for the chip bus.
+////////////////////////////////////////////////////////////////////////////////
+struct M68k
+{
+	u32 d[8] = {};
+	u32 a[8] = {};
+	u32 pc = 0;
+	u8 ccr = 0;
+
+	std::vector<u8> chip;
+	std::vector<u8> fast;
+	M68kDisplay display;
+
+	u64 cycles = 0;
+	u64 waits = 0;
+	u64 instructions = 0;
+	std::string error;
+
+	// The instruction being run.
+	u32 opPc = 0;
+	u32 opAccesses = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// M68k_Reset clears the registers, the clock and RAM. M68k_Step runs one
+// instruction and returns false once there has been an error. M68k_Call
+// calls a function with the gcc calling convention, long arguments on the
+// stack and the result in d0, and checks that it keeps d2-d7/a2-a6; it
+// fails after maxCycles.
+////////////////////////////////////////////////////////////////////////////////
+void M68k_Reset(M68k& cpu);
+bool M68k_Step(M68k& cpu);
+bool M68k_Call(M68k& cpu, u32 entry, const std::vector<u32>& args, u64 maxCycles, u32& result);
+
+////////////////////////////////////////////////////////////////////////////////
+// Host pointer to size bytes of RAM at address, or nullptr when they are not
+// all in one RAM block.
+////////////////////////////////////////////////////////////////////////////////
+u8* M68k_Memory(M68k& cpu, u32 address, u32 size);
+bool M68k_IsChip(u32 address);
@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////////
+// m68kbench.cpp
+//
+// Times the hot kernels on the host, without an emulator or a ROM, in the
+// 68000 interpreter of m68k.h. They come from obj/kernels.elf, the assembly
+// sources linked on their own by the top level Makefile:
+//
+//   make kernels
+//   make -C tools
+//   tools/bin/m68kbench -planes 6 obj/kernels.elf tools/m68kbench/baseline.txt
+//
+// prints cycles and raster lines per call for every bench in m68kkernels.h
+// and compares them with the baseline, failing if any got slower by more
+// than the tolerance. -update writes the new figures to the baseline, which
+// keeps one set per number of planes and kind of code RAM, so the baseline
+// changes along with a commit that means to change the timings. The
+// committed one has the HAM display's 6 planes with fast RAM, as above, and
+// without (-chip). A baseline that cannot be read or has nothing for the
+// options given fails. a.mingw.elf loads as well, but the baseline is for
+// obj/kernels.elf.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "m68kelf.h"
+#include "m68kkernels.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void PrintUsage()
+{
+	printf("usage: m68kbench [options] executable.elf [baseline.txt]\n");
+	printf("  -planes <n>     lowres bitplanes taking chip RAM cycles, 0-6 (default 0)\n");
+	printf("  -hires          hires bitplanes instead, 0-4\n");
+	printf("  -chip           no fast RAM: code, stack and all buffers in chip RAM\n");
+	printf("  -only <text>    only benches with text in their name\n");
+	printf("  -tolerance <n>  percent slower than the baseline that still passes (default 1)\n");
+	printf("  -update         write the results to the baseline instead of checking them\n");
+	printf("the baseline is for obj/kernels.elf (make kernels), with -planes 6 and -planes 6 -chip:\n");
+	printf("  tools/bin/m68kbench -planes 6 obj/kernels.elf tools/m68kbench/baseline.txt\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Baseline entries are lines of name, planes, code RAM and cycles per call,
+// keyed by the first three.
+////////////////////////////////////////////////////////////////////////////////
+static bool LoadBaseline(const std::string& path, std::map<std::string, double>& baseline)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	char line[512];
+	while (fgets(line, sizeof(line), file))
+	{
+		char name[256], code[16], planes[16];
+		double cycles;
+
+		if (line[0] != '#' && sscanf(line, "%255s %15s %15s %lf", name, planes, code, &cycles) == 4)
+		{
+			baseline[std::string(name) + " " + planes + " " + code] = cycles;
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+static bool SaveBaseline(const std::string& path, const std::map<std::string, double>& baseline)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "%s: cannot write\n", path.c_str());
+		return false;
+	}
+
+	fprintf(file, "# m68kbench baseline: bench, bitplanes, code RAM, 68000 cycles per call\n");
+
+	for (const auto& entry : baseline)
+	{
+		fprintf(file, "%s %.1f\n", entry.first.c_str(), entry.second);
+	}
+
+	fclose(file);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Whether the baseline has any bench for config, the planes and code RAM of
+// a key ("6 fast").
+////////////////////////////////////////////////////////////////////////////////
+static bool HasConfig(const std::map<std::string, double>& baseline, const std::string& config)
+{
+	const std::string suffix = " " + config;
+
+	for (const auto& entry : baseline)
+	{
+		const std::string& key = entry.first;
+
+		if (key.size() > suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+	M68k cpu;
+	M68kKernelsOptions options;
+	double tolerance = 1.0;
+	bool update = false;
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-planes") && i + 1 < argc)
+		{
+			cpu.display.dma.planes = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-hires"))
+		{
+			cpu.display.dma.hires = true;
+		}
+		else if (!strcmp(argv[i], "-chip"))
+		{
+			options.allChip = true;
+		}
+		else if (!strcmp(argv[i], "-only") && i + 1 < argc)
+		{
+			options.filter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-tolerance") && i + 1 < argc)
+		{
+			tolerance = atof(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-update"))
+		{
+			update = true;
+		}
+		else if (argv[i][0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else
+		{
+			paths.push_back(argv[i]);
+		}
+	}
+
+	int maxPlanes = cpu.display.dma.hires ? 4 : 6;
+	if (paths.empty() || paths.size() > 2 || cpu.display.dma.planes < 0 || cpu.display.dma.planes > maxPlanes)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// The kernels are timed as if they ran inside the display window all
+	// along: the worst case, and the same whatever a call's length.
+	cpu.display.top = 0;
+	cpu.display.lines = kM68kFrameLines;
+	M68k_Reset(cpu);
+
+	M68kImage image;
+	std::string error;
+
+	if (!M68kElf_Load(paths[0], options.allChip, cpu, image, error))
+	{
+		fprintf(stderr, "%s: %s\n", paths[0].c_str(), error.c_str());
+		return 1;
+	}
+
+	if (options.allChip)
+	{
+		cpu.a[7] = kM68kChipBase + kM68kChipSize;
+	}
+
+	// A baseline that is given must be there and cover this configuration,
+	// or every bench would pass as new. -update may start one.
+	std::map<std::string, double> baseline;
+	bool haveBaseline = paths.size() > 1 && LoadBaseline(paths[1], baseline);
+	std::string config = std::to_string(cpu.display.dma.planes) + (cpu.display.dma.hires ? "h" : "") + " " + (options.allChip ? "chip" : "fast");
+
+	if (paths.size() > 1 && !update)
+	{
+		if (!haveBaseline)
+		{
+			fprintf(stderr, "%s: cannot read the baseline\n", paths[1].c_str());
+			return 1;
+		}
+
+		if (!HasConfig(baseline, config))
+		{
+			fprintf(stderr, "%s: nothing for planes %s, code in %s RAM; run with -update to add it\n", paths[1].c_str(),
+				config.substr(0, config.find(' ')).c_str(), config.substr(config.find(' ') + 1).c_str());
+			return 1;
+		}
+	}
+
+	std::vector<M68kKernelResult> results;
+	bool ok = M68kKernels_Run(cpu, image, options, results);
+	int regressions = 0;
+
+	printf("%-26s %10s %8s %6s %10s %8s\n", "bench", "cycles", "lines", "waits", "baseline", "change");
+
+	for (const M68kKernelResult& result : results)
+	{
+		if (result.calls == 0)
+		{
+			printf("%-26s %s\n", result.name.c_str(), result.note.c_str());
+			continue;
+		}
+
+		double cycles = (double) result.cycles / result.calls;
+		std::string key = result.name + " " + config;
+		printf("%-26s %10.1f %8.2f %5.1f%%", result.name.c_str(), cycles, cycles / kM68kLineCycles, 100.0 * result.waits / result.cycles);
+
+		auto it = baseline.find(key);
+		if (it != baseline.end() && it->second > 0.0)
+		{
+			double change = 100.0 * (cycles - it->second) / it->second;
+			bool regression = change > tolerance;
+
+			printf(" %10.1f %+7.2f%%%s", it->second, change, regression ? "  SLOWER" : ((change < -tolerance) ? "  faster" : ""));
+
+			if (regression && !update)
+			{
+				regressions++;
+			}
+		}
+		else if (haveBaseline)
+		{
+			printf(" %10s %8s", "-", "new");
+		}
+
+		printf("%s%s\n", result.note.empty() ? "" : "  ", result.note.c_str());
+
+		if (update)
+		{
+			baseline[key] = cycles;
+		}
+	}
+
+	if (update)
+	{
+		if (paths.size() < 2 || !ok || !SaveBaseline(paths[1], baseline))
+		{
+			fprintf(stderr, "baseline not written\n");
+			return 1;
+		}
+
+		printf("updated %s\n", paths[1].c_str());
+	}
+	else if (regressions != 0)
+	{
+		printf("%d bench(es) slower than the baseline by more than %.1f%%\n", regressions, tolerance);
+	}
+
+	return (ok && regressions == 0) ? 0 : 1;
+}
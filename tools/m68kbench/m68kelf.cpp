@@ -0,0 +1,355 @@
+////////////////////////////////////////////////////////////////////////////////
+// m68kelf.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "m68kelf.h"
+#include <cxxabi.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "image.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u16 kElfObject	= 1;
+static const u16 kElfExec		= 2;
+static const u16 kElf68k		= 4;
+static const u32 kElfProgBits	= 1;
+static const u32 kElfSymTab		= 2;
+static const u32 kElfRela		= 4;
+static const u32 kElfNoBits		= 8;
+static const u32 kElfRel		= 9;
+static const u32 kElfAlloc		= 0x2;
+static const u16 kElfUndef		= 0;
+static const u16 kElfAbs		= 0xfff1;
+static const u32 kElfLoadAlign	= 4;
+
+// Where the first chip section goes, so that null pointers do not point
+// into the program.
+static const u32 kElfChipStart	= 0x1000;
+
+enum ElfReloc
+{
+	kReloc68kNone,
+	kReloc68k32,
+	kReloc68k16,
+	kReloc68k8,
+	kReloc68kPc32,
+	kReloc68kPc16,
+	kReloc68kPc8,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+struct ElfSection
+{
+	u32 name;
+	u32 type;
+	u32 flags;
+	u32 addr;
+	u32 offset;
+	u32 size;
+	u32 link;
+	u32 info;
+	u32 align;
+	u32 entSize;
+};
+
+struct ElfFile
+{
+	std::vector<u8> data;
+	std::vector<ElfSection> sections;
+	std::vector<u32> load;		// Section addresses in RAM, 0 if not loaded.
+	u16 names;					// The section of section names.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const char* Elf_String(const ElfFile& elf, u32 section, u32 offset)
+{
+	const ElfSection& strings = elf.sections[section];
+
+	return (offset < strings.size) ? (const char*) &elf.data[strings.offset + offset] : "";
+}
+
+static bool Elf_Inside(const ElfFile& elf, u32 offset, u32 size)
+{
+	return (offset <= elf.data.size() && size <= elf.data.size() - offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// A symbol's address in RAM, from the address of its section.
+////////////////////////////////////////////////////////////////////////////////
+static bool Elf_SymbolAddress(const ElfFile& elf, const u8* sym, u32& address)
+{
+	u32 value = GetBE32(sym + 4);
+	u16 shndx = GetBE16(sym + 14);
+
+	if (shndx == kElfAbs)
+	{
+		address = value;
+		return true;
+	}
+
+	if (shndx == kElfUndef || shndx >= elf.sections.size() || elf.load[shndx] == 0)
+	{
+		return false;
+	}
+
+	address = elf.load[shndx] + value - elf.sections[shndx].addr;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static bool Elf_Relocate(const ElfFile& elf, const ElfSection& rela, M68k& cpu, std::string& error)
+{
+	u32 target = rela.info;
+	if (target >= elf.sections.size() || elf.load[target] == 0)
+	{
+		return true;	// Debug information and the like.
+	}
+
+	const ElfSection& symtab = elf.sections[rela.link];
+	const ElfSection& section = elf.sections[target];
+
+	for (u32 i = 0; i + 12 <= rela.size; i += 12)
+	{
+		const u8* r = &elf.data[rela.offset + i];
+		u32 offset = GetBE32(r) - section.addr;
+		u32 symbol = GetBE32(r + 4) >> 8;
+		u32 type = GetBE32(r + 4) & 0xff;
+		u32 addend = GetBE32(r + 8);
+
+		if (type == kReloc68kNone)
+		{
+			continue;
+		}
+
+		u32 s = 0;
+		if (symbol != 0 && ((symbol + 1) * 16 > symtab.size || !Elf_SymbolAddress(elf, &elf.data[symtab.offset + symbol * 16], s)))
+		{
+			error = std::string("undefined symbol ") + Elf_String(elf, symtab.link, GetBE32(&elf.data[symtab.offset + symbol * 16]));
+			return false;
+		}
+
+		u32 p = elf.load[target] + offset;
+		u32 value = s + addend - ((type >= kReloc68kPc32) ? p : 0);
+		int size = (type == kReloc68k32 || type == kReloc68kPc32) ? 4 : ((type == kReloc68k16 || type == kReloc68kPc16) ? 2 : 1);
+		u8* dst = M68k_Memory(cpu, p, size);
+
+		if (type > kReloc68kPc8)
+		{
+			error = "unsupported relocation type " + std::to_string(type);
+			return false;
+		}
+
+		if (dst == nullptr || offset + size > section.size)
+		{
+			error = "relocation outside its section";
+			return false;
+		}
+
+		s32 signedValue = (s32) value;
+		bool pc = type >= kReloc68kPc32;
+
+		if ((size == 2 && (pc ? (signedValue < -0x8000 || signedValue > 0x7fff) : (value > 0xffff && signedValue < -0x8000))) ||
+			(size == 1 && (pc ? (signedValue < -0x80 || signedValue > 0x7f) : (value > 0xff && signedValue < -0x80))))
+		{
+			error = "relocation out of range in " + std::string(Elf_String(elf, elf.names, section.name));
+			return false;
+		}
+
+		switch (size)
+		{
+			case 4: PutBE32(dst, value); break;
+			case 2: PutBE16(dst, (u16) value); break;
+			default: dst[0] = (u8) value; break;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static void Elf_AddSymbol(M68kImage& image, const std::string& name, const M68kSymbol& symbol)
+{
+	auto it = image.symbols.find(name);
+
+	if (it == image.symbols.end() || (symbol.global && !it->second.global))
+	{
+		image.symbols[name] = symbol;
+	}
+}
+
+static void Elf_Symbols(const ElfFile& elf, M68kImage& image)
+{
+	for (const ElfSection& symtab : elf.sections)
+	{
+		if (symtab.type != kElfSymTab)
+		{
+			continue;
+		}
+
+		for (u32 i = 16; i + 16 <= symtab.size; i += 16)
+		{
+			const u8* sym = &elf.data[symtab.offset + i];
+			const char* name = Elf_String(elf, symtab.link, GetBE32(sym));
+			u8 type = sym[12] & 15;
+
+			M68kSymbol symbol;
+			symbol.size = GetBE32(sym + 8);
+			symbol.global = (sym[12] >> 4) != 0;
+
+			// Functions, data and plain assembler labels.
+			if (name[0] == 0 || type > 2 || (name[0] == '.' && name[1] == 'L') || !Elf_SymbolAddress(elf, sym, symbol.address))
+			{
+				continue;
+			}
+
+			Elf_AddSymbol(image, name, symbol);
+
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+
+			if (status == 0 && demangled != nullptr)
+			{
+				std::string plain = demangled;
+				Elf_AddSymbol(image, plain.substr(0, plain.find('(')), symbol);
+			}
+
+			free(demangled);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool M68kElf_Load(const std::string& path, bool allChip, M68k& cpu, M68kImage& image, std::string& error)
+{
+	ElfFile elf;
+	if (!File_Load(path, elf.data))
+	{
+		error = "cannot read the file";
+		return false;
+	}
+
+	const u8* header = elf.data.data();
+	if (elf.data.size() < 52 || header[0] != 0x7f || header[1] != 'E' || header[2] != 'L' || header[3] != 'F' || header[4] != 1 || header[5] != 2)
+	{
+		error = "not a 32 bit big endian ELF file";
+		return false;
+	}
+
+	u16 type = GetBE16(header + 16);
+	if (GetBE16(header + 18) != kElf68k || (type != kElfObject && type != kElfExec))
+	{
+		error = "not a 68000 executable or object";
+		return false;
+	}
+
+	u32 shoff = GetBE32(header + 32);
+	u16 shentsize = GetBE16(header + 46);
+	u16 shnum = GetBE16(header + 48);
+	u16 shstrndx = GetBE16(header + 50);
+
+	if (shentsize < 40 || !Elf_Inside(elf, shoff, (u32) shentsize * shnum) || shstrndx >= shnum)
+	{
+		error = "bad section headers";
+		return false;
+	}
+
+	elf.names = shstrndx;
+	elf.load.assign(shnum, 0);
+
+	for (int i = 0; i < shnum; i++)
+	{
+		const u8* sh = &elf.data[shoff + i * shentsize];
+		ElfSection section = {GetBE32(sh), GetBE32(sh + 4), GetBE32(sh + 8), GetBE32(sh + 12), GetBE32(sh + 16),
+			GetBE32(sh + 20), GetBE32(sh + 24), GetBE32(sh + 28), GetBE32(sh + 32), GetBE32(sh + 36)};
+
+		if (section.type != kElfNoBits && !Elf_Inside(elf, section.offset, section.size))
+		{
+			error = "section outside the file";
+			return false;
+		}
+
+		elf.sections.push_back(section);
+	}
+
+	// Place the sections.
+	u32 chip = kElfChipStart;
+	u32 fast = kM68kFastBase;
+
+	for (int i = 0; i < shnum; i++)
+	{
+		const ElfSection& section = elf.sections[i];
+
+		if (!(section.flags & kElfAlloc) || (section.type != kElfProgBits && section.type != kElfNoBits) || section.size == 0)
+		{
+			continue;
+		}
+
+		std::string name = Elf_String(elf, elf.names, section.name);
+		bool inChip = allChip || (name.size() >= 10 && name.compare(name.size() - 10, 10, ".MEMF_CHIP") == 0);
+		u32& next = inChip ? chip : fast;
+		u32 align = (section.align > kElfLoadAlign) ? section.align : kElfLoadAlign;
+
+		next = (next + align - 1) & ~(align - 1);
+		u8* dst = M68k_Memory(cpu, next, section.size);
+
+		if (dst == nullptr)
+		{
+			error = "no room for section " + name;
+			return false;
+		}
+
+		if (section.type == kElfProgBits)
+		{
+			memcpy(dst, &elf.data[section.offset], section.size);
+		}
+		else
+		{
+			memset(dst, 0, section.size);
+		}
+
+		elf.load[i] = next;
+		next += section.size;
+	}
+
+	for (const ElfSection& section : elf.sections)
+	{
+		if (section.type == kElfRel && section.info < shnum && elf.load[section.info] != 0)
+		{
+			error = "REL relocations are not supported, only RELA";
+			return false;
+		}
+
+		if (section.type == kElfRela && !Elf_Relocate(elf, section, cpu, error))
+		{
+			return false;
+		}
+	}
+
+	if (chip == kElfChipStart && fast == kM68kFastBase)
+	{
+		error = "nothing to load";
+		return false;
+	}
+
+	Elf_Symbols(elf, image);
+	image.chipEnd = chip;
+	image.fastEnd = fast;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+const M68kSymbol* M68kElf_Find(const M68kImage& image, const std::string& name)
+{
+	auto it = image.symbols.find(name);
+
+	return (it != image.symbols.end()) ? &it->second : nullptr;
+}
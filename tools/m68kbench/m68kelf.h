@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////
+// m68kelf.h
+//
+// Loads the linked executable, a.mingw.elf, into the interpreter's RAM the
+// way elf2hunk and the loader would: every allocated section on its own, in
+// chip RAM if its name ends in .MEMF_CHIP and in fast RAM otherwise, then
+// moved there by the relocations that --emit-relocs keeps. Relocatable
+// objects (.o) load the same way.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <map>
+#include <string>
+#include "m68k.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Symbols are found by their name and, for C++ functions, by their demangled
+// name without the parameters too. Free RAM starts at chipEnd and fastEnd.
+////////////////////////////////////////////////////////////////////////////////
+struct M68kSymbol
+{
+	u32 address = 0;
+	u32 size = 0;
+	bool global = false;
+};
+
+struct M68kImage
+{
+	std::map<std::string, M68kSymbol> symbols;
+	u32 chipEnd = 0;
+	u32 fastEnd = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// allChip puts every section in chip RAM, as on a machine without fast RAM.
+////////////////////////////////////////////////////////////////////////////////
+bool M68kElf_Load(const std::string& path, bool allChip, M68k& cpu, M68kImage& image, std::string& error);
+const M68kSymbol* M68kElf_Find(const M68kImage& image, const std::string& name);
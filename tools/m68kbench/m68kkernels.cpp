@@ -0,0 +1,698 @@
+////////////////////////////////////////////////////////////////////////////////
+// m68kkernels.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+#include "m68kkernels.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "animref.h"
+#include "c2pref.h"
+#include "hamrtref.h"
+#include "lzenc.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static const u64 kKernelMaxCycles	= 100000000;
+static const u32 kKernelAlign		= 8;
+
+////////////////////////////////////////////////////////////////////////////////
+// One bench being run. Its buffers go after the executable and are given
+// back when the next bench begins.
+////////////////////////////////////////////////////////////////////////////////
+struct Kernel
+{
+	M68k& cpu;
+	const M68kImage& image;
+	const M68kKernelsOptions& options;
+	std::vector<M68kKernelResult>& results;
+	u32 chip;
+	u32 fast;
+	u32 seed;
+	bool ok;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+static u32 Kernel_Random(Kernel& kernel)
+{
+	kernel.seed = kernel.seed * 1664525 + 1013904223;
+
+	return kernel.seed ^ (kernel.seed >> 16);
+}
+
+static u32 Kernel_Alloc(Kernel& kernel, bool fast, u32 size, u32 offset = 0)
+{
+	u32& next = (fast && !kernel.options.allChip) ? kernel.fast : kernel.chip;
+	u32 address = ((next + kKernelAlign - 1) & ~(kKernelAlign - 1)) + offset;
+
+	next = address + size;
+
+	return address;
+}
+
+static u8* Kernel_Host(Kernel& kernel, u32 address, u32 size)
+{
+	return M68k_Memory(kernel.cpu, address, size);
+}
+
+static void Kernel_Fill(Kernel& kernel, u8* p, u32 size)
+{
+	for (u32 i = 0; i < size; i++)
+	{
+		p[i] = (u8) Kernel_Random(kernel);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Starts a bench: returns the function's address, or 0 if it is filtered
+// out or not in the executable. The clock goes back to the start of line 0
+// so that every bench sees the beam the same way.
+////////////////////////////////////////////////////////////////////////////////
+static u32 Kernel_Begin(Kernel& kernel, const std::string& name, const char* function)
+{
+	if (name.find(kernel.options.filter) == std::string::npos)
+	{
+		return 0;
+	}
+
+	M68kKernelResult result;
+	result.name = name;
+
+	const M68kSymbol* symbol = M68kElf_Find(kernel.image, function);
+	if (symbol == nullptr)
+	{
+		result.note = std::string("skipped, no ") + function + " in the executable";
+		kernel.results.push_back(result);
+		return 0;
+	}
+
+	kernel.results.push_back(result);
+	kernel.chip = kernel.image.chipEnd;
+	kernel.fast = kernel.image.fastEnd;
+	kernel.seed = 1;
+	kernel.cpu.cycles = 0;
+	kernel.cpu.error.clear();
+
+	return symbol->address;
+}
+
+static bool Kernel_Call(Kernel& kernel, u32 entry, const std::vector<u32>& args, u32& value)
+{
+	M68kKernelResult& result = kernel.results.back();
+	u64 cycles = kernel.cpu.cycles;
+	u64 waits = kernel.cpu.waits;
+
+	if (!M68k_Call(kernel.cpu, entry, args, kKernelMaxCycles, value))
+	{
+		fprintf(stderr, "%s: %s\n", result.name.c_str(), kernel.cpu.error.c_str());
+		result.note = "crashed";
+		kernel.ok = false;
+		return false;
+	}
+
+	result.calls++;
+	result.cycles += kernel.cpu.cycles - cycles;
+	result.waits += kernel.cpu.waits - waits;
+
+	return true;
+}
+
+static void Kernel_Fail(Kernel& kernel, const char* what)
+{
+	M68kKernelResult& result = kernel.results.back();
+
+	fprintf(stderr, "%s: %s\n", result.name.c_str(), what);
+	result.note = "wrong result";
+	kernel.ok = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// memset, memcpy and memmove from gcc8_a_support.s, aligned, odd and with
+// source and destination of different parity, in both kinds of RAM.
+////////////////////////////////////////////////////////////////////////////////
+struct MemoryCase
+{
+	const char* name;
+	bool fast;
+	u32 size;
+	u32 dstOffset;
+	u32 srcOffset;
+};
+
+static const MemoryCase kMemoryCases[] =
+{
+	{"chip.64",			false, 64, 0, 0},
+	{"chip.4096",		false, 4096, 0, 0},
+	{"chip.4095.odd",	false, 4095, 1, 1},
+	{"chip.4096.mixed",	false, 4096, 0, 1},
+	{"fast.64",			true, 64, 0, 0},
+	{"fast.4096",		true, 4096, 0, 0},
+	{"fast.4095.odd",	true, 4095, 1, 1},
+	{"fast.4096.mixed",	true, 4096, 0, 1},
+};
+
+static const int kMemoryCalls = 8;
+
+static void Kernel_Memory(Kernel& kernel)
+{
+	for (const MemoryCase& test : kMemoryCases)
+	{
+		std::string name = std::string("memset.") + test.name;
+		u32 entry = Kernel_Begin(kernel, name, "memset");
+
+		if (entry != 0)
+		{
+			u32 dst = Kernel_Alloc(kernel, test.fast, test.size, test.dstOffset);
+			u8* host = Kernel_Host(kernel, dst, test.size);
+			u32 value = 0;
+
+			for (int i = 0; i < kMemoryCalls; i++)
+			{
+				if (!Kernel_Call(kernel, entry, {dst, (u32) (0x80 + i), test.size}, value))
+				{
+					break;
+				}
+
+				if (value != dst || (u32) std::count(host, host + test.size, (u8) (0x80 + i)) != test.size)
+				{
+					Kernel_Fail(kernel, "set the wrong bytes");
+					break;
+				}
+			}
+		}
+
+		for (int move = 0; move < 2; move++)
+		{
+			name = std::string(move ? "memmove." : "memcpy.") + test.name;
+			entry = Kernel_Begin(kernel, name, move ? "memmove" : "memcpy");
+
+			if (entry == 0)
+			{
+				continue;
+			}
+
+			u32 src = Kernel_Alloc(kernel, test.fast, test.size, test.srcOffset);
+			u32 dst = Kernel_Alloc(kernel, test.fast, test.size, test.dstOffset);
+			u8* hostSrc = Kernel_Host(kernel, src, test.size);
+			u8* hostDst = Kernel_Host(kernel, dst, test.size);
+			u32 value = 0;
+
+			for (int i = 0; i < kMemoryCalls; i++)
+			{
+				Kernel_Fill(kernel, hostSrc, test.size);
+				std::vector<u8> expected(hostSrc, hostSrc + test.size);
+
+				if (!Kernel_Call(kernel, entry, {dst, src, test.size}, value))
+				{
+					break;
+				}
+
+				if (value != dst || memcmp(hostDst, expected.data(), test.size) != 0)
+				{
+					Kernel_Fail(kernel, "copied the wrong bytes");
+					break;
+				}
+			}
+		}
+	}
+
+	// memmove over itself, both ways.
+	for (int backward = 0; backward < 2; backward++)
+	{
+		const u32 kSize = 4096;
+		const u32 kShift = 6;
+		std::string name = std::string("memmove.overlap.") + (backward ? "up" : "down");
+		u32 entry = Kernel_Begin(kernel, name, "memmove");
+
+		if (entry == 0)
+		{
+			continue;
+		}
+
+		u32 buffer = Kernel_Alloc(kernel, true, kSize + kShift);
+		u8* host = Kernel_Host(kernel, buffer, kSize + kShift);
+		u32 src = backward ? buffer : buffer + kShift;
+		u32 dst = backward ? buffer + kShift : buffer;
+		u32 value = 0;
+
+		for (int i = 0; i < kMemoryCalls; i++)
+		{
+			Kernel_Fill(kernel, host, kSize + kShift);
+			std::vector<u8> expected(host, host + kSize + kShift);
+			memmove(&expected[dst - buffer], &expected[src - buffer], kSize);
+
+			if (!Kernel_Call(kernel, entry, {dst, src, kSize}, value))
+			{
+				break;
+			}
+
+			if (memcmp(host, expected.data(), kSize + kShift) != 0)
+			{
+				Kernel_Fail(kernel, "moved the wrong bytes");
+				break;
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The libgcc replacements in gcc8_a_support.s on random operands, a third
+// of them with a 16 bit second operand and a third with an 8 bit one.
+////////////////////////////////////////////////////////////////////////////////
+enum ArithmeticKind
+{
+	kMul,
+	kUdiv,
+	kDiv,
+	kMod,
+	kUmod,
+};
+
+static const int kArithmeticCalls = 300;
+
+static void Kernel_Arithmetic(Kernel& kernel)
+{
+	static const char* const kFunctions[] = {"__mulsi3", "__udivsi3", "__divsi3", "__modsi3", "__umodsi3"};
+
+	for (int kind = kMul; kind <= kUmod; kind++)
+	{
+		u32 entry = Kernel_Begin(kernel, kFunctions[kind], kFunctions[kind]);
+		if (entry == 0)
+		{
+			continue;
+		}
+
+		for (int i = 0; i < kArithmeticCalls; i++)
+		{
+			u32 a = Kernel_Random(kernel);
+			u32 b = Kernel_Random(kernel) >> ((i % 3) * 8);
+
+			if (kind != kMul && i % 2)
+			{
+				a >>= 12;
+			}
+
+			if (b == 0 || (kind != kMul && kind != kUdiv && kind != kUmod && b == 0xffffffff))
+			{
+				b = 3;
+			}
+
+			u32 expected = 0;
+			switch (kind)
+			{
+				case kMul:	expected = a * b; break;
+				case kUdiv:	expected = a / b; break;
+				case kUmod:	expected = a % b; break;
+				case kDiv:	expected = (u32) ((s32) a / (s32) b); break;
+				case kMod:	expected = (u32) ((s32) a % (s32) b); break;
+			}
+
+			u32 value = 0;
+			if (!Kernel_Call(kernel, entry, {a, b}, value))
+			{
+				break;
+			}
+
+			if (value != expected)
+			{
+				Kernel_Fail(kernel, "wrong result");
+				break;
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lz_Decode unpacking 16 KB of bitplane-like data in one go, from fast RAM,
+// where INCBIN data ends up, to chip RAM. The cycles without the waits must
+// be what LzEnc_Model says.
+////////////////////////////////////////////////////////////////////////////////
+static void Kernel_Lz(Kernel& kernel)
+{
+	const u32 kSize = 16 * 1024;
+	u32 entry = Kernel_Begin(kernel, "Lz_Decode.16k", "Lz_Decode");
+
+	if (entry == 0)
+	{
+		return;
+	}
+
+	// Rows of 40 bytes: runs, repeats of earlier rows and noise.
+	std::vector<u8> data(kSize);
+	for (u32 i = 0; i < kSize; i++)
+	{
+		u32 r = Kernel_Random(kernel);
+		switch ((i / 40) % 4)
+		{
+			case 0:  data[i] = (u8) ((i / 40) * 3 + (i % 40) / 8); break;
+			case 1:  data[i] = data[i - 40] ^ (((r & 0xff) < 8) ? (u8) (r >> 8) : 0); break;
+			case 2:  data[i] = (u8) ((i % 40 < 20) ? r : data[i - 80]); break;
+			default: data[i] = data[i - 120]; break;
+		}
+	}
+
+	std::vector<u8> packed;
+	LzEnc_Pack(data, LzEncOptions(), packed);
+
+	u32 src = Kernel_Alloc(kernel, true, (u32) packed.size());
+	u32 dst = Kernel_Alloc(kernel, false, kSize + kLzMaxSequence);
+	u32 stream = Kernel_Alloc(kernel, true, 12);
+	u8* hostStream = Kernel_Host(kernel, stream, 12);
+
+	memcpy(Kernel_Host(kernel, src, (u32) packed.size()), packed.data(), packed.size());
+	PutBE32(hostStream, src + kLzHeaderSize);
+	PutBE32(hostStream + 4, dst);
+	PutBE32(hostStream + 8, dst + kSize);
+
+	u32 value = 0;
+	if (!Kernel_Call(kernel, entry, {stream, dst + kSize}, value))
+	{
+		return;
+	}
+
+	if (memcmp(Kernel_Host(kernel, dst, kSize), data.data(), kSize) != 0 || GetBE32(hostStream + 4) != dst + kSize)
+	{
+		Kernel_Fail(kernel, "unpacked the wrong bytes");
+		return;
+	}
+
+	LzModel model;
+	M68kKernelResult& result = kernel.results.back();
+
+	if (LzEnc_Model(packed, src, dst, model) && model.cycles != result.cycles - result.waits)
+	{
+		result.note = "lzenc models " + std::to_string(model.cycles) + " cycles";
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Anim_Apply on a 320x256 frame of 6 planes, with one area redrawn and
+// another filled, so the delta has all three kinds of op.
+////////////////////////////////////////////////////////////////////////////////
+static bool Kernel_AnimDelta(const std::vector<u8>& from, const std::vector<u8>& to, int planes, u32 planeSize, u32 rowBytes, std::vector<u8>& delta)
+{
+	std::vector<u8> ops;
+	std::vector<u8> words;
+	u32 rows = planeSize / rowBytes;
+	u16 mask = 0;
+
+	for (int p = 0; p < planes; p++)
+	{
+		if (memcmp(&from[p * planeSize], &to[p * planeSize], planeSize) == 0)
+		{
+			continue;
+		}
+
+		mask |= (u16) (1 << p);
+
+		for (u32 column = 0; column < rowBytes / 2; column++)
+		{
+			auto word = [&](const std::vector<u8>& frame, u32 row) { return GetBE16(&frame[p * planeSize + row * rowBytes + column * 2]); };
+			auto changed = [&](u32 row) { return word(from, row) != word(to, row); };
+
+			size_t countAt = ops.size();
+			u32 count = 0;
+			u32 row = 0;
+			ops.push_back(0);
+
+			while (row < rows)
+			{
+				u32 n = 1;
+
+				if (!changed(row))
+				{
+					while (row + n < rows && n < kAnimMaxSkip && !changed(row + n))
+					{
+						n++;
+					}
+
+					if (row + n < rows)
+					{
+						ops.push_back((u8) n);
+						count++;
+					}
+				}
+				else
+				{
+					while (row + n < rows && n < kAnimMaxSame && word(to, row + n) == word(to, row))
+					{
+						n++;
+					}
+
+					bool same = (n >= 3);
+					if (same)
+					{
+						ops.push_back(0);
+						ops.push_back((u8) n);
+					}
+					else
+					{
+						n = 1;
+						while (row + n < rows && n < kAnimMaxUniq && changed(row + n))
+						{
+							n++;
+						}
+
+						ops.push_back((u8) (0x80 | n));
+					}
+
+					for (u32 i = 0; i < (same ? 1 : n); i++)
+					{
+						words.push_back((u8) (word(to, row + i) >> 8));
+						words.push_back((u8) word(to, row + i));
+					}
+					count++;
+				}
+
+				row += n;
+			}
+
+			if (count > kAnimMaxOps)
+			{
+				return false;
+			}
+
+			ops[countAt] = (u8) count;
+		}
+	}
+
+	if (ops.size() & 1)
+	{
+		ops.push_back(0);
+	}
+
+	delta.assign(kAnimDeltaHeader, 0);
+	delta.insert(delta.end(), ops.begin(), ops.end());
+	delta.insert(delta.end(), words.begin(), words.end());
+	PutBE32(&delta[0], (u32) delta.size());
+	PutBE16(&delta[4], (u16) ops.size());
+	PutBE16(&delta[6], mask);
+
+	return true;
+}
+
+static void Kernel_Anim(Kernel& kernel)
+{
+	const int kPlanes = 6;
+	const u32 kRowBytes = 40;
+	const u32 kPlaneSize = kRowBytes * 256;
+	const u32 kSize = kPlaneSize * kPlanes;
+
+	u32 entry = Kernel_Begin(kernel, "Anim_Apply.320x256x6", "Anim_Apply");
+	if (entry == 0)
+	{
+		return;
+	}
+
+	std::vector<u8> from(kSize);
+	Kernel_Fill(kernel, from.data(), kSize);
+
+	std::vector<u8> to = from;
+	for (int p = 0; p < kPlanes; p++)
+	{
+		for (u32 y = 0; y < 256; y++)
+		{
+			u8* row = &to[p * kPlaneSize + y * kRowBytes];
+
+			if (y >= 40 && y < 120)
+			{
+				for (u32 x = 4; x < 16; x++)
+				{
+					row[x] ^= (u8) (Kernel_Random(kernel) | 1);
+				}
+			}
+
+			if (y >= 150 && y < 230)
+			{
+				memset(row + 20, (p & 1) ? 0xff : 0x00, 12);
+			}
+		}
+	}
+
+	std::vector<u8> delta;
+	if (!Kernel_AnimDelta(from, to, kPlanes, kPlaneSize, kRowBytes, delta))
+	{
+		Kernel_Fail(kernel, "too many ops in a column");
+		return;
+	}
+
+	std::vector<u8> expected = from;
+	Anim_ReferenceApply(delta.data(), expected.data(), kPlaneSize, kRowBytes);
+
+	u32 hostDelta = Kernel_Alloc(kernel, true, (u32) delta.size());
+	u32 planes = Kernel_Alloc(kernel, false, kSize);
+	u8* hostPlanes = Kernel_Host(kernel, planes, kSize);
+
+	memcpy(Kernel_Host(kernel, hostDelta, (u32) delta.size()), delta.data(), delta.size());
+	memcpy(hostPlanes, from.data(), kSize);
+
+	u32 value = 0;
+	if (!Kernel_Call(kernel, entry, {hostDelta, planes, kPlaneSize, kRowBytes}, value))
+	{
+		return;
+	}
+
+	if (expected != to || memcmp(hostPlanes, expected.data(), kSize) != 0)
+	{
+		Kernel_Fail(kernel, "drew the wrong frame");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The CPU chunky to planar conversions on 320x64 pixels, from fast RAM to
+// chip RAM as in the C2P mode of ham.cpp.
+////////////////////////////////////////////////////////////////////////////////
+static void Kernel_C2p(Kernel& kernel)
+{
+	const u32 kPixels = 320 * 64;
+	const u32 kPlaneSize = kPixels / 8;
+
+	for (int depth = 6; depth >= 5; depth--)
+	{
+		std::string function = "C2p_Cpu" + std::to_string(depth);
+		u32 entry = Kernel_Begin(kernel, function + ".320x64", function.c_str());
+
+		if (entry == 0)
+		{
+			continue;
+		}
+
+		u32 chunky = Kernel_Alloc(kernel, true, kPixels);
+		u32 planes = Kernel_Alloc(kernel, false, kPlaneSize * depth);
+		u8* hostChunky = Kernel_Host(kernel, chunky, kPixels);
+
+		for (u32 i = 0; i < kPixels; i++)
+		{
+			hostChunky[i] = (u8) (Kernel_Random(kernel) & ((1 << depth) - 1));
+		}
+
+		std::vector<u8> expected(kPlaneSize * depth);
+		C2p_Reference(hostChunky, expected.data(), kPlaneSize, depth, kPixels);
+
+		u32 value = 0;
+		if (!Kernel_Call(kernel, entry, {chunky, planes, kPlaneSize, kPixels / 16}, value))
+		{
+			continue;
+		}
+
+		if (memcmp(Kernel_Host(kernel, planes, kPlaneSize * depth), expected.data(), expected.size()) != 0)
+		{
+			Kernel_Fail(kernel, "wrong planes");
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The real-time HAM6 conversion of 64 lines of 160 pixels, the band of the
+// HAMRT mode of ham.cpp, at both pixel widths: smooth hues with a little
+// noise, so that setting and modifying all happen. From and to fast RAM, the
+// tables included.
+////////////////////////////////////////////////////////////////////////////////
+static void Kernel_HamRt(Kernel& kernel)
+{
+	const int kWidth = 160;
+	const int kLines = 64;
+	static const unsigned short kPalette[kHamRtPaletteSize] = {
+		0x000, 0x222, 0x444, 0x666, 0x888, 0xaaa, 0xccc, 0xfff, 0xf00, 0xfa0, 0x8f0, 0x0f0, 0x0cf, 0x04f, 0x80f, 0xf08,
+	};
+
+	static HamRtTables tables;
+	HamRt_ReferenceTables(tables, kPalette);
+
+	for (int pixelWidth = 1; pixelWidth <= 2; pixelWidth++)
+	{
+		std::string function = "HamRt_Line" + std::to_string(pixelWidth);
+		u32 entry = Kernel_Begin(kernel, function + ".160x64", function.c_str());
+
+		if (entry == 0)
+		{
+			continue;
+		}
+
+		const u32 codesSize = kWidth * kLines * pixelWidth;
+		u32 rgb = Kernel_Alloc(kernel, true, kWidth * kLines * 2);
+		u32 codes = Kernel_Alloc(kernel, true, codesSize);
+		u32 target = Kernel_Alloc(kernel, true, sizeof(HamRtTables));
+
+		std::vector<u16> pixels(kWidth * kLines);
+		for (int y = 0; y < kLines; y++)
+		{
+			for (int x = 0; x < kWidth; x++)
+			{
+				int r = (x + y) * 15 / (kWidth + kLines);
+				int g = abs(((x * 2 + y * 3) & 31) - 16) * 15 / 16;
+				int b = (y * 15 / kLines) ^ (int) (Kernel_Random(kernel) & 1);
+
+				pixels[y * kWidth + x] = (u16) ((r << 8) | (g << 4) | b);
+				PutBE16(Kernel_Host(kernel, rgb + (y * kWidth + x) * 2, 2), pixels[y * kWidth + x]);
+			}
+		}
+
+		const short* words = &tables.hold[0][0];
+		for (u32 i = 0; i < sizeof(HamRtTables) / 2; i++)
+		{
+			PutBE16(Kernel_Host(kernel, target + i * 2, 2), (u16) words[i]);
+		}
+
+		std::vector<u8> expected(codesSize);
+		HamRt_Reference(tables, pixels.data(), expected.data(), kWidth, kLines, pixelWidth, 1);
+
+		for (int y = 0; y < kLines; y++)
+		{
+			u32 value = 0;
+			if (!Kernel_Call(kernel, entry, {rgb + y * kWidth * 2, codes + y * kWidth * pixelWidth, kWidth, target, target}, value))
+			{
+				break;
+			}
+		}
+
+		if (memcmp(Kernel_Host(kernel, codes, codesSize), expected.data(), codesSize) != 0)
+		{
+			Kernel_Fail(kernel, "wrong codes");
+			continue;
+		}
+
+		M68kKernelResult& result = kernel.results.back();
+		if (result.calls != 0)
+		{
+			result.note = std::to_string((result.cycles + result.calls * kWidth / 2) / (result.calls * kWidth)) + " cycles a pixel";
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+bool M68kKernels_Run(M68k& cpu, const M68kImage& image, const M68kKernelsOptions& options, std::vector<M68kKernelResult>& results)
+{
+	Kernel kernel = {cpu, image, options, results, image.chipEnd, image.fastEnd, 1, true};
+
+	Kernel_Memory(kernel);
+	Kernel_Arithmetic(kernel);
+	Kernel_Lz(kernel);
+	Kernel_Anim(kernel);
+	Kernel_C2p(kernel);
+	Kernel_HamRt(kernel);
+
+	return kernel.ok;
+}
@@ -0,0 +1,40 @@
+////////////////////////////////////////////////////////////////////////////////
+// m68kkernels.h
+//
+// The kernels m68kbench times. Each bench puts its input in the
+// interpreter's RAM, calls a function of the executable, checks what came
+// out against a host-side reference and adds up the cycles from the first
+// instruction to the rts. Functions the executable does not have are
+// skipped: under LTO the C++ ones may well have been inlined.
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "m68kelf.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Buffers named fast go in fast RAM unless allChip. calls is 0 for a bench
+// that was skipped; note says why, or anything else worth knowing.
+////////////////////////////////////////////////////////////////////////////////
+struct M68kKernelsOptions
+{
+	bool allChip = false;
+	std::string filter;		// Only benches whose name contains this.
+};
+
+struct M68kKernelResult
+{
+	std::string name;
+	u32 calls = 0;
+	u64 cycles = 0;
+	u64 waits = 0;
+	std::string note;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Returns false if a kernel crashed or gave a wrong result; the rest are
+// still run.
+////////////////////////////////////////////////////////////////////////////////
+bool M68kKernels_Run(M68k& cpu, const M68kImage& image, const M68kKernelsOptions& options, std::vector<M68kKernelResult>& results);